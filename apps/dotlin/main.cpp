@@ -1,11 +1,18 @@
+#include "dotlin/benchmark.h"
 #include "dotlin/interpreter.h"
 #include "dotlin/lexer.h"
 #include "dotlin/parser.h"
+#include "dotlin/trace.h"
 // #include <filesystem>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
 std::string readFile(const std::string &filepath) {
   std::ifstream file(filepath);
   if (!file.is_open()) {
@@ -24,12 +31,71 @@ bool hasExtension(const std::string &filename, const std::string &ext) {
   return std::equal(ext.rbegin(), ext.rend(), filename.rbegin());
 }
 
+// Wall time of each phase and the peak resident set size, on stderr so it
+// never mixes with the program's output
+void printPhaseTimes(const std::vector<dotlin::PhaseTime> &phases) {
+  std::fprintf(stderr, "phase times:\n");
+  for (const auto &phase : phases) {
+    std::fprintf(stderr, "  %-20s %10.3f ms\n", phase.name.c_str(),
+                 static_cast<double>(phase.nanoseconds) / 1e6);
+  }
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    // ru_maxrss is in kilobytes on Linux and bytes on macOS
+#ifdef __APPLE__
+    long peakKb = usage.ru_maxrss / 1024;
+#else
+    long peakKb = usage.ru_maxrss;
+#endif
+    std::fprintf(stderr, "  %-20s %10ld KB\n", "peak RSS", peakKb);
+  }
+#endif
+}
+
 int main(int argc, char *argv[]) {
   std::string source;
   std::string filepath = "source.lin";
+  auto level = dotlin::OptimizationLevel::O2;
+  bool timePhases = false;
 
-  if (argc > 1) {
-    filepath = argv[1];
+  // Interpreter options come before the file; anything after it is passed
+  // to the program
+  int argIndex = 1;
+  for (; argIndex < argc && argv[argIndex][0] == '-'; ++argIndex) {
+    std::string option = argv[argIndex];
+    if (option == "-O0") {
+      level = dotlin::OptimizationLevel::O0;
+    } else if (option == "-O1") {
+      level = dotlin::OptimizationLevel::O1;
+    } else if (option == "-O2") {
+      level = dotlin::OptimizationLevel::O2;
+    } else if (option == "--time-phases") {
+      timePhases = true;
+    } else if (option.rfind("--log=", 0) == 0) {
+      if (!dotlin::kTracingCompiledIn) {
+        std::cerr << "Warning: --log is ignored; this build has no trace "
+                     "sites (configure with -DDOTLIN_ENABLE_TRACING=ON)"
+                  << std::endl;
+        continue;
+      }
+      try {
+        dotlin::configureTracing(option.substr(6));
+      } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+      }
+    } else {
+      std::cerr << "Error: unknown option " << option << std::endl;
+      std::cerr << "Usage: dotlin [-O0|-O1|-O2] [--time-phases] "
+                   "[--log=CATEGORY[:LEVEL],...] file.lin [args...]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  if (argIndex < argc) {
+    filepath = argv[argIndex++];
 
     // Check if the file has .lin extension
     if (!hasExtension(filepath, ".lin")) {
@@ -48,27 +114,43 @@ int main(int argc, char *argv[]) {
     source = "val x = 42\nprintln(x)"; // Sample Kotlin-like syntax
   }
 
+  std::vector<dotlin::PhaseTime> phases;
+  dotlin::Interpreter interpreter;
+  interpreter.setOptimizationLevel(level);
+  int status = 0;
   try {
+    int64_t start = dotlin::nanoTime();
     auto tokens = dotlin::tokenize(source);
+    int64_t lexed = dotlin::nanoTime();
+    phases.push_back({"lex", lexed - start});
     auto program = dotlin::parse(tokens);
+    phases.push_back({"parse", dotlin::nanoTime() - lexed});
 
-    // Extract command-line arguments (excluding program name and input file)
+    // Extract command-line arguments (excluding options and input file)
     std::vector<std::string> cmdArgs;
-    for (int i = 2; i < argc; ++i) {
+    for (int i = argIndex; i < argc; ++i) {
       cmdArgs.push_back(argv[i]);
     }
 
     // Pass command-line arguments to the interpreter
-    auto result = dotlin::interpret(program, cmdArgs, filepath);
+    auto result = interpreter.interpret(program, cmdArgs, filepath);
+    interpreter.flushOutput();
     std::cout << "Execution result: " << std::endl;
     // Note: result printing depends on the Value variant implementation
   } catch (const dotlin::DotlinError &e) {
+    interpreter.flushOutput();
     std::cerr << e.fullMessage() << std::endl;
-    return 1;
+    status = 1;
   } catch (const std::exception &e) {
+    interpreter.flushOutput();
     std::cerr << "Runtime error: " << e.what() << std::endl;
-    return 1;
+    status = 1;
   }
 
-  return 0;
-}
\ No newline at end of file
+  if (timePhases) {
+    const auto &interpreted = interpreter.getPhaseTimes();
+    phases.insert(phases.end(), interpreted.begin(), interpreted.end());
+    printPhaseTimes(phases);
+  }
+  return status;
+}
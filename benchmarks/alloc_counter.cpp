@@ -0,0 +1,51 @@
+#include "alloc_counter.h"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace dotlin::bench {
+std::atomic<uint64_t> allocationCount{0};
+std::atomic<uint64_t> allocatedBytes{0};
+} // namespace dotlin::bench
+
+// Every heap allocation in the process goes through these
+namespace {
+
+void *countedAlloc(size_t size, size_t alignment) {
+  dotlin::bench::allocationCount.fetch_add(1, std::memory_order_relaxed);
+  dotlin::bench::allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  void *block = alignment <= alignof(std::max_align_t)
+                    ? std::malloc(size ? size : 1)
+                    : std::aligned_alloc(alignment, (size + alignment - 1) /
+                                                        alignment * alignment);
+  if (!block) {
+    throw std::bad_alloc();
+  }
+  return block;
+}
+} // namespace
+
+void *operator new(size_t size) { return countedAlloc(size, 0); }
+void *operator new[](size_t size) { return countedAlloc(size, 0); }
+void *operator new(size_t size, std::align_val_t alignment) {
+  return countedAlloc(size, static_cast<size_t>(alignment));
+}
+void *operator new[](size_t size, std::align_val_t alignment) {
+  return countedAlloc(size, static_cast<size_t>(alignment));
+}
+void operator delete(void *block) noexcept { std::free(block); }
+void operator delete[](void *block) noexcept { std::free(block); }
+void operator delete(void *block, size_t) noexcept { std::free(block); }
+void operator delete[](void *block, size_t) noexcept { std::free(block); }
+void operator delete(void *block, std::align_val_t) noexcept {
+  std::free(block);
+}
+void operator delete[](void *block, std::align_val_t) noexcept {
+  std::free(block);
+}
+void operator delete(void *block, size_t, std::align_val_t) noexcept {
+  std::free(block);
+}
+void operator delete[](void *block, size_t, std::align_val_t) noexcept {
+  std::free(block);
+}
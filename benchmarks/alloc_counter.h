@@ -0,0 +1,28 @@
+// Heap allocation counting for the benchmark executables. Linking
+// alloc_counter.cpp replaces the global operator new and delete, so every
+// allocation in the process is counted.
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace dotlin::bench {
+
+extern std::atomic<uint64_t> allocationCount;
+extern std::atomic<uint64_t> allocatedBytes;
+
+struct AllocationTotals {
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+};
+
+inline AllocationTotals allocationTotals() {
+  return {allocationCount.load(std::memory_order_relaxed),
+          allocatedBytes.load(std::memory_order_relaxed)};
+}
+
+inline void resetAllocationTotals() {
+  allocationCount = 0;
+  allocatedBytes = 0;
+}
+
+} // namespace dotlin::bench
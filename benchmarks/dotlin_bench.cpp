@@ -0,0 +1,449 @@
+// Runs the .lin workloads in benchmarks/workloads and records, for each,
+// wall time, heap allocations and peak RSS. Every run happens in a forked
+// child so the RSS and allocation counts belong to that workload alone.
+// Where a workload has a .py twin it is also run with python3 as a
+// reference (its wall time includes Python's start-up).
+//
+// Usage:
+//   dotlin_bench [--runs N] [--filter NAME] [--json FILE] [--no-python]
+//                [--workloads DIR]
+//   dotlin_bench --compare BASE.json NEW.json [--threshold PERCENT]
+//
+// --compare lists the change in median wall time and allocations between
+// two --json files and exits with 1 when any workload got slower by more
+// than the threshold (default 5%).
+#include "alloc_counter.h"
+#include "dotlin/collections.h"
+#include "dotlin/interpreter.h"
+#include "dotlin/json.h"
+#include "dotlin/lexer.h"
+#include "dotlin/parser.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using namespace dotlin;
+
+namespace {
+
+struct Options {
+  int runs = 5;
+  std::string filter;
+  std::string jsonPath;
+  bool python = true;
+  std::string workloads = DOTLIN_BENCH_WORKLOADS;
+};
+
+// What a child reports back through its pipe
+struct ChildReport {
+  bool ok = false;
+  int64_t wallNs = 0;
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+  char error[256] = {};
+};
+
+struct Result {
+  std::string name;
+  bool ok = true;
+  std::string error;
+  std::vector<double> wallMs;
+  uint64_t allocations = 0;
+  uint64_t allocatedBytes = 0;
+  long peakRssKb = 0;
+  bool hasPython = false;
+  std::vector<double> pythonMs;
+  long pythonRssKb = 0;
+};
+
+double median(std::vector<double> values) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  std::sort(values.begin(), values.end());
+  size_t n = values.size();
+  return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+double minimum(const std::vector<double> &values) {
+  return values.empty() ? 0.0 : *std::min_element(values.begin(), values.end());
+}
+
+std::string readText(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("cannot open " + path);
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  return buffer.str();
+}
+
+// Runs in the forked child: scripts write into a scratch directory and
+// their output is discarded
+void enterChild(const std::string &scratch) {
+  if (chdir(scratch.c_str()) != 0) {
+    _exit(126);
+  }
+  int devNull = open("/dev/null", O_WRONLY);
+  if (devNull >= 0) {
+    dup2(devNull, STDOUT_FILENO);
+    close(devNull);
+  }
+}
+
+ChildReport interpretFile(const std::string &path) {
+  ChildReport report;
+  try {
+    std::string source = readText(path);
+    bench::resetAllocationTotals();
+    auto start = std::chrono::steady_clock::now();
+    auto tokens = tokenize(source);
+    auto program = parse(tokens);
+    Interpreter interpreter;
+    interpreter.interpret(program, {}, fs::path(path).filename().string());
+    interpreter.flushOutput();
+    report.wallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    bench::AllocationTotals totals = bench::allocationTotals();
+    report.allocations = totals.allocations;
+    report.bytes = totals.bytes;
+    report.ok = true;
+  } catch (const DotlinError &e) {
+    std::snprintf(report.error, sizeof report.error, "%s",
+                  e.fullMessage().c_str());
+  } catch (const std::exception &e) {
+    std::snprintf(report.error, sizeof report.error, "%s", e.what());
+  }
+  return report;
+}
+
+// One interpreted run of a workload in a child process; false on failure
+bool runDotlin(const std::string &path, const std::string &scratch,
+               Result &result) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    throw std::runtime_error("pipe() failed");
+  }
+  std::fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0) {
+    throw std::runtime_error("fork() failed");
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    enterChild(scratch);
+    ChildReport report = interpretFile(path);
+    ssize_t written = write(fds[1], &report, sizeof report);
+    _exit(written == static_cast<ssize_t>(sizeof report) ? 0 : 1);
+  }
+  close(fds[1]);
+  ChildReport report;
+  ssize_t got = read(fds[0], &report, sizeof report);
+  close(fds[0]);
+  int status = 0;
+  rusage usage{};
+  wait4(pid, &status, 0, &usage);
+  if (got != static_cast<ssize_t>(sizeof report) || !report.ok) {
+    result.ok = false;
+    result.error = got == static_cast<ssize_t>(sizeof report)
+                       ? report.error
+                       : "the child process died";
+    return false;
+  }
+  result.wallMs.push_back(static_cast<double>(report.wallNs) / 1e6);
+  result.allocations = report.allocations;
+  result.allocatedBytes = report.bytes;
+  result.peakRssKb = std::max(result.peakRssKb, usage.ru_maxrss);
+  return true;
+}
+
+// One python3 run of the twin; false when python3 is missing or fails
+bool runPython(const std::string &path, const std::string &scratch,
+               Result &result) {
+  std::fflush(stdout);
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid < 0) {
+    throw std::runtime_error("fork() failed");
+  }
+  if (pid == 0) {
+    enterChild(scratch);
+    execlp("python3", "python3", path.c_str(), static_cast<char *>(nullptr));
+    _exit(127);
+  }
+  int status = 0;
+  rusage usage{};
+  wait4(pid, &status, 0, &usage);
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return false;
+  }
+  result.pythonMs.push_back(ms);
+  result.pythonRssKb = std::max(result.pythonRssKb, usage.ru_maxrss);
+  return true;
+}
+
+std::string jsonString(const std::string &text) {
+  return toJson(Value(text));
+}
+
+std::string toJsonReport(const std::vector<Result> &results, int runs) {
+  std::string out = "{\n  \"runs\": " + std::to_string(runs) +
+                    ",\n  \"workloads\": [";
+  char number[64];
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    out += i ? ",\n    {" : "\n    {";
+    out += "\"name\": " + jsonString(r.name) +
+           ", \"ok\": " + (r.ok ? "true" : "false");
+    if (!r.ok) {
+      out += ", \"error\": " + jsonString(r.error) + "}";
+      continue;
+    }
+    std::snprintf(number, sizeof number, "%.3f", median(r.wallMs));
+    out += ", \"medianMs\": " + std::string(number);
+    std::snprintf(number, sizeof number, "%.3f", minimum(r.wallMs));
+    out += ", \"minMs\": " + std::string(number);
+    out += ", \"allocations\": " + std::to_string(r.allocations) +
+           ", \"allocatedBytes\": " + std::to_string(r.allocatedBytes) +
+           ", \"peakRssKb\": " + std::to_string(r.peakRssKb);
+    if (r.hasPython) {
+      std::snprintf(number, sizeof number, "%.3f", median(r.pythonMs));
+      out += ", \"python\": {\"medianMs\": " + std::string(number) +
+             ", \"peakRssKb\": " + std::to_string(r.pythonRssKb) + "}";
+    }
+    out += "}";
+  }
+  return out + "\n  ]\n}\n";
+}
+
+void printResult(const Result &r) {
+  if (!r.ok) {
+    std::printf("%-16s FAILED: %s\n", r.name.c_str(), r.error.c_str());
+    return;
+  }
+  std::printf("%-16s %10.1f %10.1f %12llu %9.1f", r.name.c_str(),
+              median(r.wallMs), minimum(r.wallMs),
+              static_cast<unsigned long long>(r.allocations),
+              static_cast<double>(r.peakRssKb) / 1024.0);
+  if (r.hasPython) {
+    std::printf(" %10.1f %7.2fx", median(r.pythonMs),
+                median(r.wallMs) / median(r.pythonMs));
+  }
+  std::printf("\n");
+  std::fflush(stdout);
+}
+
+int runSuite(const Options &options) {
+  std::vector<fs::path> scripts;
+  for (const auto &entry : fs::directory_iterator(options.workloads)) {
+    if (entry.path().extension() == ".lin" &&
+        entry.path().stem().string().find(options.filter) !=
+            std::string::npos) {
+      scripts.push_back(entry.path());
+    }
+  }
+  std::sort(scripts.begin(), scripts.end());
+  if (scripts.empty()) {
+    std::fprintf(stderr, "No workloads in %s\n", options.workloads.c_str());
+    return 1;
+  }
+
+  char scratchTemplate[] = "/tmp/dotlin_bench.XXXXXX";
+  if (!mkdtemp(scratchTemplate)) {
+    std::fprintf(stderr, "Cannot create a scratch directory\n");
+    return 1;
+  }
+  std::string scratch = scratchTemplate;
+
+  std::printf("%-16s %10s %10s %12s %9s %10s %8s\n", "workload", "median ms",
+              "min ms", "allocations", "peak MiB", "python ms", "ratio");
+  std::vector<Result> results;
+  bool failed = false;
+  for (const fs::path &script : scripts) {
+    Result result;
+    result.name = script.stem().string();
+    for (int run = 0; run < options.runs; ++run) {
+      if (!runDotlin(script.string(), scratch, result)) {
+        break;
+      }
+    }
+    fs::path twin = fs::path(script).replace_extension(".py");
+    if (result.ok && options.python && fs::exists(twin)) {
+      result.hasPython = true;
+      for (int run = 0; run < options.runs; ++run) {
+        if (!runPython(twin.string(), scratch, result)) {
+          result.hasPython = false;
+          break;
+        }
+      }
+    }
+    failed = failed || !result.ok;
+    printResult(result);
+    results.push_back(std::move(result));
+  }
+  fs::remove_all(scratch);
+
+  if (!options.jsonPath.empty()) {
+    std::ofstream out(options.jsonPath);
+    out << toJsonReport(results, options.runs);
+    if (!out) {
+      std::fprintf(stderr, "Cannot write %s\n", options.jsonPath.c_str());
+      return 1;
+    }
+  }
+  return failed ? 1 : 0;
+}
+
+// Workload name -> its entry in a --json report
+std::vector<std::pair<std::string, Value>> loadReport(const std::string &path) {
+  Value report = parseJson(readText(path));
+  auto *map = std::get_if<std::shared_ptr<MapValue>>(&report);
+  if (!map) {
+    throw std::runtime_error(path + " is not a dotlin_bench report");
+  }
+  Value workloads = mapGet(**map, Value(std::string("workloads")));
+  auto *array = std::get_if<ArrayValue>(&workloads);
+  if (!array) {
+    throw std::runtime_error(path + " is not a dotlin_bench report");
+  }
+  std::vector<std::pair<std::string, Value>> out;
+  for (size_t i = 0; i < array->size(); ++i) {
+    Value entry = array->at(i);
+    auto *fields = std::get_if<std::shared_ptr<MapValue>>(&entry);
+    if (!fields) {
+      continue;
+    }
+    Value name = mapGet(**fields, Value(std::string("name")));
+    if (auto *text = std::get_if<std::string>(&name)) {
+      out.emplace_back(*text, entry);
+    }
+  }
+  return out;
+}
+
+// A numeric field of a report entry, or -1 when it is missing
+double field(const Value &entry, const char *name) {
+  const auto &map = std::get<std::shared_ptr<MapValue>>(entry);
+  Value value = mapGet(*map, Value(std::string(name)));
+  if (auto *d = std::get_if<double>(&value)) {
+    return *d;
+  }
+  if (auto *i = std::get_if<int>(&value)) {
+    return *i;
+  }
+  if (auto *l = std::get_if<int64_t>(&value)) {
+    return static_cast<double>(*l);
+  }
+  return -1.0;
+}
+
+int compareReports(const std::string &basePath, const std::string &newPath,
+                   double thresholdPercent) {
+  auto base = loadReport(basePath);
+  auto next = loadReport(newPath);
+  double limit = thresholdPercent / 100.0;
+  int regressions = 0;
+  std::printf("%-16s %10s %10s %8s %14s  (threshold %.1f%%)\n", "workload",
+              "base ms", "new ms", "change", "allocations", thresholdPercent);
+  for (const auto &[name, entry] : next) {
+    auto match = std::find_if(base.begin(), base.end(),
+                              [&](const auto &b) { return b.first == name; });
+    double newMs = field(entry, "medianMs");
+    if (match == base.end() || newMs < 0 ||
+        field(match->second, "medianMs") < 0) {
+      std::printf("%-16s %10s %10s\n", name.c_str(), "-", "-");
+      continue;
+    }
+    double baseMs = field(match->second, "medianMs");
+    double change = baseMs > 0 ? newMs / baseMs - 1.0 : 0.0;
+    double baseAllocs = field(match->second, "allocations");
+    double newAllocs = field(entry, "allocations");
+    double allocChange = baseAllocs > 0 ? newAllocs / baseAllocs - 1.0 : 0.0;
+    const char *verdict = "";
+    if (change > limit) {
+      verdict = "  REGRESSION";
+      ++regressions;
+    } else if (change < -limit) {
+      verdict = "  faster";
+    }
+    std::printf("%-16s %10.1f %10.1f %+7.1f%% %+13.1f%%%s\n", name.c_str(),
+                baseMs, newMs, change * 100.0, allocChange * 100.0, verdict);
+  }
+  if (regressions > 0) {
+    std::printf("%d workload%s slower than the threshold\n", regressions,
+                regressions == 1 ? "" : "s");
+    return 1;
+  }
+  return 0;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "Usage: dotlin_bench [--runs N] [--filter NAME] [--json FILE]\n"
+               "                    [--no-python] [--workloads DIR]\n"
+               "       dotlin_bench --compare BASE.json NEW.json "
+               "[--threshold PERCENT]\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  std::vector<std::string> compare;
+  double threshold = 5.0;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      auto value = [&]() -> std::string {
+        if (i + 1 >= argc) {
+          throw std::runtime_error(arg + " expects a value");
+        }
+        return argv[++i];
+      };
+      if (arg == "--runs") {
+        options.runs = std::max(1, std::stoi(value()));
+      } else if (arg == "--filter") {
+        options.filter = value();
+      } else if (arg == "--json") {
+        options.jsonPath = value();
+      } else if (arg == "--no-python") {
+        options.python = false;
+      } else if (arg == "--workloads") {
+        options.workloads = value();
+      } else if (arg == "--compare") {
+        compare.push_back(value());
+        compare.push_back(value());
+      } else if (arg == "--threshold") {
+        threshold = std::stod(value());
+      } else {
+        usage();
+        return 2;
+      }
+    }
+    if (!compare.empty()) {
+      return compareReports(compare[0], compare[1], threshold);
+    }
+    return runSuite(options);
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "dotlin_bench: %s\n", e.what());
+    return 2;
+  }
+}
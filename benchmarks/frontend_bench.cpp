@@ -0,0 +1,425 @@
+// Cost of each front-end stage on generated programs of four shapes:
+// many small functions, deeply nested control flow, long arithmetic
+// expressions and large string templates. For every shape it times
+// tokenize, parse and the passes interpret() runs before execution (type
+// inference, constant folding, resolution, dead code elimination) and
+// reports throughput (tokens/s for the lexer, AST nodes/s for the rest)
+// and the heap bytes each stage allocates.
+//
+// Usage:
+//   dotlin_frontend_bench [--shape NAME] [--size BYTES] [--depth N]
+//                         [--terms N] [--runs N]
+//
+// --size is the source size per shape (default 256 KiB), --depth the
+// nesting depth of the nesting shape (default 48) and --terms the operand
+// count of each generated expression (default 64). Each stage reports its
+// fastest of --runs runs (default 5).
+#include "alloc_counter.h"
+#include "dotlin/interpreter.h"
+#include "dotlin/lexer.h"
+#include "dotlin/parser.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace dotlin;
+
+namespace {
+
+struct Options {
+  std::string shape;
+  size_t size = 256 * 1024;
+  int depth = 48;
+  int terms = 64;
+  int runs = 5;
+};
+
+// Counts every node reachable from the statements it is given
+class NodeCounter : public AstVisitor {
+public:
+  size_t count(const Program &program) {
+    nodes = 0;
+    for (const auto &stmt : program.statements) {
+      walk(stmt);
+    }
+    return nodes;
+  }
+
+  void visit(LiteralExpr &) override { ++nodes; }
+  void visit(StringInterpolationExpr &node) override {
+    ++nodes;
+    for (auto &part : node.parts) {
+      walk(part);
+    }
+  }
+  void visit(IdentifierExpr &) override { ++nodes; }
+  void visit(BinaryExpr &node) override {
+    ++nodes;
+    walk(node.left);
+    walk(node.right);
+  }
+  void visit(UnaryExpr &node) override {
+    ++nodes;
+    walk(node.operand);
+  }
+  void visit(CallExpr &node) override {
+    ++nodes;
+    walk(node.callee);
+    for (auto &argument : node.arguments) {
+      walk(argument);
+    }
+  }
+  void visit(MemberAccessExpr &node) override {
+    ++nodes;
+    walk(node.object);
+  }
+  void visit(ArrayAccessExpr &node) override {
+    ++nodes;
+    walk(node.array);
+    walk(node.index);
+  }
+  void visit(ExpressionStmt &node) override {
+    ++nodes;
+    walk(node.expression);
+  }
+  void visit(VariableDeclStmt &node) override {
+    ++nodes;
+    if (node.initializer) {
+      walk(*node.initializer);
+    }
+  }
+  void visit(FunctionDeclStmt &node) override {
+    ++nodes;
+    walk(node.body);
+  }
+  void visit(BlockStmt &node) override {
+    ++nodes;
+    for (auto &stmt : node.statements) {
+      walk(stmt);
+    }
+  }
+  void visit(ReturnStmt &node) override {
+    ++nodes;
+    walk(node.value);
+  }
+  void visit(ArrayLiteralExpr &node) override {
+    ++nodes;
+    for (auto &element : node.elements) {
+      walk(element);
+    }
+  }
+  void visit(LambdaExpr &node) override {
+    ++nodes;
+    walk(node.body);
+  }
+  void visit(IfStmt &node) override {
+    ++nodes;
+    walk(node.condition);
+    walk(node.thenBranch);
+    if (node.elseBranch) {
+      walk(*node.elseBranch);
+    }
+  }
+  void visit(WhileStmt &node) override {
+    ++nodes;
+    walk(node.condition);
+    walk(node.body);
+  }
+  void visit(ForStmt &node) override {
+    ++nodes;
+    walk(node.iterable);
+    walk(node.body);
+  }
+  void visit(WhenStmt &node) override {
+    ++nodes;
+    walk(node.subject);
+    for (auto &branch : node.branches) {
+      walk(branch.first);
+      walk(branch.second);
+    }
+    if (node.elseBranch) {
+      walk(*node.elseBranch);
+    }
+  }
+  void visit(TryStmt &node) override {
+    ++nodes;
+    walk(node.tryBlock);
+    walk(node.catchBlock);
+    if (node.finallyBlock) {
+      walk(*node.finallyBlock);
+    }
+  }
+  void visit(ConstructorDeclStmt &node) override {
+    ++nodes;
+    walk(node.body);
+  }
+  void visit(ClassDeclStmt &node) override {
+    ++nodes;
+    for (auto &member : node.members) {
+      walk(member);
+    }
+  }
+  void visit(ExtensionFunctionDeclStmt &node) override {
+    ++nodes;
+    walk(node.body);
+  }
+
+private:
+  template <typename Ptr> void walk(const Ptr &node) {
+    if (node) {
+      node->accept(*this);
+    }
+  }
+
+  size_t nodes = 0;
+};
+
+// An operand mix the constant folder can only partly fold
+std::string expression(int terms, const std::string &a, const std::string &b) {
+  static const char *ops[] = {" + ", " * ", " - ", " % ", " + ", " / "};
+  std::string out = a;
+  for (int i = 1; i < terms; ++i) {
+    out += ops[i % 6];
+    switch (i % 4) {
+    case 0:
+      out.append("(").append(b).append(" + ").append(std::to_string(i));
+      out += ')';
+      break;
+    case 1:
+      out += std::to_string(i % 9 + 1);
+      break;
+    case 2:
+      out += b;
+      break;
+    default:
+      out.append("(").append(std::to_string(i)).append(" * 2)");
+    }
+  }
+  return out;
+}
+
+// Small functions, each calling the one before it
+std::string manyFunctions(const Options &options) {
+  std::string out = "fun f0(a: Int, b: Int): Int {\n    return a + b\n}\n";
+  for (int i = 1; out.size() < options.size; ++i) {
+    std::string n = std::to_string(i);
+    out += "fun f" + n + "(a: Int, b: Int): Int {\n"
+           "    val c = a * 2 + b\n"
+           "    var d = c - " + n + "\n"
+           "    if (d > 10) {\n"
+           "        d = d - a\n"
+           "    } else {\n"
+           "        d = d + b\n"
+           "    }\n"
+           "    while (d > 100) {\n"
+           "        d = d / 2\n"
+           "    }\n"
+           "    return d + f" + std::to_string(i - 1) + "(a, 1)\n"
+           "}\n";
+  }
+  return out;
+}
+
+// Functions whose bodies nest if and while statements --depth deep
+std::string deepNesting(const Options &options) {
+  std::string out;
+  for (int i = 0; out.size() < options.size; ++i) {
+    out += "fun nest" + std::to_string(i) + "(x: Int): Int {\n"
+           "    var y = x\n";
+    std::string indent = "    ";
+    for (int level = 0; level < options.depth; ++level) {
+      out += indent + (level % 2 ? "while (y < " : "if (y > ") +
+             std::to_string(level) + ") {\n";
+      indent += "    ";
+      out += indent + "y = y + " + std::to_string(level + 1) + "\n";
+    }
+    for (int level = options.depth; level > 0; --level) {
+      indent.resize(indent.size() - 4);
+      out += indent + "}\n";
+    }
+    out += "    return y\n}\n";
+  }
+  return out;
+}
+
+// "e12"; built by appending since GCC 12 reports a false -Wrestrict for
+// "e" + std::to_string(12) once inlined
+std::string name(char prefix, int index) {
+  std::string out(1, prefix);
+  out += std::to_string(index);
+  return out;
+}
+
+// Top-level values initialised by --terms operand expressions
+std::string longExpressions(const Options &options) {
+  std::string out = "val e0 = 1\n";
+  for (int i = 1; out.size() < options.size; ++i) {
+    out += "val e" + std::to_string(i) + " = ";
+    out += expression(options.terms, name('e', i - 1), name('e', i / 2));
+    out += '\n';
+  }
+  return out;
+}
+
+// String templates of --terms parts mixing $name and ${expression}
+std::string bigTemplates(const Options &options) {
+  std::string out = "val name = \"dotlin\"\nval count = 3\n";
+  for (int i = 0; out.size() < options.size; ++i) {
+    out += "val t" + std::to_string(i) + " = \"";
+    for (int part = 0; part < options.terms; ++part) {
+      switch (part % 3) {
+      case 0:
+        out += "row " + std::to_string(part) + " of $name, ";
+        break;
+      case 1:
+        out += "${count * " + std::to_string(part) + " + 1} items, ";
+        break;
+      default:
+        out += "${name.length} chars; ";
+      }
+    }
+    out += "\"\n";
+  }
+  return out;
+}
+
+struct Shape {
+  const char *name;
+  std::function<std::string(const Options &)> generate;
+};
+
+struct Stage {
+  Stage(const char *stageName) : name(stageName) {}
+
+  const char *name;
+  int64_t bestNs = INT64_MAX;
+  size_t units = 0; // tokens for the lexer, AST nodes otherwise
+  bench::AllocationTotals allocated;
+};
+
+template <typename Run> void measure(Stage &stage, size_t units, Run run) {
+  bench::resetAllocationTotals();
+  auto start = std::chrono::steady_clock::now();
+  run();
+  int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+  bench::AllocationTotals allocated = bench::allocationTotals();
+  if (ns < stage.bestNs) {
+    stage.bestNs = ns;
+    stage.allocated = allocated;
+  }
+  stage.units = units;
+}
+
+std::string rate(double perSecond, const char *unit) {
+  char text[48];
+  if (perSecond >= 1e6) {
+    std::snprintf(text, sizeof text, "%.2f M%s/s", perSecond / 1e6, unit);
+  } else {
+    std::snprintf(text, sizeof text, "%.2f k%s/s", perSecond / 1e3, unit);
+  }
+  return text;
+}
+
+void runShape(const Shape &shape, const Options &options) {
+  std::string source = shape.generate(options);
+  std::vector<Stage> stages = {{"tokenize"},         {"parse"},
+                               {"typeInference"},    {"constantFolding"},
+                               {"resolution"},       {"deadCodeElimination"}};
+  NodeCounter counter;
+  size_t tokenCount = 0;
+  size_t parsedNodes = 0;
+  for (int run = 0; run < options.runs; ++run) {
+    // The passes rewrite the tree, so every run starts from fresh tokens
+    std::vector<Token> tokens;
+    measure(stages[0], 0, [&] { tokens = tokenize(source); });
+    tokenCount = tokens.size();
+    stages[0].units = tokenCount;
+
+    Program program;
+    measure(stages[1], 0, [&] { program = parse(tokens); });
+    parsedNodes = counter.count(program);
+    stages[1].units = parsedNodes;
+
+    Interpreter interpreter;
+    measure(stages[2], parsedNodes,
+            [&] { interpreter.performTypeInference(program); });
+    measure(stages[3], parsedNodes,
+            [&] { interpreter.performConstantFolding(program); });
+    size_t folded = counter.count(program);
+    measure(stages[4], folded,
+            [&] { interpreter.performResolution(program); });
+    measure(stages[5], folded,
+            [&] { interpreter.performDeadCodeElimination(program); });
+  }
+
+  std::printf("%s: %zu bytes, %zu tokens, %zu nodes\n", shape.name,
+              source.size(), tokenCount, parsedNodes);
+  for (const Stage &stage : stages) {
+    double seconds = static_cast<double>(stage.bestNs) / 1e9;
+    double perSecond =
+        seconds > 0 ? static_cast<double>(stage.units) / seconds : 0.0;
+    std::printf("  %-20s %9.3f ms %18s %10llu allocs %10.2f MB\n", stage.name,
+                seconds * 1e3,
+                rate(perSecond, &stage == &stages[0] ? "tokens" : "nodes")
+                    .c_str(),
+                static_cast<unsigned long long>(stage.allocated.allocations),
+                static_cast<double>(stage.allocated.bytes) / 1e6);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+      return 2;
+    }
+    const char *value = argv[++i];
+    if (arg == "--shape") {
+      options.shape = value;
+    } else if (arg == "--size") {
+      options.size = std::strtoull(value, nullptr, 10);
+    } else if (arg == "--depth") {
+      options.depth = std::atoi(value);
+    } else if (arg == "--terms") {
+      options.terms = std::max(1, std::atoi(value));
+    } else if (arg == "--runs") {
+      options.runs = std::max(1, std::atoi(value));
+    } else {
+      std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+      return 2;
+    }
+  }
+
+  std::vector<Shape> shapes = {{"functions", manyFunctions},
+                               {"nesting", deepNesting},
+                               {"expressions", longExpressions},
+                               {"templates", bigTemplates}};
+  bool matched = false;
+  for (const Shape &shape : shapes) {
+    if (!options.shape.empty() && options.shape != shape.name) {
+      continue;
+    }
+    matched = true;
+    try {
+      runShape(shape, options);
+    } catch (const std::exception &e) {
+      std::fprintf(stderr, "%s: %s\n", shape.name, e.what());
+      return 1;
+    }
+  }
+  if (!matched) {
+    std::fprintf(stderr, "unknown shape %s\n", options.shape.c_str());
+    return 2;
+  }
+  return 0;
+}
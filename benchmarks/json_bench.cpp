@@ -0,0 +1,139 @@
+// Throughput of parseJson and toJson on three generated corpora shaped like
+// the usual JSON benchmark files: tweets (string heavy), coordinates
+// (number heavy) and event listings (nested objects of small integers).
+//
+// Usage: dotlin_json_bench [bytes-per-corpus]   (default 16 MiB)
+#include "dotlin/json.h"
+#include "dotlin/string_kernels.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace dotlin;
+
+namespace {
+
+volatile size_t sink;
+
+// GB/s for `bytes` per run, repeating until 200 ms have passed
+double measure(size_t bytes, const std::function<size_t()> &run) {
+  using Clock = std::chrono::steady_clock;
+  size_t runs = 0;
+  auto start = Clock::now();
+  std::chrono::duration<double> elapsed{};
+  do {
+    sink = run();
+    ++runs;
+    elapsed = Clock::now() - start;
+  } while (elapsed.count() < 0.2);
+  return static_cast<double>(bytes) * static_cast<double>(runs) /
+         elapsed.count() / 1e9;
+}
+
+std::string tweets(size_t bytes, std::mt19937 &rng) {
+  static const char *words[] = {"json",   "parser", "fast",  "\\\"quoted\\\"",
+                                "\\u00e9", "simd",   "index", "stream"};
+  std::string out = "{\"statuses\":[";
+  for (int id = 0; out.size() < bytes; ++id) {
+    if (id > 0) {
+      out += ',';
+    }
+    out += "{\"id\":" + std::to_string(rng()) + ",\"text\":\"";
+    for (unsigned w = 0; w < 12 + rng() % 12; ++w) {
+      out += words[rng() % 8];
+      out += ' ';
+    }
+    out += "\",\"user\":{\"name\":\"user" + std::to_string(id) +
+           "\",\"followers\":" + std::to_string(rng() % 100000) +
+           ",\"verified\":" + (rng() % 2 ? "true" : "false") +
+           "},\"retweeted\":false,\"reply_to\":null}";
+  }
+  return out + "]}";
+}
+
+std::string coordinates(size_t bytes, std::mt19937 &rng) {
+  std::uniform_real_distribution<double> degrees(-180.0, 180.0);
+  std::string out = "{\"type\":\"Polygon\",\"coordinates\":[";
+  char number[64];
+  for (int i = 0; out.size() < bytes; ++i) {
+    std::snprintf(number, sizeof number, "%s[%.15g,%.15g]", i ? "," : "",
+                  degrees(rng), degrees(rng) / 2);
+    out += number;
+  }
+  return out + "]}";
+}
+
+std::string events(size_t bytes, std::mt19937 &rng) {
+  std::string out = "{\"events\":{";
+  for (int id = 0; out.size() < bytes; ++id) {
+    if (id > 0) {
+      out += ',';
+    }
+    out += '"';
+    out += std::to_string(100000 + id) + "\":{\"id\":" +
+           std::to_string(id) + ",\"name\":null,\"subTopicIds\":[" +
+           std::to_string(rng() % 1000) + "," + std::to_string(rng() % 1000) +
+           "],\"topicIds\":[" + std::to_string(rng() % 100) +
+           "],\"prices\":[{\"amount\":" + std::to_string(rng() % 100000) +
+           ",\"seatCategoryId\":" + std::to_string(rng() % 500) + "}]}";
+  }
+  return out + "}}";
+}
+
+std::vector<StringKernelLevel> levels() {
+  std::vector<StringKernelLevel> out{StringKernelLevel::Scalar};
+  if (bestStringKernelLevel() >= StringKernelLevel::SSE2) {
+    out.push_back(StringKernelLevel::SSE2);
+  }
+  if (bestStringKernelLevel() >= StringKernelLevel::AVX2) {
+    out.push_back(StringKernelLevel::AVX2);
+  }
+  return out;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t bytes = size_t{16} << 20;
+  if (argc > 1) {
+    bytes = std::strtoull(argv[1], nullptr, 10);
+  }
+  std::mt19937 rng(42);
+  struct Corpus {
+    const char *name;
+    std::string text;
+  };
+  std::vector<Corpus> corpora = {{"tweets", tweets(bytes, rng)},
+                                 {"coordinates", coordinates(bytes, rng)},
+                                 {"events", events(bytes, rng)}};
+
+  std::printf("%-12s %-7s %9s %9s %9s  (GB/s)\n", "corpus", "level", "index",
+              "parse", "toJson");
+  for (const Corpus &corpus : corpora) {
+    Value parsed = parseJson(corpus.text);
+    std::string serialized = toJson(parsed);
+    for (StringKernelLevel level : levels()) {
+      setStringKernelLevel(level);
+      std::vector<uint32_t> index;
+      double indexRate = measure(corpus.text.size(), [&] {
+        indexJson(corpus.text, index);
+        return index.size();
+      });
+      double parseRate = measure(corpus.text.size(), [&] {
+        return parseJson(corpus.text).index();
+      });
+      double writeRate = measure(serialized.size(), [&] {
+        return toJson(parsed).size();
+      });
+      std::printf("%-12s %-7s %9.2f %9.2f %9.2f\n", corpus.name,
+                  stringKernelLevelName(level), indexRate, parseRate,
+                  writeRate);
+    }
+  }
+  setStringKernelLevel(bestStringKernelLevel());
+  return 0;
+}
@@ -0,0 +1,156 @@
+// Throughput of the string kernels at each instruction-set level against
+// the standard-library code the String methods used before.
+//
+// Usage: dotlin_string_bench [max-bytes]   (default 64 MiB; sizes start at
+// 1 KiB and grow 32x, so 1073741824 covers 1 KiB to 1 GiB)
+#include "dotlin/string_kernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace dotlin;
+
+namespace {
+
+// Keeps results alive so the measured work is not optimised away
+volatile size_t sink;
+
+// GB/s for `bytes` per run, repeating until 100 ms have passed
+double measure(size_t bytes, const std::function<size_t()> &run) {
+  using Clock = std::chrono::steady_clock;
+  size_t runs = 0;
+  auto start = Clock::now();
+  std::chrono::duration<double> elapsed{};
+  do {
+    sink = run();
+    ++runs;
+    elapsed = Clock::now() - start;
+  } while (elapsed.count() < 0.1);
+  return static_cast<double>(bytes) * static_cast<double>(runs) /
+         elapsed.count() / 1e9;
+}
+
+std::string sizeLabel(size_t bytes) {
+  if (bytes >= (size_t{1} << 30)) {
+    return std::to_string(bytes >> 30) + " GiB";
+  }
+  if (bytes >= (size_t{1} << 20)) {
+    return std::to_string(bytes >> 20) + " MiB";
+  }
+  return std::to_string(bytes >> 10) + " KiB";
+}
+
+// Mixed-case words separated by ", "
+std::string makeText(size_t bytes) {
+  static const char *words[] = {"Alpha", "beta", "GAMMA", "delta", "Epsilon"};
+  std::string text;
+  text.reserve(bytes + 16);
+  for (size_t i = 0; text.size() < bytes; ++i) {
+    text += words[i % 5];
+    text += ", ";
+  }
+  text.resize(bytes);
+  return text;
+}
+
+std::vector<StringKernelLevel> levels() {
+  std::vector<StringKernelLevel> out{StringKernelLevel::Scalar};
+  if (bestStringKernelLevel() >= StringKernelLevel::SSE2) {
+    out.push_back(StringKernelLevel::SSE2);
+  }
+  if (bestStringKernelLevel() >= StringKernelLevel::AVX2) {
+    out.push_back(StringKernelLevel::AVX2);
+  }
+  return out;
+}
+
+void report(const char *name, size_t bytes,
+            const std::function<size_t()> &baseline,
+            const std::function<size_t()> &kernel) {
+  std::printf("%-12s %8s  baseline %7.2f", name, sizeLabel(bytes).c_str(),
+              baseline ? measure(bytes, baseline) : 0.0);
+  for (StringKernelLevel level : levels()) {
+    setStringKernelLevel(level);
+    std::printf("  %s %7.2f", stringKernelLevelName(level),
+                measure(bytes, kernel));
+  }
+  std::printf("  GB/s\n");
+  setStringKernelLevel(bestStringKernelLevel());
+}
+
+// The old split rebuilt the remaining string after every delimiter
+size_t quadraticSplit(const std::string &str, const std::string &delim) {
+  size_t parts = 0;
+  size_t pos = 0;
+  std::string remaining = str;
+  while ((pos = remaining.find(delim, pos)) != std::string::npos) {
+    ++parts;
+    pos += delim.length();
+    remaining = remaining.substr(pos);
+    pos = 0;
+  }
+  return parts + 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t maxBytes = size_t{64} << 20;
+  if (argc > 1) {
+    maxBytes = std::strtoull(argv[1], nullptr, 10);
+  }
+  std::printf("best level: %s\n",
+              stringKernelLevelName(bestStringKernelLevel()));
+
+  for (size_t bytes = 1024; bytes <= maxBytes; bytes *= 32) {
+    std::string text = makeText(bytes);
+    std::string out(bytes, '\0');
+
+    report(
+        "toUpperCase", bytes,
+        [&] {
+          std::transform(text.begin(), text.end(), out.begin(), ::toupper);
+          return static_cast<size_t>(out[0]);
+        },
+        [&] {
+          asciiToUpper(text.data(), out.data(), text.size());
+          return static_cast<size_t>(out[0]);
+        });
+
+    // Worst case for trim: a short word in a sea of whitespace
+    std::string padded(bytes, ' ');
+    padded[bytes / 2] = 'x';
+    report(
+        "trim", bytes,
+        [&] {
+          return padded.find_first_not_of(" \t\n\r\f\v") +
+                 padded.find_last_not_of(" \t\n\r\f\v");
+        },
+        [&] {
+          return firstNonWhitespace(padded) + lastNonWhitespace(padded);
+        });
+
+    // A needle that never occurs but whose first byte often does
+    report(
+        "indexOf", bytes, [&] { return text.find("beta; gamma"); },
+        [&] { return findSubstring(text, "beta; gamma"); });
+
+    // The old split is quadratic, so only time it on small inputs
+    std::function<size_t()> oldSplit;
+    if (bytes <= (size_t{1} << 20)) {
+      oldSplit = [&] { return quadraticSplit(text, ", "); };
+    }
+    std::vector<size_t> positions;
+    report("split", bytes, oldSplit, [&] {
+      positions.clear();
+      findAllSubstrings(text, ", ", positions);
+      return positions.size() + 1;
+    });
+  }
+  return 0;
+}
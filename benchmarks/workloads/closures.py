@@ -0,0 +1,20 @@
+# Python twin of closures.lin
+def make_adder(n):
+    return lambda x: x + n
+
+
+adders = [make_adder(1), make_adder(2), make_adder(3)]
+total = 0
+for i in range(100000):
+    add = adders[i % 3]
+    total = add(total) % 1000003
+print(total)
+
+created = 0
+for i in range(20000):
+    f = make_adder(i)
+    created += f(1)
+print(created)
+
+scale = 3
+print(sum(x * scale for x in [1, 2, 3, 4, 5]))
@@ -0,0 +1,36 @@
+# Python twin of method_dispatch.lin
+class Shape:
+    def __init__(self):
+        self.size = 1
+
+    def area(self):
+        return self.size * self.size
+
+    def scaled(self, factor):
+        return self.area() * factor
+
+
+class Square(Shape):
+    def area(self):
+        return self.size * self.size + 1
+
+
+class Counter:
+    def __init__(self, count):
+        self.count = count
+
+    def increment(self):
+        self.count = self.count + 1
+
+
+shapes = [Shape(), Shape(), Square(), Square()]
+for s in range(4):
+    shapes[s].size = s + 1
+counter = Counter(0)
+total = 0
+for i in range(50000):
+    shape = shapes[i % 4]
+    total += shape.area() + shape.scaled(2)
+    counter.increment()
+print(total)
+print(counter.count)
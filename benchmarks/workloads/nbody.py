@@ -0,0 +1,79 @@
+# Python twin of nbody.lin
+import math
+
+
+class Body:
+    def __init__(self, x, y, z, vx, vy, vz, mass):
+        self.x, self.y, self.z = x, y, z
+        self.vx, self.vy, self.vz = vx, vy, vz
+        self.mass = mass
+
+
+PI = 3.141592653589793
+SOLAR_MASS = 4.0 * PI * PI
+DAYS_PER_YEAR = 365.24
+
+bodies = [
+    Body(0.0, 0.0, 0.0, 0.0, 0.0, 0.0, SOLAR_MASS),
+    Body(4.84143144246472090e+00, -1.16032004402742839e+00,
+         -1.03622044471123109e-01, 1.66007664274403694e-03 * DAYS_PER_YEAR,
+         7.69901118419740425e-03 * DAYS_PER_YEAR,
+         -6.90460016972063023e-05 * DAYS_PER_YEAR,
+         9.54791938424326609e-04 * SOLAR_MASS),
+    Body(8.34336671824457987e+00, 4.12479856412430479e+00,
+         -4.03523417114321381e-01, -2.76742510726862411e-03 * DAYS_PER_YEAR,
+         4.99852801234917238e-03 * DAYS_PER_YEAR,
+         2.30417297573763929e-05 * DAYS_PER_YEAR,
+         2.85885980666130812e-04 * SOLAR_MASS),
+    Body(1.28943695621391310e+01, -1.51111514016986312e+01,
+         -2.23307578892655734e-01, 2.96460137564761618e-03 * DAYS_PER_YEAR,
+         2.37847173959480950e-03 * DAYS_PER_YEAR,
+         -2.96589568540237556e-05 * DAYS_PER_YEAR,
+         4.36624404335156298e-05 * SOLAR_MASS),
+    Body(1.53796971148509165e+01, -2.59193146099879641e+01,
+         1.79258772950371181e-01, 2.68067772490389322e-03 * DAYS_PER_YEAR,
+         1.62824170038242295e-03 * DAYS_PER_YEAR,
+         -9.51592254519715870e-05 * DAYS_PER_YEAR,
+         5.15138902046611451e-05 * SOLAR_MASS),
+]
+
+
+def energy():
+    e = 0.0
+    for i, b in enumerate(bodies):
+        e += 0.5 * b.mass * (b.vx * b.vx + b.vy * b.vy + b.vz * b.vz)
+        for c in bodies[i + 1:]:
+            dx, dy, dz = b.x - c.x, b.y - c.y, b.z - c.z
+            e -= b.mass * c.mass / math.sqrt(dx * dx + dy * dy + dz * dz)
+    return e
+
+
+def advance(dt):
+    for i, b in enumerate(bodies):
+        for c in bodies[i + 1:]:
+            dx, dy, dz = b.x - c.x, b.y - c.y, b.z - c.z
+            d2 = dx * dx + dy * dy + dz * dz
+            mag = dt / (d2 * math.sqrt(d2))
+            b.vx -= dx * c.mass * mag
+            b.vy -= dy * c.mass * mag
+            b.vz -= dz * c.mass * mag
+            c.vx += dx * b.mass * mag
+            c.vy += dy * b.mass * mag
+            c.vz += dz * b.mass * mag
+    for b in bodies:
+        b.x += dt * b.vx
+        b.y += dt * b.vy
+        b.z += dt * b.vz
+
+
+px = sum(b.vx * b.mass for b in bodies)
+py = sum(b.vy * b.mass for b in bodies)
+pz = sum(b.vz * b.mass for b in bodies)
+bodies[0].vx = -px / SOLAR_MASS
+bodies[0].vy = -py / SOLAR_MASS
+bodies[0].vz = -pz / SOLAR_MASS
+
+print(energy())
+for _ in range(2000):
+    advance(0.01)
+print(energy())
@@ -0,0 +1,17 @@
+# Python twin of object_alloc.lin
+class Point:
+    def __init__(self, x, y):
+        self.x = x
+        self.y = y
+
+
+total = 0
+for i in range(100000):
+    p = Point(i, i + 1)
+    total += (p.x + p.y) % 1000
+print(total)
+
+kept = [Point(0, 0)]
+for i in range(1, 20000):
+    kept.append(Point(i, i * 2))
+print(sum(p.y for p in kept))
@@ -0,0 +1,23 @@
+# Python twin of string_building.lin
+parts = []
+for i in range(100000):
+    parts.append("item")
+    parts.append(str(i))
+    parts.append(",")
+text = "".join(parts)
+print(len(text))
+
+line = ""
+for i in range(20000):
+    line = line + "x"
+print(len(line))
+
+labels = 0
+for i in range(50000):
+    label = f"row {i}: {i * 2}"
+    labels += len(label)
+print(labels)
+
+pieces = text.split(",")
+print(len(pieces))
+print(sum(len(piece) for piece in pieces))
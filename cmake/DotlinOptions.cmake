@@ -3,6 +3,15 @@ option(DOTLIN_ENABLE_UBSAN "Enable UndefinedBehaviorSanitizer (non-MSVC)" OFF)
 option(DOTLIN_ENABLE_TSAN "Enable ThreadSanitizer (non-MSVC)" OFF)
 option(DOTLIN_ENABLE_LSAN "Enable LeakSanitizer (non-MSVC)" OFF)
 
+# Trace sites behind --log=; compiled out of release builds by default
+if(CMAKE_BUILD_TYPE MATCHES "^(Release|MinSizeRel)$")
+  set(DOTLIN_TRACING_DEFAULT OFF)
+else()
+  set(DOTLIN_TRACING_DEFAULT ON)
+endif()
+option(DOTLIN_ENABLE_TRACING "Compile in trace sites for --log="
+  ${DOTLIN_TRACING_DEFAULT})
+
 function(dotlin_apply_sanitizers target)
   if(MSVC)
     message(WARNING "Sanitizers are not supported on MSVC, ignoring sanitizer options")
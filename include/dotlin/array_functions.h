@@ -0,0 +1,27 @@
+// Higher-order functions on Dotlin arrays
+#pragma once
+#include "dotlin/interpreter.h"
+#include <string>
+#include <vector>
+
+namespace dotlin {
+
+// map, filter, forEach, reduce, fold, any, all, count and sumOf. The lambda
+// argument is invoked through a LambdaFrame, so no environment is allocated
+// per element.
+Value callArrayHigherOrder(Interpreter &interpreter, const ArrayValue &array,
+                           const std::string &method,
+                           const std::vector<Value> &args);
+
+// The lambda passed as args[index], or an error naming `method`
+std::shared_ptr<LambdaValue> lambdaArg(const std::vector<Value> &args,
+                                       size_t index, const std::string &method);
+
+// Predicate result check: only Boolean true counts as a match
+bool isTrue(const Value &value);
+
+// Numeric addition used by sum-like operations: Int + Int stays Int
+// (wrapping like Kotlin), Long widens, anything with a Double is a Double
+Value addNumbers(const Value &lhs, const Value &rhs);
+
+} // namespace dotlin
@@ -0,0 +1,28 @@
+// Reduction and search kernels for Dotlin arrays
+#pragma once
+#include "dotlin/interpreter.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace dotlin {
+
+// Raw kernels over unboxed stores. The min/max kernels require n > 0 and
+// the indexOf kernels return -1 when the needle is not present.
+int64_t sumInts(const int *data, size_t n);
+double sumDoubles(const double *data, size_t n);
+int minInts(const int *data, size_t n);
+int maxInts(const int *data, size_t n);
+double minDoubles(const double *data, size_t n);
+double maxDoubles(const double *data, size_t n);
+std::ptrdiff_t indexOfInt(const int *data, size_t n, int needle);
+std::ptrdiff_t indexOfDouble(const double *data, size_t n, double needle);
+
+// Array-level operations: use the kernels when the array is unboxed and
+// fall back to a scan over boxed Values otherwise
+Value arraySum(const ArrayValue &array);
+Value arrayMin(const ArrayValue &array);
+Value arrayMax(const ArrayValue &array);
+Value arrayAverage(const ArrayValue &array);
+std::ptrdiff_t arrayIndexOf(const ArrayValue &array, const Value &needle);
+
+} // namespace dotlin
@@ -0,0 +1,29 @@
+// Sorting and binary search for Dotlin arrays
+#pragma once
+#include "dotlin/interpreter.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace dotlin {
+
+// Natural order used by sort and binarySearch: numbers by value (across Int,
+// Long and Double, NaN last), strings lexicographically, false before true.
+// Throws for values that have no natural order.
+int compareValues(const Value &lhs, const Value &rhs);
+
+// Raw kernels: LSD radix sort on the order-preserving bit patterns of the
+// keys, falling back to std::sort for short inputs. Doubles end up in
+// Kotlin's total order (-0.0 before 0.0, NaN last).
+void sortInts(std::vector<int> &data);
+void sortDoubles(std::vector<double> &data);
+
+// sort, sortDescending (in place), sorted, sortedDescending, sortedBy,
+// sortedByDescending, sortedWith and binarySearch. Unboxed Int and Double
+// arrays and String arrays sort without comparator calls; sortedBy computes
+// every key once and sortedWith calls the comparator through one reused
+// LambdaFrame. All sorts are stable.
+Value callArraySort(Interpreter &interpreter, ArrayValue &array,
+                    const std::string &method, const std::vector<Value> &args);
+
+} // namespace dotlin
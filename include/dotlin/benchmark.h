@@ -0,0 +1,40 @@
+// Micro-benchmarks written in Dotlin
+#pragma once
+#include "dotlin/interpreter.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace dotlin {
+
+// Per-iteration times in nanoseconds, less the cost of reading the clock
+struct BenchmarkStats {
+  size_t iterations = 0;
+  int64_t minNs = 0;
+  int64_t medianNs = 0;
+  int64_t p99Ns = 0;
+  int64_t meanNs = 0;
+  double opsPerSecond = 0.0;
+};
+
+// benchmark(name, iterations) { body }: runs the body iterations / 10 times
+// (at least once) to warm up, then times each of `iterations` runs on its
+// own with steady_clock. The samples go into a preallocated buffer and are
+// only sorted afterwards, so the harness adds two clock reads per run.
+BenchmarkStats runBenchmark(Interpreter &interpreter,
+                            const std::shared_ptr<LambdaValue> &body,
+                            size_t iterations);
+
+// "name: 1000 iterations, min 1.20 us, median 1.35 us, p99 2.10 us,
+// 740741 ops/s"
+std::string formatBenchmark(const std::string &name,
+                            const BenchmarkStats &stats);
+
+// The statistics as a map for scripts: name, iterations, minNs, medianNs,
+// p99Ns, meanNs and opsPerSecond
+Value benchmarkResult(const std::string &name, const BenchmarkStats &stats);
+
+// nanoTime(): steady_clock nanoseconds, for measuring intervals
+int64_t nanoTime();
+
+} // namespace dotlin
@@ -0,0 +1,55 @@
+// Hash maps and hash sets for Dotlin
+#pragma once
+#include "dotlin/hash_table.h"
+#include "dotlin/interpreter.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dotlin {
+
+// Maps and sets are shared by reference like class instances. The ones made
+// by mapOf/setOf are read-only; mutableMapOf, hashMapOf, mutableSetOf and
+// hashSetOf make mutable ones.
+struct MapValue {
+  ValueTable table{true};
+  bool isMutable = false;
+};
+
+struct SetValue {
+  ValueTable table{false};
+  bool isMutable = false;
+};
+
+// `key to value` builds a pair, which is a two-element array
+Value makePair(const Value &first, const Value &second);
+
+// Build from the arguments of mapOf(k to v, ...) and setOf(a, b, ...)
+std::shared_ptr<MapValue> makeMap(const std::vector<Value> &pairs,
+                                  bool isMutable);
+std::shared_ptr<SetValue> makeSet(const std::vector<Value> &elements,
+                                  bool isMutable);
+
+// m[key] (null when absent) and m[key] = value
+Value mapGet(const MapValue &map, const Value &key);
+void mapSet(MapValue &map, const Value &key, const Value &value);
+
+// Snapshots in insertion order: [key, value] pairs for maps, elements for
+// sets. Used by for loops and the methods that return arrays.
+ArrayValue mapEntries(const MapValue &map);
+ArrayValue setElements(const SetValue &set);
+
+bool mapsEqual(const MapValue &lhs, const MapValue &rhs);
+bool setsEqual(const SetValue &lhs, const SetValue &rhs);
+std::string mapToString(const MapValue &map); // {a=1, b=2}
+std::string setToString(const SetValue &set); // [a, b]
+
+// Method calls and properties (size, keys, values) on maps and sets
+Value callMapMethod(Interpreter &interpreter,
+                    const std::shared_ptr<MapValue> &map,
+                    const std::string &method, const std::vector<Value> &args);
+Value callSetMethod(Interpreter &interpreter,
+                    const std::shared_ptr<SetValue> &set,
+                    const std::string &method, const std::vector<Value> &args);
+
+} // namespace dotlin
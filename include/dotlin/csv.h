@@ -0,0 +1,41 @@
+// CSV input for Dotlin scripts
+#pragma once
+#include "dotlin/interpreter.h"
+#include <memory>
+#include <string>
+
+namespace dotlin {
+
+// readCsv's options map: delimiter and quote (one-character strings),
+// header (whether the first record names the columns) and sampleRows (how
+// many records decide the column types)
+struct CsvOptions {
+  char delimiter = ',';
+  char quote = '"';
+  bool header = true;
+  size_t sampleRows = 1000;
+};
+
+CsvOptions csvOptions(const Value &options);
+
+// readCsv(path, options): a map from column name to an array holding the
+// column. A column is Int when every field in the sample is an Int, Double
+// when every field is a number, and String otherwise. A later field that
+// does not fit widens the column: Int to Double (empty fields become NaN),
+// or numbers to String, re-formatting the values read so far. Without a
+// header the columns are named column1, column2, ...
+//
+// The file is read in blocks; records are split with a 64-byte SIMD scan
+// for delimiters, quotes and line breaks, and numbers are parsed straight
+// from the block. Quoted fields may hold delimiters, line breaks and
+// doubled quotes; a quote only has meaning at the start of a field.
+Value readCsvColumns(const std::string &path, const CsvOptions &options);
+
+// readCsv(path, options) { row -> }: calls the lambda with each record as
+// an array of its fields, typed by the sampled column types (an empty
+// numeric field is null). Memory use does not depend on the file size.
+void forEachCsvRow(Interpreter &interpreter, const std::string &path,
+                   const CsvOptions &options,
+                   const std::shared_ptr<LambdaValue> &lambda);
+
+} // namespace dotlin
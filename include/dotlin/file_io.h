@@ -0,0 +1,106 @@
+// File access for Dotlin scripts
+#pragma once
+#include "dotlin/interpreter.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dotlin {
+
+// File(path): a path whose contents are only read when a method asks
+struct FileValue {
+  std::string path;
+};
+
+// A file opened for reading, closed when it goes out of scope
+class ReadDescriptor {
+public:
+  explicit ReadDescriptor(const std::string &path);
+  ~ReadDescriptor();
+  ReadDescriptor(const ReadDescriptor &) = delete;
+  ReadDescriptor &operator=(const ReadDescriptor &) = delete;
+
+  int get() const { return fd; }
+
+private:
+  int fd;
+};
+
+// A read-only mapping of a whole regular file. Empty when the file cannot
+// be mapped, for example because it is empty, a pipe, or on Windows.
+class MappedFile {
+public:
+  explicit MappedFile(int fd);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool mapped() const { return !bytes.empty(); }
+  std::string_view view() const { return bytes; }
+
+private:
+  std::string_view bytes;
+};
+
+// openWriter(path, append): a file opened for writing. Text collects in a
+// user-space buffer and reaches the file in large blocks, so writing many
+// small pieces costs one open and few system calls. The buffer is written
+// out on flush(), on close() and when the last reference goes away.
+class FileWriterValue {
+public:
+  FileWriterValue(std::string path, bool append);
+  ~FileWriterValue();
+  FileWriterValue(const FileWriterValue &) = delete;
+  FileWriterValue &operator=(const FileWriterValue &) = delete;
+
+  void write(std::string_view text);
+  void flush();
+  void close(); // further writes fail; closing twice is allowed
+  bool isOpen() const { return fd >= 0; }
+  const std::string &path() const { return filePath; }
+
+private:
+  std::string filePath;
+  int fd;
+  std::string buffer;
+
+  void writeAll(std::string_view text);
+};
+
+// The whole file. Regular files are memory-mapped and copied once into a
+// string of the exact size; pipes and special files are read in blocks.
+std::string readFileContents(const std::string &path);
+
+// Streams the lines of a file to `onLine` until it returns false. Only one
+// block of the file is held in memory at a time.
+void forEachFileLine(const std::string &path,
+                     const std::function<bool(const std::string &)> &onLine);
+
+// Binary array files for saveArray and mapArray: a 32-byte header (magic,
+// byte-order mark, element type, count) followed by the raw Int, Long or
+// Double elements. Loading maps the file and returns an array that reads
+// the elements in place, in O(1) time and memory; the first mutation copies
+// them into an owned store. saveArray replaces the file instead of
+// truncating it, so mapped arrays stay valid; other programs must not
+// truncate a mapped file either. Where mapping is not available, the
+// elements are copied into an unboxed array.
+void saveArrayFile(const std::string &path, const ArrayValue &array);
+ArrayValue loadArrayFile(const std::string &path);
+
+// readText, readLines, lines, forEachLine, exists and delete, plus the path
+// and name properties
+Value callFileMethod(Interpreter &interpreter,
+                     const std::shared_ptr<FileValue> &file,
+                     const std::string &method,
+                     const std::vector<Value> &args);
+
+// write, writeLine, flush, close and use { writer -> }, which closes the
+// writer when the lambda finishes, also when it throws
+Value callFileWriterMethod(Interpreter &interpreter,
+                           const std::shared_ptr<FileWriterValue> &writer,
+                           const std::string &method,
+                           const std::vector<Value> &args);
+
+} // namespace dotlin
@@ -0,0 +1,63 @@
+// Open-addressing hash table keyed by Dotlin values
+#pragma once
+#include "dotlin/interpreter.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dotlin {
+
+// Hash consistent with valuesEqual: Int, Long and Double values that compare
+// equal hash equally, strings and arrays hash by content, maps and sets by
+// their entries regardless of order, and objects and lambdas by identity
+uint64_t hashValue(const Value &value);
+
+// Swiss-table style index over a dense entry list. Entries stay in insertion
+// order (as Kotlin's mapOf/setOf iterate); the index holds one control byte
+// and one 32-bit entry number per slot, and the control bytes of a 16-slot
+// group are matched against the hash tag at once with SSE2. Together with
+// the cached hash that is about 14 bytes of overhead per entry at the 7/8
+// maximum load. Tables of up to 8 entries, such as most records and JSON
+// objects, skip the index and compare the cached hashes in order.
+class ValueTable {
+public:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  // Sets store keys only; maps keep a value next to every key
+  explicit ValueTable(bool withValues) : hasValues(withValues) {}
+
+  size_t size() const { return live; }
+
+  // Entry number of `key`, or npos
+  size_t find(const Value &key) const;
+  // Entry number of `key`, adding it (with a Unit value) when missing. The
+  // flag tells whether it was added.
+  std::pair<size_t, bool> insert(const Value &key);
+  bool erase(const Value &key);
+  void clear();
+  void reserve(size_t count);
+
+  // Entry numbers run from 0 to entryCount(); skip the ones not isLive()
+  size_t entryCount() const { return keys.size(); }
+  bool isLive(size_t entry) const { return hashes[entry] != 0; }
+  const Value &keyAt(size_t entry) const { return keys[entry]; }
+  Value &valueAt(size_t entry) { return values[entry]; }
+  const Value &valueAt(size_t entry) const { return values[entry]; }
+
+private:
+  bool hasValues;
+  std::vector<Value> keys;
+  std::vector<Value> values;    // empty for sets
+  std::vector<uint64_t> hashes; // 0 marks an erased entry
+  std::vector<int8_t> control;  // one byte per slot, see hash_table.cpp
+  std::vector<uint32_t> slots;  // entry number stored in each full slot
+  size_t live = 0;
+  size_t used = 0; // full plus deleted slots
+
+  size_t findSlot(const Value &key, uint64_t hash) const;
+  size_t linearFind(const Value &key, uint64_t hash) const;
+  void rebuild(size_t slotCount);
+  void placeEntry(uint32_t entry, uint64_t hash);
+};
+
+} // namespace dotlin
@@ -0,0 +1,57 @@
+// Buffered standard input for Dotlin scripts
+#pragma once
+#include "dotlin/interpreter.h"
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dotlin {
+
+// Reads up to n bytes from a file descriptor, retrying when interrupted;
+// 0 at end of input
+size_t readBlock(int fd, char *data, size_t n);
+
+// Reads a file descriptor in large blocks with read(2), bypassing
+// iostreams. Numbers are parsed straight out of the block, so bulk
+// readers build typed arrays without a string per token. Line endings
+// may be \n or \r\n.
+class InputReader {
+public:
+  explicit InputReader(int descriptor);
+  InputReader(const InputReader &) = delete;
+  InputReader &operator=(const InputReader &) = delete;
+
+  // The next line without its ending; false at end of input
+  bool readLine(std::string &line);
+
+  // Every remaining line
+  ArrayValue readAllLines();
+
+  // Whitespace-separated tokens of the next line, or with a count, exactly
+  // that many tokens across lines. Empty at end of input.
+  ArrayValue readInts(std::optional<size_t> count);
+  ArrayValue readDoubles(std::optional<size_t> count);
+  ArrayValue readWords();
+
+private:
+  bool fill();
+  std::string_view nextToken(bool sameLine);
+  void finishLine();
+  template <typename T, typename Parse>
+  std::vector<T> readNumbers(std::optional<size_t> count, const char *what,
+                             Parse parse);
+
+  int fd;
+  std::vector<char> buffer;
+  size_t begin = 0; // unread bytes are buffer[begin, end)
+  size_t end = 0;
+  bool atEof = false;
+  std::mutex mutex;
+};
+
+// The process-wide reader for standard input
+InputReader &standardInput();
+
+} // namespace dotlin
@@ -1,10 +1,14 @@
 // Interpreter for Dotlin - Kotlin-like language implementation in C++
 #pragma once
+#include "dotlin/output.h"
 #include "dotlin/parser.h"
+#include "dotlin/random.h"
 // #include <any>
 // #include <functional>
 #include <map>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <variant>
@@ -19,6 +23,13 @@ struct LambdaValue;
 struct Environment;
 struct Type;
 struct ClassDefinition;
+struct SequenceValue;
+struct MapValue;
+struct SetValue;
+struct StringBuilderValue;
+struct FileValue;
+class FileWriterValue;
+class MappedFile;
 
 class DotlinError : public std::runtime_error {
 public:
@@ -63,7 +74,13 @@ public:
 using Value = std::variant<int, int64_t, double, bool, std::string, ArrayValue,
                            std::shared_ptr<LambdaValue>,
                            std::shared_ptr<struct ClassInstance>,
-                           std::shared_ptr<ClassDefinition>>;
+                           std::shared_ptr<ClassDefinition>,
+                           std::shared_ptr<SequenceValue>,
+                           std::shared_ptr<MapValue>,
+                           std::shared_ptr<SetValue>,
+                           std::shared_ptr<StringBuilderValue>,
+                           std::shared_ptr<FileValue>,
+                           std::shared_ptr<FileWriterValue>>;
 
 // Class instance structure
 struct ClassInstance {
@@ -142,34 +159,135 @@ struct LambdaValue {
 };
 
 // Array element type enumeration
-enum class ArrayElementType { INT, DOUBLE, BOOL, STRING, MIXED, UNKNOWN };
+enum class ArrayElementType {
+  INT,
+  LONG,
+  DOUBLE,
+  BOOL,
+  STRING,
+  MIXED,
+  UNKNOWN
+};
+
+// Int, Long or Double elements read in place from a read-only file mapping
+// (see mapArray). The mapping stays alive as long as any array uses it.
+struct MappedElements {
+  std::shared_ptr<const MappedFile> file;
+  const char *bytes = nullptr;
+  size_t count = 0;
+  ArrayElementType type = ArrayElementType::INT;
+
+  size_t size() const { return count; }
+
+  template <typename T> bool holds() const {
+    if constexpr (std::is_same_v<T, int>)
+      return type == ArrayElementType::INT;
+    else if constexpr (std::is_same_v<T, int64_t>)
+      return type == ArrayElementType::LONG;
+    else
+      return type == ArrayElementType::DOUBLE;
+  }
+
+  // The payload is 8-byte aligned: mappings start on a page boundary and
+  // the file header is 32 bytes
+  template <typename T> std::span<const T> as() const {
+    return {reinterpret_cast<const T *>(bytes), count};
+  }
+};
+
+// Backing buffer of an array. Arrays whose elements are all Int, Long,
+// Double or Boolean are kept unboxed in a contiguous vector (bit-packed for
+// Boolean); anything else uses the generic Value form. A buffer is shared
+// between copies of an array and only duplicated when one of them is
+// mutated. A mapped buffer is never written: the first mutation copies it
+// into an owned vector.
+struct ArrayStorage {
+  std::variant<std::vector<Value>, std::vector<int>, std::vector<double>,
+               std::vector<bool>, std::vector<int64_t>, MappedElements>
+      data;
+  ArrayElementType elementType = ArrayElementType::UNKNOWN;
+};
+
+// Identity of an array object: every reference to the same array points at
+// one handle, so mutations are visible through all of them.
+struct ArrayHandle {
+  std::shared_ptr<ArrayStorage> storage;
+};
 
-// Array value structure
 // Array value structure
 struct ArrayValue {
-  std::shared_ptr<std::vector<Value>> elements;
-  ArrayElementType elementType;
+  std::shared_ptr<ArrayHandle> handle;
 
-  ArrayValue()
-      : elements(std::make_shared<std::vector<Value>>()),
-        elementType(ArrayElementType::UNKNOWN) {}
+  ArrayValue() : handle(freshHandle()) {}
 
   ArrayValue(const std::vector<Value> &els)
-      : elements(std::make_shared<std::vector<Value>>(els)),
-        elementType(determineElementType(els)) {}
+      : ArrayValue(std::vector<Value>(els)) {}
 
-  ArrayValue(std::vector<Value> &&els)
-      : elements(std::make_shared<std::vector<Value>>(std::move(els))),
-        elementType(determineElementType(*elements)) {}
+  ArrayValue(std::vector<Value> &&els) : handle(freshHandle()) {
+    ArrayElementType type = determineElementType(els);
+    assign(std::move(els), type);
+  }
 
   // Constructor with explicit element type
   ArrayValue(const std::vector<Value> &els, ArrayElementType elemType)
-      : elements(std::make_shared<std::vector<Value>>(els)),
-        elementType(elemType) {}
+      : ArrayValue(std::vector<Value>(els), elemType) {}
 
   ArrayValue(std::vector<Value> &&els, ArrayElementType elemType)
-      : elements(std::make_shared<std::vector<Value>>(std::move(els))),
-        elementType(elemType) {}
+      : handle(freshHandle()) {
+    // An explicit type only matters for empty arrays; otherwise trust the
+    // elements so the unboxed store can never hold a mismatched value.
+    if (!els.empty()) {
+      elemType = determineElementType(els);
+    }
+    assign(std::move(els), elemType);
+  }
+
+  // Constructors for natively produced, already unboxed data
+  explicit ArrayValue(std::vector<int> &&els) : handle(freshHandle()) {
+    mutableStore().data = std::move(els);
+    mutableStore().elementType = ArrayElementType::INT;
+  }
+
+  explicit ArrayValue(std::vector<double> &&els) : handle(freshHandle()) {
+    mutableStore().data = std::move(els);
+    mutableStore().elementType = ArrayElementType::DOUBLE;
+  }
+
+  explicit ArrayValue(std::vector<bool> &&els) : handle(freshHandle()) {
+    mutableStore().data = std::move(els);
+    mutableStore().elementType = ArrayElementType::BOOL;
+  }
+
+  explicit ArrayValue(std::vector<int64_t> &&els) : handle(freshHandle()) {
+    mutableStore().data = std::move(els);
+    mutableStore().elementType = ArrayElementType::LONG;
+  }
+
+  // An array over mapped file contents; O(1), nothing is copied until the
+  // array is mutated
+  explicit ArrayValue(MappedElements &&els) : handle(freshHandle()) {
+    ArrayElementType type = els.type;
+    handle->storage->data = std::move(els);
+    handle->storage->elementType = type;
+  }
+
+  // A new array object with the same contents. O(1): the buffer is shared
+  // until either side is mutated.
+  ArrayValue copy() const {
+    ArrayValue out;
+    out.handle->storage = handle->storage;
+    return out;
+  }
+
+  // Make this array hold the contents of `other` (e.g. the result of an
+  // in-place sort); O(1), the buffer is shared copy-on-write
+  void assignFrom(const ArrayValue &other) {
+    handle->storage = other.handle->storage;
+  }
+  // True if both values refer to the same array object
+  bool sameObject(const ArrayValue &other) const {
+    return handle == other.handle;
+  }
 
   // Determine the element type based on the elements in the array
   static ArrayElementType
@@ -190,6 +308,8 @@ struct ArrayValue {
   static ArrayElementType getValueType(const Value &val) {
     if (std::holds_alternative<int>(val))
       return ArrayElementType::INT;
+    else if (std::holds_alternative<int64_t>(val))
+      return ArrayElementType::LONG;
     else if (std::holds_alternative<double>(val))
       return ArrayElementType::DOUBLE;
     else if (std::holds_alternative<bool>(val))
@@ -201,104 +321,379 @@ struct ArrayValue {
       return ArrayElementType::UNKNOWN;
   }
 
+  ArrayElementType elementType() const { return store().elementType; }
+
+  // Typed views of the backing store; null when the array is not unboxed
+  const std::vector<int> *ints() const {
+    return std::get_if<std::vector<int>>(&store().data);
+  }
+  const std::vector<double> *doubles() const {
+    return std::get_if<std::vector<double>>(&store().data);
+  }
+  const std::vector<bool> *bools() const {
+    return std::get_if<std::vector<bool>>(&store().data);
+  }
+  const std::vector<int64_t> *longs() const {
+    return std::get_if<std::vector<int64_t>>(&store().data);
+  }
+  const std::vector<Value> *values() const {
+    return std::get_if<std::vector<Value>>(&store().data);
+  }
+  // Mapped file contents; null when the array owns its elements
+  const MappedElements *mapped() const {
+    return std::get_if<MappedElements>(&store().data);
+  }
+
+  // Int (T = int), Long (int64_t) or Double elements as one contiguous
+  // block, whether owned or mapped; empty when the array holds another type
+  template <typename T> std::optional<std::span<const T>> elements() const {
+    if (auto *vec = std::get_if<std::vector<T>>(&store().data)) {
+      return std::span<const T>(*vec);
+    }
+    if (auto *els = mapped(); els && els->template holds<T>()) {
+      return els->template as<T>();
+    }
+    return std::nullopt;
+  }
+
   // Get the size of the array
-  size_t size() const { return elements->size(); }
+  size_t size() const {
+    return std::visit([](const auto &vec) { return vec.size(); },
+                      store().data);
+  }
 
   // Check if the array is empty
-  bool empty() const { return elements->empty(); }
+  bool empty() const { return size() == 0; }
+
+  // Get element at index without bounds checking
+  Value at(size_t index) const {
+    return std::visit(
+        [index](const auto &vec) -> Value {
+          using V = std::decay_t<decltype(vec)>;
+          if constexpr (std::is_same_v<V, std::vector<bool>>) {
+            return Value(static_cast<bool>(vec[index]));
+          } else if constexpr (std::is_same_v<V, MappedElements>) {
+            if (vec.template holds<int>())
+              return Value(vec.template as<int>()[index]);
+            if (vec.template holds<int64_t>())
+              return Value(vec.template as<int64_t>()[index]);
+            return Value(vec.template as<double>()[index]);
+          } else {
+            return Value(vec[index]);
+          }
+        },
+        store().data);
+  }
 
   // Get element at index
   Value get(size_t index) const {
-    if (index < elements->size())
-      return (*elements)[index];
+    if (index < size())
+      return at(index);
     else
       throw std::runtime_error("Array index out of bounds");
   }
 
+  // Copy the elements out in the generic boxed form
+  std::vector<Value> toValues() const {
+    std::vector<Value> out;
+    size_t n = size();
+    out.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+      out.push_back(at(i));
+    }
+    return out;
+  }
+
   // Set element at index
   void set(size_t index, const Value &value) {
-    if (index < elements->size())
-      (*elements)[index] = value;
-    else
+    if (index >= size())
       throw std::runtime_error("Array index out of bounds");
+    if (storeTyped(index, value))
+      return;
+    generic()[index] = value;
+    updateTypeFor(value);
   }
 
   // Add element to the end
   void push_back(const Value &value) {
-    elements->push_back(value);
-    // Update type if needed
-    if (elements->size() == 1) {
-      elementType = getValueType(value);
-    } else if (getValueType(value) != elementType) {
-      elementType = ArrayElementType::MIXED;
+    if (empty()) {
+      reseatFor(value);
     }
+    if (appendTyped(value))
+      return;
+    generic().push_back(value);
+    updateTypeFor(value);
   }
 
   // Insert element at position
   void insert(size_t index, const Value &value) {
-    if (index <= elements->size()) {
-      elements->insert(elements->begin() + static_cast<std::ptrdiff_t>(index),
-                       value);
-      // Update type if needed
-      if (elements->size() == 1) {
-        elementType = getValueType(value);
-      } else if (getValueType(value) != elementType) {
-        elementType = ArrayElementType::MIXED;
-      }
-    } else {
+    if (index > size())
       throw std::runtime_error("Array index out of bounds");
+    if (empty()) {
+      reseatFor(value);
+    }
+    ArrayStorage &st = mutableStore();
+    if (getValueType(value) == st.elementType &&
+        !std::holds_alternative<std::vector<Value>>(st.data)) {
+      std::visit(
+          [index, &value](auto &vec) {
+            using V = std::decay_t<decltype(vec)>;
+            if constexpr (!std::is_same_v<V, std::vector<Value>> &&
+                          !std::is_same_v<V, MappedElements>) {
+              vec.insert(vec.begin() + static_cast<std::ptrdiff_t>(index),
+                         std::get<typename V::value_type>(value));
+            }
+          },
+          st.data);
+      return;
     }
+    auto &vals = generic();
+    vals.insert(vals.begin() + static_cast<std::ptrdiff_t>(index), value);
+    updateTypeFor(value);
   }
 
   // Remove element at index
   void removeAt(size_t index) {
-    if (index < elements->size()) {
-      elements->erase(elements->begin() + static_cast<std::ptrdiff_t>(index));
-      // Recalculate type if empty
-      if (elements->empty()) {
-        elementType = ArrayElementType::UNKNOWN;
-      } else if (elementType == ArrayElementType::MIXED) {
-        // Maybe type is uniform now, but keeping mixed is safe/easier
-        // Ideally we'd re-scan but that's O(N)
-        elementType = determineElementType(*elements);
-      }
-    } else {
+    if (index >= size())
       throw std::runtime_error("Array index out of bounds");
-    }
+    std::visit(
+        [index](auto &vec) {
+          if constexpr (!std::is_same_v<std::decay_t<decltype(vec)>,
+                                        MappedElements>) {
+            vec.erase(vec.begin() + static_cast<std::ptrdiff_t>(index));
+          }
+        },
+        mutableStore().data);
+    // A mixed array may have become uniform again
+    retype();
   }
 
   // Remove last element
   void pop_back() {
-    if (!elements->empty()) {
-      elements->pop_back();
-      // Update type if needed
-      if (elements->empty()) {
-        elementType = ArrayElementType::UNKNOWN;
+    if (empty())
+      return;
+    std::visit(
+        [](auto &vec) {
+          if constexpr (!std::is_same_v<std::decay_t<decltype(vec)>,
+                                        MappedElements>) {
+            vec.pop_back();
+          }
+        },
+        mutableStore().data);
+    retype();
+  }
+
+  // Reserve capacity in the current backing store
+  void reserve(size_t n) {
+    std::visit(
+        [n](auto &vec) {
+          if constexpr (!std::is_same_v<std::decay_t<decltype(vec)>,
+                                        MappedElements>) {
+            vec.reserve(n);
+          }
+        },
+        mutableStore().data);
+  }
+
+  // Remove all elements
+  void clear() { handle->storage = std::make_shared<ArrayStorage>(); }
+
+private:
+  static std::shared_ptr<ArrayHandle> freshHandle() {
+    auto h = std::make_shared<ArrayHandle>();
+    h->storage = std::make_shared<ArrayStorage>();
+    return h;
+  }
+
+  const ArrayStorage &store() const { return *handle->storage; }
+
+  // Writable buffer, detached from any copies sharing it and from a file
+  // mapping
+  ArrayStorage &mutableStore() {
+    if (handle->storage.use_count() > 1 ||
+        std::holds_alternative<MappedElements>(handle->storage->data)) {
+      handle->storage = std::make_shared<ArrayStorage>(detached(store()));
+    }
+    return *handle->storage;
+  }
+
+  // A private, writable copy of a buffer
+  static ArrayStorage detached(const ArrayStorage &st) {
+    auto *els = std::get_if<MappedElements>(&st.data);
+    if (!els) {
+      return st;
+    }
+    ArrayStorage out;
+    out.elementType = els->type;
+    if (els->holds<int>()) {
+      auto mappedInts = els->as<int>();
+      out.data = std::vector<int>(mappedInts.begin(), mappedInts.end());
+    } else if (els->holds<int64_t>()) {
+      auto mappedLongs = els->as<int64_t>();
+      out.data = std::vector<int64_t>(mappedLongs.begin(), mappedLongs.end());
+    } else {
+      auto mappedDoubles = els->as<double>();
+      out.data =
+          std::vector<double>(mappedDoubles.begin(), mappedDoubles.end());
+    }
+    return out;
+  }
+
+  static bool isUnboxable(ArrayElementType type) {
+    return type == ArrayElementType::INT || type == ArrayElementType::LONG ||
+           type == ArrayElementType::DOUBLE || type == ArrayElementType::BOOL;
+  }
+
+  // Pick the backing store for a list of elements of the given type
+  void assign(std::vector<Value> &&els, ArrayElementType type) {
+    ArrayStorage &st = mutableStore();
+    st.elementType = type;
+    switch (type) {
+    case ArrayElementType::INT:
+      st.data = unbox<int>(els);
+      break;
+    case ArrayElementType::LONG:
+      st.data = unbox<int64_t>(els);
+      break;
+    case ArrayElementType::DOUBLE:
+      st.data = unbox<double>(els);
+      break;
+    case ArrayElementType::BOOL:
+      st.data = unbox<bool>(els);
+      break;
+    default:
+      st.data = std::move(els);
+      break;
+    }
+  }
+
+  template <typename T>
+  static std::vector<T> unbox(const std::vector<Value> &els) {
+    std::vector<T> out;
+    out.reserve(els.size());
+    for (const auto &el : els) {
+      out.push_back(std::get<T>(el));
+    }
+    return out;
+  }
+
+  // Start an empty array with the store that fits its first element
+  void reseatFor(const Value &value) {
+    ArrayElementType type = getValueType(value);
+    assign(std::vector<Value>(), type);
+  }
+
+  // Write into the unboxed store if the value fits it
+  bool storeTyped(size_t index, const Value &value) {
+    ArrayStorage &st = mutableStore();
+    if (auto *vec = std::get_if<std::vector<int>>(&st.data)) {
+      if (auto *v = std::get_if<int>(&value)) {
+        (*vec)[index] = *v;
+        return true;
+      }
+    } else if (auto *dvec = std::get_if<std::vector<double>>(&st.data)) {
+      if (auto *v = std::get_if<double>(&value)) {
+        (*dvec)[index] = *v;
+        return true;
+      }
+    } else if (auto *bvec = std::get_if<std::vector<bool>>(&st.data)) {
+      if (auto *v = std::get_if<bool>(&value)) {
+        (*bvec)[index] = *v;
+        return true;
+      }
+    } else if (auto *lvec = std::get_if<std::vector<int64_t>>(&st.data)) {
+      if (auto *v = std::get_if<int64_t>(&value)) {
+        (*lvec)[index] = *v;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool appendTyped(const Value &value) {
+    ArrayStorage &st = mutableStore();
+    if (auto *vec = std::get_if<std::vector<int>>(&st.data)) {
+      if (auto *v = std::get_if<int>(&value)) {
+        vec->push_back(*v);
+        return true;
+      }
+    } else if (auto *dvec = std::get_if<std::vector<double>>(&st.data)) {
+      if (auto *v = std::get_if<double>(&value)) {
+        dvec->push_back(*v);
+        return true;
+      }
+    } else if (auto *bvec = std::get_if<std::vector<bool>>(&st.data)) {
+      if (auto *v = std::get_if<bool>(&value)) {
+        bvec->push_back(*v);
+        return true;
+      }
+    } else if (auto *lvec = std::get_if<std::vector<int64_t>>(&st.data)) {
+      if (auto *v = std::get_if<int64_t>(&value)) {
+        lvec->push_back(*v);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Fall back to the generic form, boxing an unboxed store if needed
+  std::vector<Value> &generic() {
+    ArrayStorage &st = mutableStore();
+    if (!std::holds_alternative<std::vector<Value>>(st.data)) {
+      st.data = toValues();
+    }
+    return std::get<std::vector<Value>>(st.data);
+  }
+
+  // Track the element type after a value entered the generic store
+  void updateTypeFor(const Value &value) {
+    ArrayStorage &st = mutableStore();
+    if (size() == 1) {
+      st.elementType = getValueType(value);
+    } else if (getValueType(value) != st.elementType) {
+      st.elementType = ArrayElementType::MIXED;
+    }
+  }
+
+  // Recompute the type of a generic store after removals, unboxing it again
+  // if it became uniform
+  void retype() {
+    if (empty()) {
+      clear();
+      return;
+    }
+    ArrayStorage &st = mutableStore();
+    if (auto *vals = std::get_if<std::vector<Value>>(&st.data)) {
+      if (st.elementType != ArrayElementType::MIXED)
+        return;
+      ArrayElementType type = determineElementType(*vals);
+      if (isUnboxable(type)) {
+        assign(std::move(*vals), type);
       } else {
-        // Recalculate type
-        elementType = determineElementType(*elements);
+        st.elementType = type;
       }
     }
   }
 };
 
 // Helper function to create array value
-inline ArrayValue makeArray(const std::vector<Value> &elements) {
-  return ArrayValue(elements);
+inline ArrayValue makeArray(std::vector<Value> elements) {
+  return ArrayValue(std::move(elements));
 }
 
 // Helper function to create typed array value
-inline ArrayValue makeTypedArray(const std::vector<Value> &elements,
+inline ArrayValue makeTypedArray(std::vector<Value> elements,
                                  ArrayElementType type) {
-  return ArrayValue(elements, type);
+  return ArrayValue(std::move(elements), type);
 }
 
-// Helper function to convert ArrayValue to vector
-inline std::vector<Value> getArray(const Value &value) {
-  if (std::holds_alternative<ArrayValue>(value)) {
-    return *(std::get<ArrayValue>(value).elements);
+// Helper function to get a copy of an array value; shares the buffer until
+// either side is mutated
+inline ArrayValue getArray(const Value &value) {
+  if (auto *array = std::get_if<ArrayValue>(&value)) {
+    return array->copy();
   }
-  return std::vector<Value>();
+  return ArrayValue();
 }
 
 // Equality operator for Value type
@@ -319,13 +714,22 @@ inline bool operator==(const Value &lhs, const Value &rhs) {
     return std::get<std::string>(lhs) == std::get<std::string>(rhs);
   } else if (std::holds_alternative<ArrayValue>(lhs)) {
     // Compare array elements
-    const auto &lhsArr = *(std::get<ArrayValue>(lhs).elements);
-    const auto &rhsArr = *(std::get<ArrayValue>(rhs).elements);
+    const auto &lhsArr = std::get<ArrayValue>(lhs);
+    const auto &rhsArr = std::get<ArrayValue>(rhs);
+    // Same unboxed store on both sides: compare the raw vectors
+    if (lhsArr.ints() && rhsArr.ints())
+      return *lhsArr.ints() == *rhsArr.ints();
+    if (lhsArr.doubles() && rhsArr.doubles())
+      return *lhsArr.doubles() == *rhsArr.doubles();
+    if (lhsArr.bools() && rhsArr.bools())
+      return *lhsArr.bools() == *rhsArr.bools();
+    if (lhsArr.longs() && rhsArr.longs())
+      return *lhsArr.longs() == *rhsArr.longs();
     if (lhsArr.size() != rhsArr.size()) {
       return false;
     }
     for (size_t i = 0; i < lhsArr.size(); ++i) {
-      if (!(lhsArr[i] == rhsArr[i])) {
+      if (!(lhsArr.at(i) == rhsArr.at(i))) {
         return false;
       }
     }
@@ -374,12 +778,30 @@ struct Environment : public std::enable_shared_from_this<Environment> {
   void define(const std::string &name, Value value);
   Value get(const std::string &name);
   void assign(const std::string &name, Value value);
+  // Define a parameter both by name and at the slot the resolver gave it
+  void bind(int index, const std::string &name, Value value);
 
   // Resolver optimization methods
   void defineAt(int index, Value value);
   Value getAt(int distance, int index);
   void assignAt(int distance, int index, Value value);
   std::shared_ptr<Environment> ancestor(int distance);
+
+  // Storage of a variable for updating it in place; null if not defined
+  Value *slotAt(int distance, int index);
+  Value *lookup(const std::string &name);
+};
+
+// Which front-end passes interpret() runs. O0 only resolves variables to
+// slots, for the fastest start; O1 also runs type inference but leaves the
+// AST as parsed; O2, the default, adds constant folding and dead code
+// elimination.
+enum class OptimizationLevel { O0, O1, O2 };
+
+// Wall time of one interpret() phase, for --time-phases
+struct PhaseTime {
+  std::string name;
+  int64_t nanoseconds;
 };
 
 // Interpreter class
@@ -389,6 +811,8 @@ class Interpreter {
   friend struct TypeCheckVisitor;
   friend struct StmtTypeCheckVisitor;
   friend struct ResolverVisitor;
+  friend class LambdaFrame;
+  friend class SharedStateChecker;
 
 public:
   Interpreter();
@@ -398,8 +822,38 @@ public:
                   const std::string &sourceName);
 
   void setSourceName(const std::string &name) { sourceName = name; }
+
+  // Script output is buffered; see OutputSink. Embedders can redirect it
+  // with setWriteOutput and force pending output out with flushOutput.
+  void setWriteOutput(WriteOutput hook) {
+    output->setWriteOutput(std::move(hook));
+  }
+  void flushOutput() { output->flush(); }
+
+  // Context for running lambdas on another thread: shares the globals,
+  // output and resolver results with this interpreter but has its own
+  // current environment, call stack, last evaluated value and random
+  // generator. Cheap enough to make one per parallel chunk.
+  std::unique_ptr<Interpreter> fork(const Random &generator) const;
+  // Draws from this interpreter's generator to seed forked ones, so seed(n)
+  // also fixes what parallel lambdas draw
+  uint64_t nextRandomSeed() { return rng.next(); }
   std::string getSourceName() const { return sourceName; }
 
+  // The front-end passes interpret() runs before executing a program, in
+  // this order. Public so tools can run and time them one at a time.
+  void performTypeInference(Program &program);
+  void performConstantFolding(Program &program);
+  void performResolution(Program &program);
+  void performDeadCodeElimination(Program &program);
+
+  void setOptimizationLevel(OptimizationLevel level) {
+    optimizationLevel = level;
+  }
+  // Phases of the last interpret() call in the order they ran: the
+  // front-end passes the level selects, then execution
+  const std::vector<PhaseTime> &getPhaseTimes() const { return phaseTimes; }
+
   // Visitor pattern implementation
   void visit(LiteralExpr &node);
   void visit(IdentifierExpr &node);
@@ -423,6 +877,9 @@ public:
   void visit(LambdaExpr &node);
 
 private:
+  // Used by fork(); takes the parent's shared state instead of allocating
+  Interpreter(const Interpreter &parent, const Random &generator);
+
   std::shared_ptr<Environment> globals;
   std::shared_ptr<Environment> environment;
   std::shared_ptr<Environment>
@@ -430,6 +887,7 @@ private:
   bool hasMainFunction;
   Statement::Ptr mainFunctionStmt; // Store reference to main function if found
   std::vector<std::string> commandLineArgs; // Store command-line arguments
+  ArrayValue argsArray; // `args` as seen by scripts, built once per run
   int evaluationDepth =
       0; // Track evaluation depth to prevent infinite recursion
   static constexpr int MAX_EVALUATION_DEPTH =
@@ -437,6 +895,10 @@ private:
   std::vector<std::string> callStack; // Current call stack for tracing
   Value lastEvaluatedValue;
   std::string sourceName = "source.lin";
+  std::shared_ptr<OutputSink> output; // shared with forked workers
+  Random rng; // random(), randomInt(), shuffle() and friends
+  OptimizationLevel optimizationLevel = OptimizationLevel::O2;
+  std::vector<PhaseTime> phaseTimes;
   Value evaluate(Expression &expr);
   Value evaluate(Expression::Ptr &exprPtr);
   void execute(Statement &stmt);
@@ -447,12 +909,11 @@ private:
   std::string typeToString(const std::shared_ptr<Type> &type);
 
   // Type inference methods
-  void performTypeInference(Program &program);
   void performTypeInferenceOnStatement(Statement &stmt,
                                        class TypeChecker &typeChecker);
   void performTypeInferenceOnExpression(Expression &expr,
                                         class TypeChecker &typeChecker);
-  // Optimization methods
+  // Constant folding, resolution and dead code elimination
   void performOptimization(Program &program);
 
   // Helper method for function overloading
@@ -464,6 +925,8 @@ private:
   Value executeBuiltinFunction(
       const std::string &name,
       const std::vector<std::shared_ptr<Expression>> &arguments);
+  // Names the IdentifierExpr fallback resolves to built-in functions
+  static bool isBuiltinFunction(const std::string &name);
 
   // Function execution
   Value executeFunction(const std::string &name, Statement *body,
@@ -475,14 +938,14 @@ private:
 
   // Map to store resolution (distance, index) for expressions (Resolver pass)
   // Key: Expression raw pointer (address), Value: pair(distance, index)
-  std::map<const Expression *, std::pair<int, int>> locals;
+  // Shared with forked worker contexts, which only read it
+  std::shared_ptr<std::map<const Expression *, std::pair<int, int>>> locals;
 
   // API for Resolver
   void resolve(const Expression *expr, int depth, int index);
   // Helper to get resolved location
   std::optional<std::pair<int, int>>
   getResolvedLocation(const Expression *expr);
-  void traceLookup(const std::string &name, std::optional<int> distance);
 };
 
 Value interpret(const Program &program);
@@ -493,6 +956,9 @@ Value interpret(const Program &program, const std::vector<std::string> &args,
 // Utility functions
 std::string getTypeOfValue(const Value &value);
 std::string valueToString(const Value &value);
+// Appends valueToString(value), skipping the temporary for strings and
+// numbers
+void appendValueString(std::string &out, const Value &value);
 std::string typeToString(const std::shared_ptr<Type> &type);
 bool valuesEqual(const Value &v1, const Value &v2);
 
@@ -0,0 +1,30 @@
+// JSON for Dotlin scripts
+#pragma once
+#include "dotlin/interpreter.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dotlin {
+
+// parseJson(text). Objects become mutable maps and arrays become arrays
+// (unboxed when all elements are Int or all Double). Numbers become Int,
+// Long or Double by their form and size. null becomes the null value.
+// Errors name the byte offset where parsing failed.
+Value parseJson(std::string_view text);
+
+// toJson(value). Maps and class instances become objects. Arrays and sets
+// become arrays. StringBuilders and Files become strings. null, and
+// doubles that are NaN or infinite, become null. Throws for lambdas,
+// classes, sequences and writers.
+std::string toJson(const Value &value);
+void appendJson(std::string &out, const Value &value);
+
+// First stage of parseJson, exposed for the benchmark. Collects the byte
+// offset of every structural character, every quote that is not escaped
+// and the first byte of every literal or number, skipping string
+// contents. Works 64 bytes at a time on the masks from byteMasks64.
+void indexJson(std::string_view text, std::vector<uint32_t> &index);
+
+} // namespace dotlin
@@ -0,0 +1,44 @@
+// Reusable call frame for invoking a lambda many times in a row
+#pragma once
+#include "dotlin/interpreter.h"
+#include <memory>
+#include <string>
+
+namespace dotlin {
+
+// Calling convention used by the array higher-order functions (map, filter,
+// forEach, reduce, ...). The environment holding the parameters and the one
+// for the body block are allocated once and refilled on every call, and the
+// call stack entry is pushed once for the whole loop rather than per element.
+// A fresh pair is only allocated after a call whose body captured the frame
+// in a closure, so each captured closure keeps its own bindings.
+class LambdaFrame {
+public:
+  // `arity` is the number of arguments passed per call (0, 1 or 2). A lambda
+  // without declared parameters receives its single argument as `it`.
+  LambdaFrame(Interpreter &interpreter, std::shared_ptr<LambdaValue> lambda,
+              size_t arity, std::string frameName);
+  ~LambdaFrame();
+
+  LambdaFrame(const LambdaFrame &) = delete;
+  LambdaFrame &operator=(const LambdaFrame &) = delete;
+
+  Value call();
+  Value call(const Value &arg);
+  Value call(const Value &first, const Value &second);
+
+private:
+  Interpreter &interpreter;
+  std::shared_ptr<LambdaValue> lambda;
+  size_t arity;
+  std::shared_ptr<Environment> frameEnv;
+  std::shared_ptr<Environment> bodyEnv; // null unless the body is a block
+  const BlockStmt *block = nullptr;
+  Value *namedSlots[2] = {nullptr, nullptr};
+
+  void allocate();
+  void bind(size_t index, const Value &value);
+  Value run();
+};
+
+} // namespace dotlin
@@ -0,0 +1,24 @@
+// Number formatting and parsing with Kotlin's rules
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace dotlin {
+
+// Append the decimal form of a number. Doubles use the shortest digits that
+// round-trip and Kotlin's layout: 2.5, 100.0, 1.0E7, 1.0E-4, NaN, -Infinity.
+void appendNumber(std::string &out, int value);
+void appendNumber(std::string &out, int64_t value);
+void appendNumber(std::string &out, double value);
+std::string formatDouble(double value);
+
+// Parse the whole text as a number, or nullopt when it is not one (Kotlin's
+// toIntOrNull and friends). Integers take an optional sign and decimal
+// digits; doubles may also be surrounded by whitespace.
+std::optional<int> parseInt(std::string_view text);
+std::optional<int64_t> parseLong(std::string_view text);
+std::optional<double> parseDouble(std::string_view text);
+
+} // namespace dotlin
@@ -0,0 +1,41 @@
+// Buffered output for Dotlin scripts
+#pragma once
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace dotlin {
+
+// Receives each chunk of script output. The default writes to stdout;
+// embedders can install their own, for example to capture output.
+using WriteOutput = std::function<void(std::string_view)>;
+
+// Collects print/println output in a large buffer and hands it to the
+// WriteOutput hook in big chunks. When stdout is a terminal the sink is
+// line buffered so interactive output appears at once; otherwise it
+// flushes only when full, before reading stdin, on flush() and at exit.
+// Safe to share between the threads of the parallel operations.
+class OutputSink {
+public:
+  OutputSink();
+  ~OutputSink();
+  OutputSink(const OutputSink &) = delete;
+  OutputSink &operator=(const OutputSink &) = delete;
+
+  void write(std::string_view text);
+  void flush();
+
+  void setWriteOutput(WriteOutput hook);
+  void setLineBuffered(bool enabled);
+
+private:
+  void flushLocked();
+
+  std::mutex mutex;
+  std::string buffer;
+  WriteOutput writeOutput;
+  bool lineBuffered;
+};
+
+} // namespace dotlin
@@ -0,0 +1,59 @@
+// Parallel collection operations for Dotlin arrays
+#pragma once
+#include "dotlin/interpreter.h"
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace dotlin {
+
+// parallelMap, parallelFilter, parallelForEach and parallelReduce. The array
+// is split into chunks that run on the shared ThreadPool, each chunk in its
+// own forked interpreter context; results keep the array order. The lambda
+// is checked with SharedStateChecker first and rejected if it could write to
+// state other chunks can see.
+Value callArrayParallel(Interpreter &interpreter, const ArrayValue &array,
+                        const std::string &method,
+                        const std::vector<Value> &args);
+
+// Conservative static check that a lambda only reads what it captures. It
+// rejects assignments inside the lambda, mutating method calls (add, set,
+// clear, ...) and, transitively through the functions, methods and lambda
+// values it calls, writes to globals, object fields or collections the
+// function did not create itself. Calls it cannot follow are rejected.
+class SharedStateChecker {
+public:
+  explicit SharedStateChecker(Interpreter &interp) : interpreter(interp) {}
+
+  // Throws std::runtime_error describing the first offending construct
+  void check(const LambdaValue &lambda, const std::string &method);
+
+private:
+  enum class Mode { LAMBDA, FUNCTION };
+
+  Interpreter &interpreter;
+  std::string method;
+  // Where the checked lambda looks up the lambda values it calls
+  std::shared_ptr<Environment> scope;
+  std::unordered_set<const Statement *> checkedBodies;
+  // Per function being checked, the variables holding values it created
+  std::vector<std::unordered_set<std::string>> ownedLocals;
+
+  void checkStatement(const Statement *stmt, Mode mode);
+  void checkExpression(const Expression *expr, Mode mode);
+  void checkAssignmentTarget(const Expression *target, Mode mode);
+  void checkCallee(const Expression *callee, Mode mode);
+  void checkNamedCallee(const IdentifierExpr &callee, Mode mode);
+  void checkFunctionBody(const FunctionDef &def);
+  bool isLocal(const Expression *expr) const;
+  bool isOwned(const Expression *expr) const;
+  static bool mayAlias(const Expression *expr);
+  // Names declared anywhere in `stmt` and those of them that may alias a
+  // value from outside the function
+  static void collectDeclarations(const Statement *stmt,
+                                  std::unordered_set<std::string> &declared,
+                                  std::unordered_set<std::string> &aliased);
+  [[noreturn]] void reject(const std::string &what) const;
+};
+
+} // namespace dotlin
@@ -1,6 +1,7 @@
 // Parser for Dotlin - Kotlin-like language implementation in C++
 #pragma once
 #include "dotlin/lexer.h"
+#include "dotlin/trace.h"
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -293,6 +294,8 @@ std::unique_ptr<Expression> parseExpression(const std::vector<Token> &tokens,
 std::unique_ptr<Expression>
 parseComparisonExpression(const std::vector<Token> &tokens, size_t &pos);
 std::unique_ptr<Expression>
+parseInfixCallExpression(const std::vector<Token> &tokens, size_t &pos);
+std::unique_ptr<Expression>
 parseAdditiveExpression(const std::vector<Token> &tokens, size_t &pos);
 std::unique_ptr<Expression>
 parseMultiplicativeExpression(const std::vector<Token> &tokens, size_t &pos);
@@ -413,7 +416,7 @@ struct CallExpr : Expression {
       : Expression(l, c), callee(std::move(calleeParam)),
         arguments(std::move(args)) {
     if (!callee) {
-      std::cout << "CRITICAL: CallExpr callee is NULL!" << std::endl;
+      DOTLIN_TRACE(Parser, Warn, "call at ", l, ":", c, " has no callee");
     }
   }
 
@@ -426,8 +429,8 @@ struct MemberAccessExpr : Expression {
   MemberAccessExpr(Expression::Ptr obj, std::string prop, size_t l, size_t c)
       : Expression(l, c), object(std::move(obj)), property(std::move(prop)) {
     if (!object) {
-      std::cout << "CRITICAL: MemberAccessExpr object is null for property "
-                << property << std::endl;
+      DOTLIN_TRACE(Parser, Warn, "member access .", property, " at ", l, ":",
+                   c, " has no object");
     }
   }
 
@@ -512,6 +515,7 @@ struct FunctionDeclStmt : Statement {
   std::vector<FunctionParameter> parameters;
   Statement::Ptr body;
   std::optional<std::shared_ptr<Type>> returnType;
+  int index = -1; // Slot of a local function (Resolver)
   FunctionDeclStmt(std::string n, std::vector<std::string> params,
                    Statement::Ptr b, size_t l, size_t c)
       : Statement(l, c), name(std::move(n)), body(std::move(b)),
@@ -707,6 +711,8 @@ parseLogicalAndExpression(const std::vector<Token> &tokens, size_t &pos);
 std::unique_ptr<Expression>
 parseComparisonExpression(const std::vector<Token> &tokens, size_t &pos);
 std::unique_ptr<Expression>
+parseInfixCallExpression(const std::vector<Token> &tokens, size_t &pos);
+std::unique_ptr<Expression>
 parseAdditiveExpression(const std::vector<Token> &tokens, size_t &pos);
 std::unique_ptr<Expression>
 parseMultiplicativeExpression(const std::vector<Token> &tokens, size_t &pos);
@@ -714,5 +720,7 @@ std::unique_ptr<Expression>
 parsePostfixExpression(const std::vector<Token> &tokens, size_t &pos);
 std::unique_ptr<Expression>
 parsePrimaryExpression(const std::vector<Token> &tokens, size_t &pos);
+std::unique_ptr<Expression>
+parseLambdaExpression(const std::vector<Token> &tokens, size_t &pos);
 
 } // namespace dotlin
\ No newline at end of file
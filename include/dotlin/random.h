@@ -0,0 +1,66 @@
+// Pseudo-random numbers for Dotlin scripts
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dotlin {
+
+struct ArrayValue;
+
+// xoshiro256** generator. Each interpreter owns one, so scripts running on
+// several threads never share state. Unseeded generators start from
+// std::random_device; seed(n) makes the sequence reproducible.
+class Random {
+public:
+  Random();
+  explicit Random(uint64_t value) { seed(value); }
+  // Generator number `stream` of a family sharing `value`, such as one per
+  // parallel worker; each stream starts from an unrelated state
+  Random(uint64_t value, uint64_t stream);
+
+  // The four state words are expanded from the seed with splitmix64
+  void seed(uint64_t value);
+
+  uint64_t next() {
+    uint64_t result = rotl(state[1] * 5, 7) * 9;
+    uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return result;
+  }
+
+  // Uniform in [0, 1), from the top 53 bits
+  double nextDouble() {
+    return static_cast<double>(next() >> 11) * 0x1.0p-53;
+  }
+
+  // Uniform in [0, bound) without modulo bias; bound must not be 0
+  uint64_t nextBelow(uint64_t bound);
+
+  // Uniform in [from, until); from must be less than until
+  int64_t nextInRange(int64_t from, int64_t until) {
+    return static_cast<int64_t>(
+        static_cast<uint64_t>(from) +
+        nextBelow(static_cast<uint64_t>(until) - static_cast<uint64_t>(from)));
+  }
+
+  // Bulk generation for randomInts and randomDoubles
+  std::vector<int> ints(size_t count, int from, int until);
+  std::vector<double> doubles(size_t count);
+
+private:
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+  uint64_t state[4];
+};
+
+// Fisher-Yates shuffle of the array in place, on its unboxed store when it
+// has one
+void shuffleArray(Random &random, ArrayValue &array);
+
+} // namespace dotlin
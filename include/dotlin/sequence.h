@@ -0,0 +1,49 @@
+// Lazy sequences for Dotlin
+#pragma once
+#include "dotlin/interpreter.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dotlin {
+
+// One intermediate operation of a sequence pipeline
+struct SequenceStage {
+  enum class Kind { MAP, FILTER, TAKE, DROP, TAKE_WHILE, FLAT_MAP };
+  Kind kind;
+  std::shared_ptr<LambdaValue> fn; // unused by TAKE and DROP
+  size_t count = 0;                // TAKE and DROP only
+};
+
+// A lazy sequence: a source plus the stages applied to it. Operators return
+// a new SequenceValue with one more stage; nothing runs until a terminal
+// operation pushes the source elements through all stages in a single pass.
+struct SequenceValue {
+  // asSequence() over an array, read element by element as it is consumed
+  std::shared_ptr<ArrayValue> array;
+  // generateSequence(seed) { next }: ends when the generator returns null
+  Value seed;
+  std::shared_ptr<LambdaValue> generator;
+  // File(path).lines(): the file is streamed again on every pass
+  std::string linesPath;
+
+  std::vector<SequenceStage> stages;
+};
+
+std::shared_ptr<SequenceValue> sequenceOf(const ArrayValue &array);
+std::shared_ptr<SequenceValue>
+generateSequence(const Value &seed, std::shared_ptr<LambdaValue> next);
+std::shared_ptr<SequenceValue> fileLines(const std::string &path);
+
+// Push every element of the sequence into `sink` until it returns false
+void iterateSequence(Interpreter &interpreter, const SequenceValue &sequence,
+                     const std::function<bool(const Value &)> &sink);
+
+// Intermediate and terminal operations called as methods on a sequence
+Value callSequenceMethod(Interpreter &interpreter,
+                         const std::shared_ptr<SequenceValue> &sequence,
+                         const std::string &method,
+                         const std::vector<Value> &args);
+
+} // namespace dotlin
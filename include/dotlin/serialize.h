@@ -0,0 +1,40 @@
+// Binary serialization of Dotlin values
+#pragma once
+#include "dotlin/interpreter.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace dotlin {
+
+// serialize(value) and deserialize(bytes) use MessagePack. null, Boolean,
+// Int, Double, String, boxed arrays and read-only maps use the standard
+// forms; a Long is always a 64-bit int so it comes back as a Long.
+// Dotlin-specific values use extension types:
+//   1, 2, 3  Int, Double and Boolean arrays, as raw little-endian elements
+//   4        set; the payload byte is 1 when mutable, an array follows
+//   5        a mutable map follows
+//   6        class instance; the payload is the class name, a map of the
+//            fields follows
+//   7, 8     StringBuilder text and File path
+//   9        Long array, as raw little-endian elements
+// Lambdas, classes, sequences and writers cannot be serialized. The bytes
+// are returned in a String.
+std::string serializeValue(const Value &value);
+
+// Writes the encoding to a file in large blocks as it is produced
+void serializeValueToFile(const Value &value, const std::string &path);
+
+// The class an instance belongs to, by name; null when there is none
+using ClassLookup =
+    std::function<std::shared_ptr<ClassDefinition>(const std::string &)>;
+
+// Decodes one value. Strings and unboxed arrays are copied out with a
+// single memcpy each.
+Value deserializeValue(std::string_view bytes, const ClassLookup &findClass);
+
+// Decodes straight from a read-only mapping of the file
+Value deserializeFile(const std::string &path, const ClassLookup &findClass);
+
+} // namespace dotlin
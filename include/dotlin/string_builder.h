@@ -0,0 +1,22 @@
+// StringBuilder for Dotlin
+#pragma once
+#include "dotlin/interpreter.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dotlin {
+
+// Growable text buffer shared by reference. Appending is amortised O(1) per
+// character, so building large strings piece by piece stays linear.
+struct StringBuilderValue {
+  std::string buffer;
+};
+
+// append, appendLine, setLength, toString, length, isEmpty and clear.
+// append, appendLine and clear return the builder so calls can be chained.
+Value callStringBuilderMethod(
+    const std::shared_ptr<StringBuilderValue> &builder,
+    const std::string &method, const std::vector<Value> &args);
+
+} // namespace dotlin
@@ -0,0 +1,26 @@
+// Slicing helpers behind the String methods
+#pragma once
+#include "dotlin/interpreter.h"
+#include <string_view>
+#include <vector>
+
+namespace dotlin {
+
+// These return views into the receiver, so no bytes are copied until the
+// caller keeps a piece; each kept piece is then copied exactly once.
+
+// The text without leading and trailing whitespace
+std::string_view trimView(std::string_view text);
+
+// Kotlin's split: one linear pass, empty pieces kept. An empty delimiter
+// splits between every character, with an empty piece at both ends.
+std::vector<std::string_view> splitView(std::string_view text,
+                                        std::string_view delimiter);
+
+// Kotlin's lines(): splits on \n, \r\n and \r
+std::vector<std::string_view> linesView(std::string_view text);
+
+// Materialise the pieces as an array of Strings
+ArrayValue toStringArray(const std::vector<std::string_view> &pieces);
+
+} // namespace dotlin
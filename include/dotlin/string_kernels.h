@@ -0,0 +1,58 @@
+// SIMD kernels behind the String methods
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace dotlin {
+
+// Instruction sets the kernels can use. The best one the CPU supports is
+// picked at startup; benchmarks may force a lower level to compare.
+enum class StringKernelLevel { Scalar, SSE2, AVX2 };
+
+StringKernelLevel stringKernelLevel();
+StringKernelLevel bestStringKernelLevel();
+void setStringKernelLevel(StringKernelLevel level); // clamped to the best
+const char *stringKernelLevelName(StringKernelLevel level);
+
+// ASCII case mapping of n bytes from `in` to `out`, which may be the same
+// buffer. Other bytes are copied unchanged.
+void asciiToUpper(const char *in, char *out, size_t n);
+void asciiToLower(const char *in, char *out, size_t n);
+
+// Index of the first or last byte that is not whitespace (space, \t, \n,
+// \v, \f, \r), or npos when there is none
+size_t firstNonWhitespace(std::string_view text);
+size_t lastNonWhitespace(std::string_view text);
+
+// Position of `needle` in `haystack` at or after `from`, or npos
+size_t findSubstring(std::string_view haystack, std::string_view needle,
+                     size_t from = 0);
+
+// Start of every non-overlapping occurrence of a non-empty `needle`, left
+// to right, in one sweep over the haystack
+void findAllSubstrings(std::string_view haystack, std::string_view needle,
+                       std::vector<size_t> &positions);
+
+// Classifies `blocks` consecutive 64-byte blocks for the scanners that
+// look at every byte (JSON, CSV): bit i of masks[b * chars.size() + k] is
+// set when byte i of block b equals chars[k]. At most kMaxMaskChars
+// characters.
+constexpr size_t kMaxMaskChars = 16;
+void byteMasks64(const char *data, size_t blocks, std::string_view chars,
+                 uint64_t *masks);
+
+// Bit i of the result is the XOR of bits 0..i. Applied to a quote mask it
+// is set from an opening quote up to, but not including, its closing one.
+inline uint64_t prefixXor(uint64_t bits) {
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+
+} // namespace dotlin
@@ -0,0 +1,54 @@
+// Work-stealing thread pool used by the parallel collection operations
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dotlin {
+
+// Each worker owns a deque: it pops its own tasks from the back and steals
+// from the front of the others' when it runs dry. The thread that submits a
+// batch also runs tasks until the batch is done, so nested batches cannot
+// deadlock the pool.
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Process-wide pool sized to the hardware concurrency
+  static ThreadPool &instance();
+
+  size_t size() const { return workers.size(); }
+
+  // Run task(i) for every i in [0, count) and wait for all of them. The
+  // first exception thrown by a task is rethrown here once all have ended.
+  void parallelFor(size_t count, const std::function<void(size_t)> &task);
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  std::mutex sleepMutex;
+  std::condition_variable wake;
+  std::atomic<size_t> queued{0};
+  bool stopping = false;
+
+  void workerLoop(size_t self);
+  // Pop from queue `self` (back) or steal from another queue (front)
+  bool runOne(size_t self);
+};
+
+} // namespace dotlin
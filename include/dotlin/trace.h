@@ -0,0 +1,68 @@
+// Diagnostic tracing for the front end and interpreter
+#pragma once
+#include <array>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+namespace dotlin {
+
+enum class TraceCategory { Lexer, Parser, Typecheck, Optimize, Resolve, Exec };
+inline constexpr size_t kTraceCategoryCount = 6;
+
+// A site traces when its level is at or below its category's level
+enum class TraceLevel { Off, Warn, Info, Debug };
+
+// Levels per category, all Off until configureTracing changes them. Set
+// them before running scripts: worker threads read them unsynchronized.
+extern std::array<TraceLevel, kTraceCategoryCount> traceLevels;
+
+inline bool traceEnabled(TraceCategory category, TraceLevel level) {
+  return level <= traceLevels[static_cast<size_t>(category)];
+}
+
+// Applies a --log= spec: comma-separated category[:level] entries, where
+// the category may be "all" and the level defaults to debug, e.g.
+// "resolve,exec:info". Throws std::runtime_error on unknown names.
+void configureTracing(const std::string &spec);
+
+// Writes "[category] message" as one line to stderr, never to the
+// program's output
+void traceWrite(TraceCategory category, const std::string &message);
+
+template <typename... Parts>
+void traceMessage(TraceCategory category, const Parts &...parts) {
+  std::ostringstream message;
+  (message << ... << parts);
+  traceWrite(category, message.str());
+}
+
+// Whether this build has trace sites at all; see DOTLIN_ENABLE_TRACING
+#ifdef DOTLIN_TRACING
+inline constexpr bool kTracingCompiledIn = true;
+#else
+inline constexpr bool kTracingCompiledIn = false;
+#endif
+
+} // namespace dotlin
+
+// DOTLIN_TRACE(Resolve, Debug, "x at distance ", 2) formats and writes its
+// message only when that category traces at that level; a disabled site
+// costs one load and compare. Builds configured without
+// DOTLIN_ENABLE_TRACING compile the sites away, arguments included.
+#ifdef DOTLIN_TRACING
+#define DOTLIN_TRACE_ENABLED(category, level)                                  \
+  ::dotlin::traceEnabled(::dotlin::TraceCategory::category,                    \
+                         ::dotlin::TraceLevel::level)
+#define DOTLIN_TRACE(category, level, ...)                                     \
+  do {                                                                         \
+    if (DOTLIN_TRACE_ENABLED(category, level)) {                               \
+      ::dotlin::traceMessage(::dotlin::TraceCategory::category, __VA_ARGS__);  \
+    }                                                                          \
+  } while (0)
+#else
+#define DOTLIN_TRACE_ENABLED(category, level) false
+#define DOTLIN_TRACE(category, level, ...)                                     \
+  do {                                                                         \
+  } while (0)
+#endif
@@ -0,0 +1,165 @@
+#include "dotlin/array_functions.h"
+#include "dotlin/lambda_frame.h"
+#include <cstdint>
+#include <stdexcept>
+
+namespace dotlin {
+
+std::shared_ptr<LambdaValue> lambdaArg(const std::vector<Value> &args,
+                                       size_t index,
+                                       const std::string &method) {
+  if (index < args.size()) {
+    if (auto *lambda = std::get_if<std::shared_ptr<LambdaValue>>(&args[index])) {
+      return *lambda;
+    }
+  }
+  throw std::runtime_error(method + " expects a lambda function");
+}
+
+bool isTrue(const Value &value) {
+  auto *b = std::get_if<bool>(&value);
+  return b && *b;
+}
+
+Value addNumbers(const Value &lhs, const Value &rhs) {
+  auto asDouble = [](const Value &v) -> double {
+    if (auto *i = std::get_if<int>(&v))
+      return static_cast<double>(*i);
+    if (auto *l = std::get_if<int64_t>(&v))
+      return static_cast<double>(*l);
+    if (auto *d = std::get_if<double>(&v))
+      return *d;
+    throw std::runtime_error("sum requires numeric values");
+  };
+  auto *li = std::get_if<int>(&lhs);
+  auto *ri = std::get_if<int>(&rhs);
+  if (li && ri) {
+    return Value(static_cast<int>(static_cast<uint32_t>(*li) +
+                                  static_cast<uint32_t>(*ri)));
+  }
+  if (std::holds_alternative<double>(lhs) ||
+      std::holds_alternative<double>(rhs)) {
+    return Value(asDouble(lhs) + asDouble(rhs));
+  }
+  auto asLong = [&](const Value &v) -> int64_t {
+    if (auto *i = std::get_if<int>(&v))
+      return *i;
+    if (auto *l = std::get_if<int64_t>(&v))
+      return *l;
+    return static_cast<int64_t>(asDouble(v));
+  };
+  return Value(static_cast<int64_t>(static_cast<uint64_t>(asLong(lhs)) +
+                                    static_cast<uint64_t>(asLong(rhs))));
+}
+
+Value callArrayHigherOrder(Interpreter &interpreter, const ArrayValue &array,
+                           const std::string &method,
+                           const std::vector<Value> &args) {
+  // No-argument forms that need no lambda
+  if (args.empty() && method == "any") {
+    return Value(!array.empty());
+  }
+  if (args.empty() && method == "count") {
+    return Value(static_cast<int>(array.size()));
+  }
+
+  if (method == "map") {
+    LambdaFrame frame(interpreter, lambdaArg(args, 0, method), 1,
+                      "lambda@map");
+    ArrayValue mapped;
+    for (size_t i = 0; i < array.size(); ++i) {
+      mapped.push_back(frame.call(array.at(i)));
+      if (i == 0) {
+        mapped.reserve(array.size());
+      }
+    }
+    return Value(std::move(mapped));
+  }
+
+  if (method == "filter") {
+    LambdaFrame frame(interpreter, lambdaArg(args, 0, method), 1,
+                      "lambda@filter");
+    ArrayValue kept;
+    for (size_t i = 0; i < array.size(); ++i) {
+      Value element = array.at(i);
+      if (isTrue(frame.call(element))) {
+        kept.push_back(element);
+      }
+    }
+    return Value(std::move(kept));
+  }
+
+  if (method == "forEach") {
+    LambdaFrame frame(interpreter, lambdaArg(args, 0, method), 1,
+                      "lambda@forEach");
+    for (size_t i = 0; i < array.size(); ++i) {
+      frame.call(array.at(i));
+    }
+    return Value();
+  }
+
+  if (method == "reduce") {
+    LambdaFrame frame(interpreter, lambdaArg(args, 0, method), 2,
+                      "lambda@reduce");
+    if (array.empty()) {
+      throw std::runtime_error("Empty array can't be reduced.");
+    }
+    Value acc = array.at(0);
+    for (size_t i = 1; i < array.size(); ++i) {
+      acc = frame.call(acc, array.at(i));
+    }
+    return acc;
+  }
+
+  if (method == "fold") {
+    if (args.size() != 2) {
+      throw std::runtime_error("fold expects an initial value and a lambda");
+    }
+    LambdaFrame frame(interpreter, lambdaArg(args, 1, method), 2,
+                      "lambda@fold");
+    Value acc = args[0];
+    for (size_t i = 0; i < array.size(); ++i) {
+      acc = frame.call(acc, array.at(i));
+    }
+    return acc;
+  }
+
+  if (method == "any" || method == "all") {
+    bool wantAll = method == "all";
+    LambdaFrame frame(interpreter, lambdaArg(args, 0, method), 1,
+                      wantAll ? "lambda@all" : "lambda@any");
+    for (size_t i = 0; i < array.size(); ++i) {
+      bool matched = isTrue(frame.call(array.at(i)));
+      if (matched != wantAll) {
+        return Value(!wantAll);
+      }
+    }
+    return Value(wantAll);
+  }
+
+  if (method == "count") {
+    LambdaFrame frame(interpreter, lambdaArg(args, 0, method), 1,
+                      "lambda@count");
+    int matches = 0;
+    for (size_t i = 0; i < array.size(); ++i) {
+      if (isTrue(frame.call(array.at(i)))) {
+        ++matches;
+      }
+    }
+    return Value(matches);
+  }
+
+  if (method == "sumOf") {
+    LambdaFrame frame(interpreter, lambdaArg(args, 0, method), 1,
+                      "lambda@sumOf");
+    Value total(0);
+    for (size_t i = 0; i < array.size(); ++i) {
+      total = addNumbers(total, frame.call(array.at(i)));
+    }
+    return total;
+  }
+
+  throw std::runtime_error("Unknown array function: " + method);
+}
+
+} // namespace dotlin
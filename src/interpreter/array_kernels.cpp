@@ -0,0 +1,404 @@
+#include "dotlin/array_kernels.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DOTLIN_HAVE_SSE2 1
+#endif
+
+namespace dotlin {
+
+bool valuesEqual(const Value &v1, const Value &v2);
+
+// ---- Raw kernels ----
+// Each kernel processes full 128-bit lanes with SSE2 (part of the x86-64
+// baseline) and finishes the tail with scalar code. Builds for other
+// targets use the scalar loops only.
+
+int64_t sumInts(const int *data, size_t n) {
+  size_t i = 0;
+  int64_t total = 0;
+#ifdef DOTLIN_HAVE_SSE2
+  // Sign-extend to 64-bit lanes so large arrays cannot overflow
+  __m128i acc0 = _mm_setzero_si128();
+  __m128i acc1 = _mm_setzero_si128();
+  for (; i + 4 <= n; i += 4) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    __m128i sign = _mm_cmpgt_epi32(_mm_setzero_si128(), v);
+    acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v, sign));
+    acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v, sign));
+  }
+  alignas(16) int64_t lanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes),
+                  _mm_add_epi64(acc0, acc1));
+  total = lanes[0] + lanes[1];
+#endif
+  for (; i < n; ++i) {
+    total += data[i];
+  }
+  return total;
+}
+
+double sumDoubles(const double *data, size_t n) {
+  size_t i = 0;
+  double total = 0.0;
+#ifdef DOTLIN_HAVE_SSE2
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+  for (; i + 4 <= n; i += 4) {
+    acc0 = _mm_add_pd(acc0, _mm_loadu_pd(data + i));
+    acc1 = _mm_add_pd(acc1, _mm_loadu_pd(data + i + 2));
+  }
+  alignas(16) double lanes[2];
+  _mm_store_pd(lanes, _mm_add_pd(acc0, acc1));
+  total = lanes[0] + lanes[1];
+#endif
+  for (; i < n; ++i) {
+    total += data[i];
+  }
+  return total;
+}
+
+int minInts(const int *data, size_t n) {
+  size_t i = 0;
+  int best = data[0];
+#ifdef DOTLIN_HAVE_SSE2
+  if (n >= 4) {
+    __m128i m = _mm_set1_epi32(best);
+    for (; i + 4 <= n; i += 4) {
+      __m128i v =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+      __m128i lt = _mm_cmplt_epi32(v, m);
+      m = _mm_or_si128(_mm_and_si128(lt, v), _mm_andnot_si128(lt, m));
+    }
+    alignas(16) int lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), m);
+    best = *std::min_element(lanes, lanes + 4);
+  }
+#endif
+  for (; i < n; ++i) {
+    best = std::min(best, data[i]);
+  }
+  return best;
+}
+
+int maxInts(const int *data, size_t n) {
+  size_t i = 0;
+  int best = data[0];
+#ifdef DOTLIN_HAVE_SSE2
+  if (n >= 4) {
+    __m128i m = _mm_set1_epi32(best);
+    for (; i + 4 <= n; i += 4) {
+      __m128i v =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+      __m128i gt = _mm_cmpgt_epi32(v, m);
+      m = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, m));
+    }
+    alignas(16) int lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), m);
+    best = *std::max_element(lanes, lanes + 4);
+  }
+#endif
+  for (; i < n; ++i) {
+    best = std::max(best, data[i]);
+  }
+  return best;
+}
+
+// Like Kotlin, a NaN anywhere in the array makes min/max NaN
+double minDoubles(const double *data, size_t n) {
+  size_t i = 0;
+  double best = data[0];
+#ifdef DOTLIN_HAVE_SSE2
+  if (n >= 2) {
+    __m128d m = _mm_set1_pd(best);
+    __m128d nan = _mm_setzero_pd();
+    for (; i + 2 <= n; i += 2) {
+      __m128d v = _mm_loadu_pd(data + i);
+      nan = _mm_or_pd(nan, _mm_cmpunord_pd(v, v));
+      m = _mm_min_pd(m, v);
+    }
+    if (_mm_movemask_pd(nan) != 0) {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, m);
+    best = std::min(lanes[0], lanes[1]);
+  }
+#endif
+  for (; i < n; ++i) {
+    if (std::isnan(data[i]))
+      return data[i];
+    best = std::min(best, data[i]);
+  }
+  return best;
+}
+
+double maxDoubles(const double *data, size_t n) {
+  size_t i = 0;
+  double best = data[0];
+#ifdef DOTLIN_HAVE_SSE2
+  if (n >= 2) {
+    __m128d m = _mm_set1_pd(best);
+    __m128d nan = _mm_setzero_pd();
+    for (; i + 2 <= n; i += 2) {
+      __m128d v = _mm_loadu_pd(data + i);
+      nan = _mm_or_pd(nan, _mm_cmpunord_pd(v, v));
+      m = _mm_max_pd(m, v);
+    }
+    if (_mm_movemask_pd(nan) != 0) {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, m);
+    best = std::max(lanes[0], lanes[1]);
+  }
+#endif
+  for (; i < n; ++i) {
+    if (std::isnan(data[i]))
+      return data[i];
+    best = std::max(best, data[i]);
+  }
+  return best;
+}
+
+std::ptrdiff_t indexOfInt(const int *data, size_t n, int needle) {
+  size_t i = 0;
+#ifdef DOTLIN_HAVE_SSE2
+  __m128i target = _mm_set1_epi32(needle);
+  for (; i + 4 <= n; i += 4) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, target)));
+    if (mask != 0) {
+      return static_cast<std::ptrdiff_t>(
+          i + static_cast<size_t>(std::countr_zero(static_cast<unsigned>(mask))));
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    if (data[i] == needle)
+      return static_cast<std::ptrdiff_t>(i);
+  }
+  return -1;
+}
+
+std::ptrdiff_t indexOfDouble(const double *data, size_t n, double needle) {
+  size_t i = 0;
+#ifdef DOTLIN_HAVE_SSE2
+  __m128d target = _mm_set1_pd(needle);
+  for (; i + 2 <= n; i += 2) {
+    int mask = _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(data + i), target));
+    if (mask != 0) {
+      return static_cast<std::ptrdiff_t>(
+          i + static_cast<size_t>(std::countr_zero(static_cast<unsigned>(mask))));
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    if (data[i] == needle)
+      return static_cast<std::ptrdiff_t>(i);
+  }
+  return -1;
+}
+
+// ---- Array-level operations ----
+
+namespace {
+
+bool isNumber(const Value &v) {
+  return std::holds_alternative<int>(v) || std::holds_alternative<int64_t>(v) ||
+         std::holds_alternative<double>(v);
+}
+
+double toDouble(const Value &v) {
+  if (auto *i = std::get_if<int>(&v))
+    return static_cast<double>(*i);
+  if (auto *l = std::get_if<int64_t>(&v))
+    return static_cast<double>(*l);
+  return std::get<double>(v);
+}
+
+// Pick the smallest (or largest) element of a boxed array
+Value extremeOfValues(const std::vector<Value> &values, bool wantMax) {
+  const Value *best = &values[0];
+  for (size_t i = 1; i < values.size(); ++i) {
+    const Value &candidate = values[i];
+    bool better = false;
+    if (isNumber(candidate) && isNumber(*best)) {
+      double c = toDouble(candidate);
+      double b = toDouble(*best);
+      better = wantMax ? c > b : c < b;
+    } else if (std::holds_alternative<std::string>(candidate) &&
+               std::holds_alternative<std::string>(*best)) {
+      const auto &c = std::get<std::string>(candidate);
+      const auto &b = std::get<std::string>(*best);
+      better = wantMax ? c > b : c < b;
+    } else {
+      throw std::runtime_error(
+          std::string(wantMax ? "max" : "min") +
+          "() requires an array of numbers or strings");
+    }
+    if (better) {
+      best = &candidate;
+    }
+  }
+  return *best;
+}
+
+} // namespace
+
+Value arraySum(const ArrayValue &array) {
+  if (auto ints = array.elements<int>()) {
+    // Int sums wrap around like Kotlin's IntArray.sum()
+    return Value(static_cast<int>(sumInts(ints->data(), ints->size())));
+  }
+  if (auto doubles = array.elements<double>()) {
+    return Value(sumDoubles(doubles->data(), doubles->size()));
+  }
+  if (auto longs = array.elements<int64_t>()) {
+    // Wraps around like LongArray.sum()
+    uint64_t total = 0;
+    for (int64_t element : *longs) {
+      total += static_cast<uint64_t>(element);
+    }
+    return Value(static_cast<int64_t>(total));
+  }
+  if (array.bools()) {
+    throw std::runtime_error("sum() requires a numeric array");
+  }
+
+  int intTotal = 0;
+  int64_t longTotal = 0;
+  double doubleTotal = 0.0;
+  bool sawLong = false;
+  bool sawDouble = false;
+  for (const auto &element : *array.values()) {
+    if (auto *i = std::get_if<int>(&element)) {
+      intTotal = static_cast<int>(static_cast<unsigned>(intTotal) +
+                                  static_cast<unsigned>(*i));
+      longTotal += *i;
+      doubleTotal += *i;
+    } else if (auto *l = std::get_if<int64_t>(&element)) {
+      sawLong = true;
+      longTotal += *l;
+      doubleTotal += static_cast<double>(*l);
+    } else if (auto *d = std::get_if<double>(&element)) {
+      sawDouble = true;
+      doubleTotal += *d;
+    } else {
+      throw std::runtime_error("sum() requires a numeric array");
+    }
+  }
+  if (sawDouble)
+    return Value(doubleTotal);
+  if (sawLong)
+    return Value(longTotal);
+  return Value(intTotal);
+}
+
+Value arrayMin(const ArrayValue &array) {
+  if (array.empty()) {
+    throw std::runtime_error("min() called on an empty array");
+  }
+  if (auto ints = array.elements<int>())
+    return Value(minInts(ints->data(), ints->size()));
+  if (auto doubles = array.elements<double>())
+    return Value(minDoubles(doubles->data(), doubles->size()));
+  if (auto longs = array.elements<int64_t>())
+    return Value(*std::min_element(longs->begin(), longs->end()));
+  if (auto *bools = array.bools())
+    return Value(std::find(bools->begin(), bools->end(), false) ==
+                 bools->end());
+  return extremeOfValues(*array.values(), false);
+}
+
+Value arrayMax(const ArrayValue &array) {
+  if (array.empty()) {
+    throw std::runtime_error("max() called on an empty array");
+  }
+  if (auto ints = array.elements<int>())
+    return Value(maxInts(ints->data(), ints->size()));
+  if (auto doubles = array.elements<double>())
+    return Value(maxDoubles(doubles->data(), doubles->size()));
+  if (auto longs = array.elements<int64_t>())
+    return Value(*std::max_element(longs->begin(), longs->end()));
+  if (auto *bools = array.bools())
+    return Value(std::find(bools->begin(), bools->end(), true) !=
+                 bools->end());
+  return extremeOfValues(*array.values(), true);
+}
+
+Value arrayAverage(const ArrayValue &array) {
+  if (array.empty()) {
+    return Value(std::numeric_limits<double>::quiet_NaN());
+  }
+  double count = static_cast<double>(array.size());
+  if (auto ints = array.elements<int>()) {
+    return Value(static_cast<double>(sumInts(ints->data(), ints->size())) /
+                 count);
+  }
+  if (auto doubles = array.elements<double>()) {
+    return Value(sumDoubles(doubles->data(), doubles->size()) / count);
+  }
+  double total = 0.0;
+  if (auto longs = array.elements<int64_t>()) {
+    for (int64_t element : *longs) {
+      total += static_cast<double>(element);
+    }
+    return Value(total / count);
+  }
+  if (auto *values = array.values()) {
+    for (const auto &element : *values) {
+      if (!isNumber(element)) {
+        throw std::runtime_error("average() requires a numeric array");
+      }
+      total += toDouble(element);
+    }
+    return Value(total / count);
+  }
+  throw std::runtime_error("average() requires a numeric array");
+}
+
+std::ptrdiff_t arrayIndexOf(const ArrayValue &array, const Value &needle) {
+  // Unboxed stores only ever match numbers that valuesEqual would accept
+  if (auto ints = array.elements<int>()) {
+    if (!isNumber(needle))
+      return -1;
+    double wanted = toDouble(needle);
+    if (wanted != std::floor(wanted) ||
+        wanted < static_cast<double>(std::numeric_limits<int>::min()) ||
+        wanted > static_cast<double>(std::numeric_limits<int>::max()))
+      return -1;
+    return indexOfInt(ints->data(), ints->size(), static_cast<int>(wanted));
+  }
+  if (auto doubles = array.elements<double>()) {
+    if (!isNumber(needle))
+      return -1;
+    return indexOfDouble(doubles->data(), doubles->size(), toDouble(needle));
+  }
+  if (auto *bools = array.bools()) {
+    auto *wanted = std::get_if<bool>(&needle);
+    if (!wanted)
+      return -1;
+    auto it = std::find(bools->begin(), bools->end(), *wanted);
+    return it == bools->end() ? -1 : std::distance(bools->begin(), it);
+  }
+  if (auto *values = array.values()) {
+    for (size_t i = 0; i < values->size(); ++i) {
+      if (valuesEqual((*values)[i], needle))
+        return static_cast<std::ptrdiff_t>(i);
+    }
+    return -1;
+  }
+  for (size_t i = 0; i < array.size(); ++i) {
+    if (valuesEqual(array.at(i), needle))
+      return static_cast<std::ptrdiff_t>(i);
+  }
+  return -1;
+}
+
+} // namespace dotlin
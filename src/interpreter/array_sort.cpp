@@ -0,0 +1,283 @@
+#include "dotlin/array_sort.h"
+#include "dotlin/array_functions.h"
+#include "dotlin/lambda_frame.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace dotlin {
+
+namespace {
+
+// Below this size std::sort on the keys beats the radix passes
+constexpr size_t kRadixThreshold = 256;
+
+// LSD radix sort over unsigned keys, one byte per pass. Passes where every
+// key has the same byte are skipped, so small ranges cost fewer passes.
+template <typename Key> void radixSort(std::vector<Key> &keys) {
+  if (keys.size() < kRadixThreshold) {
+    std::sort(keys.begin(), keys.end());
+    return;
+  }
+  std::vector<Key> buffer(keys.size());
+  for (unsigned shift = 0; shift < sizeof(Key) * 8; shift += 8) {
+    size_t counts[256] = {};
+    for (Key key : keys) {
+      ++counts[(key >> shift) & 0xff];
+    }
+    if (counts[(keys[0] >> shift) & 0xff] == keys.size()) {
+      continue;
+    }
+    size_t offset = 0;
+    for (size_t &count : counts) {
+      size_t c = count;
+      count = offset;
+      offset += c;
+    }
+    for (Key key : keys) {
+      buffer[counts[(key >> shift) & 0xff]++] = key;
+    }
+    keys.swap(buffer);
+  }
+}
+
+// Unsigned keys whose order matches Kotlin's total order on doubles
+uint64_t doubleKey(double value) {
+  if (std::isnan(value)) {
+    value = std::numeric_limits<double>::quiet_NaN();
+  }
+  uint64_t bits = std::bit_cast<uint64_t>(value);
+  return (bits >> 63) ? ~bits : bits | (uint64_t{1} << 63);
+}
+
+double keyToDouble(uint64_t key) {
+  uint64_t bits = (key >> 63) ? key & ~(uint64_t{1} << 63) : ~key;
+  return std::bit_cast<double>(bits);
+}
+
+bool isNumber(const Value &value) {
+  return std::holds_alternative<int>(value) ||
+         std::holds_alternative<int64_t>(value) ||
+         std::holds_alternative<double>(value);
+}
+
+int64_t asLong(const Value &value) {
+  if (auto *i = std::get_if<int>(&value)) {
+    return *i;
+  }
+  return std::get<int64_t>(value);
+}
+
+double asDouble(const Value &value) {
+  if (auto *d = std::get_if<double>(&value)) {
+    return *d;
+  }
+  return static_cast<double>(asLong(value));
+}
+
+// Sign of a comparator lambda's result
+int comparatorSign(const Value &result) {
+  if (auto *i = std::get_if<int>(&result)) {
+    return (*i > 0) - (*i < 0);
+  }
+  if (auto *l = std::get_if<int64_t>(&result)) {
+    return (*l > 0) - (*l < 0);
+  }
+  throw std::runtime_error("sortedWith comparator must return an Int");
+}
+
+} // namespace
+
+// Flipping the sign bit makes the unsigned order match the signed one
+void sortInts(std::vector<int> &data) {
+  std::vector<uint32_t> keys;
+  keys.reserve(data.size());
+  for (int value : data) {
+    keys.push_back(static_cast<uint32_t>(value) ^ 0x80000000u);
+  }
+  radixSort(keys);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    data[i] = static_cast<int>(keys[i] ^ 0x80000000u);
+  }
+}
+
+void sortDoubles(std::vector<double> &data) {
+  std::vector<uint64_t> keys;
+  keys.reserve(data.size());
+  for (double value : data) {
+    keys.push_back(doubleKey(value));
+  }
+  radixSort(keys);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    data[i] = keyToDouble(keys[i]);
+  }
+}
+
+namespace {
+
+ArrayValue sortedCopy(const ArrayValue &array, bool descending) {
+  if (auto ints = array.elements<int>()) {
+    std::vector<int> data(ints->begin(), ints->end());
+    sortInts(data);
+    if (descending) {
+      std::reverse(data.begin(), data.end());
+    }
+    return ArrayValue(std::move(data));
+  }
+  if (auto doubles = array.elements<double>()) {
+    std::vector<double> data(doubles->begin(), doubles->end());
+    sortDoubles(data);
+    if (descending) {
+      std::reverse(data.begin(), data.end());
+    }
+    return ArrayValue(std::move(data));
+  }
+  if (auto longs = array.elements<int64_t>()) {
+    std::vector<int64_t> data(longs->begin(), longs->end());
+    std::sort(data.begin(), data.end());
+    if (descending) {
+      std::reverse(data.begin(), data.end());
+    }
+    return ArrayValue(std::move(data));
+  }
+  if (auto *bools = array.bools()) {
+    size_t trues = static_cast<size_t>(
+        std::count(bools->begin(), bools->end(), true));
+    std::vector<bool> data(bools->size(), !descending);
+    std::fill_n(data.begin(), descending ? trues : bools->size() - trues,
+                descending);
+    return ArrayValue(std::move(data));
+  }
+
+  std::vector<Value> data = array.toValues();
+  if (array.elementType() == ArrayElementType::STRING) {
+    // Equal strings are indistinguishable, so stability does not matter
+    std::sort(data.begin(), data.end(), [](const Value &a, const Value &b) {
+      return std::get<std::string>(a) < std::get<std::string>(b);
+    });
+    if (descending) {
+      std::reverse(data.begin(), data.end());
+    }
+  } else {
+    std::stable_sort(data.begin(), data.end(),
+                     [descending](const Value &a, const Value &b) {
+                       int c = compareValues(a, b);
+                       return descending ? c > 0 : c < 0;
+                     });
+  }
+  return ArrayValue(std::move(data));
+}
+
+// Kotlin's convention: the index if found, else -(insertion point) - 1
+int binarySearch(const ArrayValue &array, const Value &needle) {
+  size_t low = 0;
+  size_t high = array.size();
+  auto ints = array.elements<int>();
+  auto *needleInt = std::get_if<int>(&needle);
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    int c = ints && needleInt
+                ? ((*ints)[mid] > *needleInt) - ((*ints)[mid] < *needleInt)
+                : compareValues(array.at(mid), needle);
+    if (c < 0) {
+      low = mid + 1;
+    } else if (c > 0) {
+      high = mid;
+    } else {
+      return static_cast<int>(mid);
+    }
+  }
+  return -static_cast<int>(low) - 1;
+}
+
+} // namespace
+
+int compareValues(const Value &lhs, const Value &rhs) {
+  if (isNumber(lhs) && isNumber(rhs)) {
+    if (!std::holds_alternative<double>(lhs) &&
+        !std::holds_alternative<double>(rhs)) {
+      int64_t a = asLong(lhs);
+      int64_t b = asLong(rhs);
+      return (a > b) - (a < b);
+    }
+    uint64_t a = doubleKey(asDouble(lhs));
+    uint64_t b = doubleKey(asDouble(rhs));
+    return (a > b) - (a < b);
+  }
+  auto *ls = std::get_if<std::string>(&lhs);
+  auto *rs = std::get_if<std::string>(&rhs);
+  if (ls && rs) {
+    int c = ls->compare(*rs);
+    return (c > 0) - (c < 0);
+  }
+  auto *lb = std::get_if<bool>(&lhs);
+  auto *rb = std::get_if<bool>(&rhs);
+  if (lb && rb) {
+    return static_cast<int>(*lb) - static_cast<int>(*rb);
+  }
+  throw std::runtime_error("Cannot compare " + getTypeOfValue(lhs) + " and " +
+                           getTypeOfValue(rhs));
+}
+
+Value callArraySort(Interpreter &interpreter, ArrayValue &array,
+                    const std::string &method,
+                    const std::vector<Value> &args) {
+  if ((method == "sort" || method == "sortDescending") && args.empty()) {
+    array.assignFrom(sortedCopy(array, method == "sortDescending"));
+    return Value();
+  }
+  if ((method == "sorted" || method == "sortedDescending") && args.empty()) {
+    return Value(sortedCopy(array, method == "sortedDescending"));
+  }
+
+  if (method == "sortedBy" || method == "sortedByDescending") {
+    // Each key is computed once, then the indices are sorted by key
+    bool descending = method == "sortedByDescending";
+    LambdaFrame frame(interpreter, lambdaArg(args, 0, method), 1,
+                      "lambda@" + method);
+    size_t n = array.size();
+    std::vector<Value> keys;
+    keys.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+      keys.push_back(frame.call(array.at(i)));
+    }
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      int c = compareValues(keys[a], keys[b]);
+      return descending ? c > 0 : c < 0;
+    });
+    std::vector<Value> out;
+    out.reserve(n);
+    for (size_t index : order) {
+      out.push_back(array.at(index));
+    }
+    return Value(ArrayValue(std::move(out)));
+  }
+
+  if (method == "sortedWith") {
+    LambdaFrame frame(interpreter, lambdaArg(args, 0, method), 2,
+                      "lambda@sortedWith");
+    std::vector<Value> data = array.toValues();
+    std::stable_sort(data.begin(), data.end(),
+                     [&](const Value &a, const Value &b) {
+                       return comparatorSign(frame.call(a, b)) < 0;
+                     });
+    return Value(ArrayValue(std::move(data)));
+  }
+
+  if (method == "binarySearch") {
+    if (args.size() != 1) {
+      throw std::runtime_error("binarySearch expects the element to find");
+    }
+    return Value(binarySearch(array, args[0]));
+  }
+
+  throw std::runtime_error("Cannot call method '" + method + "' on an array");
+}
+
+} // namespace dotlin
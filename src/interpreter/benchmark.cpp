@@ -0,0 +1,110 @@
+#include "dotlin/benchmark.h"
+#include "dotlin/collections.h"
+#include "dotlin/lambda_frame.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace dotlin {
+
+namespace {
+
+// Smallest gap between two back-to-back clock reads; every sample pays it
+int64_t clockOverhead() {
+  int64_t best = INT64_MAX;
+  for (int i = 0; i < 64; ++i) {
+    int64_t start = nanoTime();
+    best = std::min(best, nanoTime() - start);
+  }
+  return best;
+}
+
+std::string formatDuration(int64_t ns) {
+  char text[32];
+  if (ns < 1000) {
+    std::snprintf(text, sizeof text, "%lld ns", static_cast<long long>(ns));
+  } else if (ns < 1000000) {
+    std::snprintf(text, sizeof text, "%.2f us", static_cast<double>(ns) / 1e3);
+  } else if (ns < 1000000000) {
+    std::snprintf(text, sizeof text, "%.2f ms", static_cast<double>(ns) / 1e6);
+  } else {
+    std::snprintf(text, sizeof text, "%.2f s", static_cast<double>(ns) / 1e9);
+  }
+  return text;
+}
+
+} // namespace
+
+int64_t nanoTime() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+BenchmarkStats runBenchmark(Interpreter &interpreter,
+                            const std::shared_ptr<LambdaValue> &body,
+                            size_t iterations) {
+  LambdaFrame frame(interpreter, body, 0, "lambda@benchmark");
+  for (size_t i = 0; i < std::max<size_t>(1, iterations / 10); ++i) {
+    frame.call();
+  }
+
+  int64_t overhead = clockOverhead();
+  std::vector<int64_t> samples(iterations);
+  for (int64_t &sample : samples) {
+    int64_t start = nanoTime();
+    frame.call();
+    sample = nanoTime() - start;
+  }
+
+  BenchmarkStats stats;
+  stats.iterations = iterations;
+  if (iterations == 0) {
+    return stats;
+  }
+  int64_t total = 0;
+  for (int64_t &sample : samples) {
+    sample = std::max<int64_t>(0, sample - overhead);
+    total += sample;
+  }
+  std::sort(samples.begin(), samples.end());
+  size_t n = samples.size();
+  stats.minNs = samples.front();
+  stats.medianNs = n % 2 ? samples[n / 2]
+                         : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+  // Nearest rank: the smallest sample with at least 99% at or below it
+  stats.p99Ns = samples[(n * 99 + 99) / 100 - 1];
+  stats.meanNs = total / static_cast<int64_t>(n);
+  stats.opsPerSecond = total > 0 ? static_cast<double>(n) * 1e9 /
+                                       static_cast<double>(total)
+                                 : 0.0;
+  return stats;
+}
+
+std::string formatBenchmark(const std::string &name,
+                            const BenchmarkStats &stats) {
+  char rate[32];
+  std::snprintf(rate, sizeof rate, "%.0f", stats.opsPerSecond);
+  return name + ": " + std::to_string(stats.iterations) +
+         " iterations, min " + formatDuration(stats.minNs) + ", median " +
+         formatDuration(stats.medianNs) + ", p99 " +
+         formatDuration(stats.p99Ns) + ", " + rate + " ops/s";
+}
+
+Value benchmarkResult(const std::string &name, const BenchmarkStats &stats) {
+  auto map = std::make_shared<MapValue>();
+  auto put = [&](const char *key, Value value) {
+    mapSet(*map, Value(std::string(key)), value);
+  };
+  put("name", Value(name));
+  put("iterations", Value(static_cast<int>(stats.iterations)));
+  put("minNs", Value(stats.minNs));
+  put("medianNs", Value(stats.medianNs));
+  put("p99Ns", Value(stats.p99Ns));
+  put("meanNs", Value(stats.meanNs));
+  put("opsPerSecond", Value(stats.opsPerSecond));
+  return Value(map);
+}
+
+} // namespace dotlin
@@ -1,5 +1,17 @@
+#include "dotlin/array_kernels.h"
+#include "dotlin/benchmark.h"
+#include "dotlin/collections.h"
+#include "dotlin/csv.h"
+#include "dotlin/file_io.h"
+#include "dotlin/input.h"
+#include "dotlin/json.h"
 #include "dotlin/interpreter.h"
+#include "dotlin/number_format.h"
 #include "dotlin/parser.h"
+#include "dotlin/sequence.h"
+#include "dotlin/serialize.h"
+#include "dotlin/string_builder.h"
+#include "dotlin/string_kernels.h"
 #include <algorithm>
 #include <chrono>
 #include <cmath>
@@ -9,6 +21,7 @@
 #include <iostream>
 #include <sstream>
 #include <thread>
+#include <unordered_set>
 
 namespace fs = std::filesystem;
 
@@ -20,51 +33,102 @@ std::string valueToString(const Value &value);
 bool valuesEqual(const Value &v1, const Value &v2);
 } // namespace dotlin
 
+bool Interpreter::isBuiltinFunction(const std::string &name) {
+  static const std::unordered_set<std::string> names = {
+      "println", "print", "sqrt", "abs", "pow", "readln", "arrayOf", "sin",
+      "cos", "tan", "min", "max", "round", "ceil", "floor", "random", "clock",
+      "seed", "randomInt", "randomDouble", "randomInts", "randomDoubles",
+      "shuffle", "exit", "readLine", "flush", "readInts", "readDoubles",
+      "readWords", "readAllLines", "File", "forEachLine", "openWriter",
+      "saveArray", "mapArray", "readCsv", "serialize", "deserialize",
+      "parseJson", "toJson", "toInt", "toString", "format", "readFile",
+      "writeFile", "exists", "now", "currentTimeMillis", "nanoTime",
+      "benchmark", "sleep", "printStackTrace", "generateSequence", "to",
+      "mapOf", "mutableMapOf", "hashMapOf", "setOf", "mutableSetOf",
+      "hashSetOf", "StringBuilder"};
+  return names.count(name) > 0;
+}
+
 Value Interpreter::executeBuiltinFunction(
     const std::string &name,
     const std::vector<std::shared_ptr<Expression>> &arguments) {
   // Debugging functions
   if (name == "printStackTrace") {
-    std::cout << "Stack Trace:";
+    std::string trace = "Stack Trace:";
     for (const auto &frame : callStack) {
-      std::cout << "\n  at " << frame;
+      trace += "\n  at " + frame;
     }
-    std::cout << std::endl;
+    output->write(trace + "\n");
     return Value();
   }
 
   // I/O functions
+  // Output goes through the interpreter's buffered sink, one write per call
   if (name == "println") {
-    if (arguments.empty()) {
-      std::cout << std::endl;
-      return Value();
-    }
+    std::string line;
     for (size_t i = 0; i < arguments.size(); ++i) {
-      Value arg = evaluate(*arguments[i]);
-      std::cout << valueToString(arg);
-      if (i == arguments.size() - 1) {
-        std::cout << std::endl;
-      } else {
-        std::cout << " ";
+      if (i > 0) {
+        line += ' ';
       }
+      appendValueString(line, evaluate(*arguments[i]));
     }
+    line += '\n';
+    output->write(line);
     return Value();
   }
 
   if (name == "print") {
+    std::string text;
     for (const auto &arg : arguments) {
-      Value argValue = evaluate(*arg);
-      std::cout << valueToString(argValue);
+      appendValueString(text, evaluate(*arg));
     }
+    output->write(text);
+    return Value();
+  }
+
+  if (name == "flush") {
+    if (!arguments.empty()) {
+      throw std::runtime_error("flush() expects no arguments");
+    }
+    output->flush();
     return Value();
   }
 
   if (name == "readln") {
+    // Show pending output, such as a prompt, before waiting for input
+    output->flush();
     std::string input;
-    std::getline(std::cin, input);
+    standardInput().readLine(input);
     return Value(input);
   }
 
+  if (name == "readInts" || name == "readDoubles") {
+    if (arguments.size() > 1) {
+      throw std::runtime_error(name + "() expects at most 1 argument");
+    }
+    std::optional<size_t> count;
+    if (arguments.size() == 1) {
+      Value n = evaluate(*arguments[0]);
+      auto *nInt = std::get_if<int>(&n);
+      if (!nInt || *nInt < 0) {
+        throw std::runtime_error(name + "() expects a non-negative count");
+      }
+      count = static_cast<size_t>(*nInt);
+    }
+    output->flush();
+    return Value(name == "readInts" ? standardInput().readInts(count)
+                                    : standardInput().readDoubles(count));
+  }
+
+  if (name == "readWords" || name == "readAllLines") {
+    if (!arguments.empty()) {
+      throw std::runtime_error(name + "() expects no arguments");
+    }
+    output->flush();
+    return Value(name == "readWords" ? standardInput().readWords()
+                                     : standardInput().readAllLines());
+  }
+
   // Mathematical functions
   if (name == "sqrt") {
     if (arguments.size() != 1) {
@@ -214,10 +278,78 @@ Value Interpreter::executeBuiltinFunction(
     throw std::runtime_error("floor() expects a number");
   }
 
-  if (name == "random") {
+  // Random numbers come from the interpreter's own generator
+  if (name == "random" || name == "randomDouble") {
     if (arguments.size() != 0)
-      throw std::runtime_error("random() expects 0 arguments");
-    return Value(static_cast<double>(std::rand()) / RAND_MAX);
+      throw std::runtime_error(name + "() expects 0 arguments");
+    return Value(rng.nextDouble());
+  }
+  if (name == "seed") {
+    if (arguments.size() != 1)
+      throw std::runtime_error("seed() expects 1 argument");
+    Value arg = evaluate(*arguments[0]);
+    if (auto *num = std::get_if<int>(&arg)) {
+      rng.seed(static_cast<uint64_t>(*num));
+    } else if (auto *lnum = std::get_if<int64_t>(&arg)) {
+      rng.seed(static_cast<uint64_t>(*lnum));
+    } else {
+      throw std::runtime_error("seed() expects an Int or Long");
+    }
+    return Value();
+  }
+  if (name == "randomInt") {
+    // randomInt(from, until) like Kotlin's Random.nextInt: until is
+    // exclusive, and Long bounds give a Long
+    if (arguments.size() != 2)
+      throw std::runtime_error("randomInt() expects 2 arguments");
+    Value from = evaluate(*arguments[0]);
+    Value until = evaluate(*arguments[1]);
+    auto *intFrom = std::get_if<int>(&from);
+    auto *intUntil = std::get_if<int>(&until);
+    auto *longFrom = std::get_if<int64_t>(&from);
+    auto *longUntil = std::get_if<int64_t>(&until);
+    if ((!intFrom && !longFrom) || (!intUntil && !longUntil))
+      throw std::runtime_error("randomInt() expects Int or Long bounds");
+    int64_t low = intFrom ? *intFrom : *longFrom;
+    int64_t high = intUntil ? *intUntil : *longUntil;
+    if (low >= high)
+      throw std::runtime_error("randomInt() expects from < until");
+    int64_t result = rng.nextInRange(low, high);
+    if (intFrom && intUntil)
+      return Value(static_cast<int>(result));
+    return Value(result);
+  }
+  if (name == "randomInts" || name == "randomDoubles") {
+    // The whole array is filled natively, one call for any count
+    bool ints = name == "randomInts";
+    if (arguments.size() != (ints ? 3u : 1u))
+      throw std::runtime_error(name + (ints ? "() expects 3 arguments"
+                                            : "() expects 1 argument"));
+    Value count = evaluate(*arguments[0]);
+    auto *n = std::get_if<int>(&count);
+    if (!n || *n < 0)
+      throw std::runtime_error(name + "() expects a non-negative count");
+    if (!ints)
+      return Value(ArrayValue(rng.doubles(static_cast<size_t>(*n))));
+    Value from = evaluate(*arguments[1]);
+    Value until = evaluate(*arguments[2]);
+    auto *low = std::get_if<int>(&from);
+    auto *high = std::get_if<int>(&until);
+    if (!low || !high)
+      throw std::runtime_error("randomInts() expects Int bounds");
+    if (*low >= *high)
+      throw std::runtime_error("randomInts() expects from < until");
+    return Value(ArrayValue(rng.ints(static_cast<size_t>(*n), *low, *high)));
+  }
+  if (name == "shuffle") {
+    if (arguments.size() != 1)
+      throw std::runtime_error("shuffle() expects 1 argument");
+    Value arg = evaluate(*arguments[0]);
+    auto *array = std::get_if<ArrayValue>(&arg);
+    if (!array)
+      throw std::runtime_error("shuffle() expects an array");
+    shuffleArray(rng, *array);
+    return Value();
   }
 
   // String functions
@@ -230,7 +362,7 @@ Value Interpreter::executeBuiltinFunction(
       return Value(static_cast<int>(str->length()));
     }
     if (auto *array = std::get_if<ArrayValue>(&arg)) {
-      return Value(static_cast<int>(array->elements->size()));
+      return Value(static_cast<int>(array->size()));
     }
     throw std::runtime_error("length() expects a string or array");
   }
@@ -266,8 +398,7 @@ Value Interpreter::executeBuiltinFunction(
     Value arg = evaluate(*arguments[0]);
     if (auto *str = std::get_if<std::string>(&arg)) {
       std::string upperStr = *str;
-      std::transform(upperStr.begin(), upperStr.end(), upperStr.begin(),
-                     ::toupper);
+      asciiToUpper(upperStr.data(), upperStr.data(), upperStr.size());
       return Value(upperStr);
     }
     throw std::runtime_error("toUpperCase() expects a string");
@@ -280,8 +411,7 @@ Value Interpreter::executeBuiltinFunction(
     Value arg = evaluate(*arguments[0]);
     if (auto *str = std::get_if<std::string>(&arg)) {
       std::string lowerStr = *str;
-      std::transform(lowerStr.begin(), lowerStr.end(), lowerStr.begin(),
-                     ::tolower);
+      asciiToLower(lowerStr.data(), lowerStr.data(), lowerStr.size());
       return Value(lowerStr);
     }
     throw std::runtime_error("toLowerCase() expects a string");
@@ -289,11 +419,57 @@ Value Interpreter::executeBuiltinFunction(
 
   // Array functions
   if (name == "arrayOf") {
-    ArrayValue array;
+    std::vector<Value> elements;
+    elements.reserve(arguments.size());
+    for (const auto &arg : arguments) {
+      elements.push_back(evaluate(*arg));
+    }
+    return Value(ArrayValue(std::move(elements)));
+  }
+
+  if (name == "generateSequence") {
+    if (arguments.size() != 2) {
+      throw std::runtime_error(
+          "generateSequence() expects a seed and a lambda");
+    }
+    Value seed = evaluate(*arguments[0]);
+    Value next = evaluate(*arguments[1]);
+    if (auto *lambda = std::get_if<std::shared_ptr<LambdaValue>>(&next)) {
+      return Value(dotlin::generateSequence(seed, *lambda));
+    }
+    throw std::runtime_error("generateSequence() expects a lambda");
+  }
+
+  if (name == "StringBuilder") {
+    auto builder = std::make_shared<StringBuilderValue>();
+    if (arguments.size() == 1) {
+      builder->buffer = valueToString(evaluate(*arguments[0]));
+    } else if (!arguments.empty()) {
+      throw std::runtime_error("StringBuilder() expects at most 1 argument");
+    }
+    return Value(builder);
+  }
+
+  // Map and set functions
+  if (name == "to") {
+    if (arguments.size() != 2) {
+      throw std::runtime_error("to expects a key and a value");
+    }
+    return makePair(evaluate(*arguments[0]), evaluate(*arguments[1]));
+  }
+
+  if (name == "mapOf" || name == "mutableMapOf" || name == "hashMapOf" ||
+      name == "setOf" || name == "mutableSetOf" || name == "hashSetOf") {
+    std::vector<Value> elements;
+    elements.reserve(arguments.size());
     for (const auto &arg : arguments) {
-      array.elements->push_back(evaluate(*arg));
+      elements.push_back(evaluate(*arg));
+    }
+    bool isMutable = name != "mapOf" && name != "setOf";
+    if (name == "mapOf" || name == "mutableMapOf" || name == "hashMapOf") {
+      return Value(makeMap(elements, isMutable));
     }
-    return Value(array);
+    return Value(makeSet(elements, isMutable));
   }
 
   if (name == "indexOf") {
@@ -304,12 +480,7 @@ Value Interpreter::executeBuiltinFunction(
     Value element = evaluate(*arguments[1]);
 
     if (auto *arrayVal = std::get_if<ArrayValue>(&array)) {
-      for (size_t i = 0; i < arrayVal->elements->size(); ++i) {
-        if (valuesEqual((*arrayVal->elements)[i], element)) {
-          return Value(static_cast<int>(i));
-        }
-      }
-      return Value(-1); // Not found
+      return Value(static_cast<int>(arrayIndexOf(*arrayVal, element)));
     }
     throw std::runtime_error("indexOf() expects an array");
   }
@@ -362,11 +533,10 @@ Value Interpreter::executeBuiltinFunction(
     }
     Value arg = evaluate(*arguments[0]);
     if (auto *str = std::get_if<std::string>(&arg)) {
-      try {
-        return Value(std::stoi(*str));
-      } catch (...) {
-        throw std::runtime_error("Cannot convert string to int");
+      if (auto parsed = parseInt(*str)) {
+        return Value(*parsed);
       }
+      throw std::runtime_error("Cannot convert string to int");
     }
     if (auto *num = std::get_if<int>(&arg)) {
       return Value(*num);
@@ -388,9 +558,13 @@ Value Interpreter::executeBuiltinFunction(
       }
     }
 
-    std::cout << prompt;
+    output->write(prompt);
+    output->flush();
+    // Like Kotlin, null once the input has ended
     std::string input;
-    std::getline(std::cin, input);
+    if (!standardInput().readLine(input)) {
+      return Value(std::string("null"));
+    }
     return Value(input);
   }
 
@@ -401,6 +575,8 @@ Value Interpreter::executeBuiltinFunction(
     }
     Value code = evaluate(*arguments[0]);
     if (auto *codeInt = std::get_if<int>(&code)) {
+      // std::exit skips the destructors that would flush the output
+      output->flush();
       std::exit(*codeInt);
     }
     throw std::runtime_error("exit() expects an integer");
@@ -428,6 +604,34 @@ Value Interpreter::executeBuiltinFunction(
     return Value(static_cast<int64_t>(micros.count()));
   }
 
+  if (name == "nanoTime") {
+    if (arguments.size() != 0) {
+      throw std::runtime_error("nanoTime() expects no arguments");
+    }
+    return Value(dotlin::nanoTime());
+  }
+
+  if (name == "benchmark") {
+    if (arguments.size() != 3) {
+      throw std::runtime_error(
+          "benchmark() expects a name, an iteration count and a lambda");
+    }
+    Value label = evaluate(*arguments[0]);
+    Value count = evaluate(*arguments[1]);
+    Value body = evaluate(*arguments[2]);
+    auto *labelText = std::get_if<std::string>(&label);
+    auto *iterations = std::get_if<int>(&count);
+    auto *lambda = std::get_if<std::shared_ptr<LambdaValue>>(&body);
+    if (!labelText || !iterations || *iterations < 1 || !lambda) {
+      throw std::runtime_error(
+          "benchmark() expects a name, an iteration count and a lambda");
+    }
+    BenchmarkStats stats =
+        runBenchmark(*this, *lambda, static_cast<size_t>(*iterations));
+    output->write(formatBenchmark(*labelText, stats) + "\n");
+    return benchmarkResult(*labelText, stats);
+  }
+
   if (name == "now") {
     if (arguments.size() != 0) {
       throw std::runtime_error("now() expects no arguments");
@@ -504,6 +708,24 @@ Value Interpreter::executeBuiltinFunction(
     return Value(result);
   }
 
+  if (name == "parseJson") {
+    if (arguments.size() != 1) {
+      throw std::runtime_error("parseJson() expects exactly 1 argument");
+    }
+    Value arg = evaluate(*arguments[0]);
+    if (auto *text = std::get_if<std::string>(&arg)) {
+      return parseJson(*text);
+    }
+    throw std::runtime_error("parseJson() expects a string");
+  }
+
+  if (name == "toJson") {
+    if (arguments.size() != 1) {
+      throw std::runtime_error("toJson() expects exactly 1 argument");
+    }
+    return Value(toJson(evaluate(*arguments[0])));
+  }
+
   // File I/O functions
   if (name == "readFile") {
     if (arguments.size() != 1) {
@@ -511,17 +733,156 @@ Value Interpreter::executeBuiltinFunction(
     }
     Value arg = evaluate(*arguments[0]);
     if (auto *path = std::get_if<std::string>(&arg)) {
-      std::ifstream file(*path);
-      if (!file.is_open()) {
-        throw std::runtime_error("Could not open file: " + *path);
-      }
-      std::string content((std::istreambuf_iterator<char>(file)),
-                          std::istreambuf_iterator<char>());
-      return Value(content);
+      return Value(readFileContents(*path));
     }
     throw std::runtime_error("readFile() expects a string path");
   }
 
+  if (name == "File") {
+    if (arguments.size() != 1) {
+      throw std::runtime_error("File() expects exactly 1 argument (path)");
+    }
+    Value arg = evaluate(*arguments[0]);
+    if (auto *path = std::get_if<std::string>(&arg)) {
+      return Value(std::make_shared<FileValue>(FileValue{*path}));
+    }
+    throw std::runtime_error("File() expects a string path");
+  }
+
+  if (name == "forEachLine") {
+    if (arguments.size() != 2) {
+      throw std::runtime_error("forEachLine() expects a path and a lambda");
+    }
+    Value pathArg = evaluate(*arguments[0]);
+    auto *path = std::get_if<std::string>(&pathArg);
+    if (!path) {
+      throw std::runtime_error("forEachLine() expects a string path");
+    }
+    auto file = std::make_shared<FileValue>(FileValue{*path});
+    return callFileMethod(*this, file, "forEachLine",
+                          {evaluate(*arguments[1])});
+  }
+
+  if (name == "openWriter") {
+    if (arguments.empty() || arguments.size() > 2) {
+      throw std::runtime_error("openWriter() expects a path and an optional "
+                               "append flag");
+    }
+    Value pathArg = evaluate(*arguments[0]);
+    auto *path = std::get_if<std::string>(&pathArg);
+    if (!path) {
+      throw std::runtime_error("openWriter() expects a string path");
+    }
+    bool append = false;
+    if (arguments.size() == 2) {
+      Value appendArg = evaluate(*arguments[1]);
+      auto *flag = std::get_if<bool>(&appendArg);
+      if (!flag) {
+        throw std::runtime_error("openWriter() expects a Boolean append flag");
+      }
+      append = *flag;
+    }
+    return Value(std::make_shared<FileWriterValue>(*path, append));
+  }
+
+  if (name == "saveArray") {
+    if (arguments.size() != 2) {
+      throw std::runtime_error("saveArray() expects a path and an array");
+    }
+    Value pathArg = evaluate(*arguments[0]);
+    Value arrayArg = evaluate(*arguments[1]);
+    auto *path = std::get_if<std::string>(&pathArg);
+    auto *array = std::get_if<ArrayValue>(&arrayArg);
+    if (!path || !array) {
+      throw std::runtime_error("saveArray() expects a string path and an "
+                               "array");
+    }
+    saveArrayFile(*path, *array);
+    return Value();
+  }
+
+  if (name == "mapArray") {
+    if (arguments.size() != 1) {
+      throw std::runtime_error("mapArray() expects exactly 1 argument (path)");
+    }
+    Value arg = evaluate(*arguments[0]);
+    if (auto *path = std::get_if<std::string>(&arg)) {
+      return Value(loadArrayFile(*path));
+    }
+    throw std::runtime_error("mapArray() expects a string path");
+  }
+
+  if (name == "readCsv") {
+    if (arguments.empty() || arguments.size() > 3) {
+      throw std::runtime_error("readCsv() expects a path, optional options "
+                               "and an optional row lambda");
+    }
+    std::vector<Value> args;
+    for (const auto &arg : arguments) {
+      args.push_back(evaluate(*arg));
+    }
+    auto *path = std::get_if<std::string>(&args[0]);
+    if (!path) {
+      throw std::runtime_error("readCsv() expects a string path");
+    }
+    std::shared_ptr<LambdaValue> onRow;
+    if (auto *lambda = std::get_if<std::shared_ptr<LambdaValue>>(&args.back())) {
+      onRow = *lambda;
+      args.pop_back();
+    }
+    if (args.size() > 2) {
+      throw std::runtime_error("readCsv() expects its row lambda last");
+    }
+    CsvOptions options = args.size() == 2 ? csvOptions(args[1]) : CsvOptions();
+    if (onRow) {
+      forEachCsvRow(*this, *path, options, onRow);
+      return Value();
+    }
+    return readCsvColumns(*path, options);
+  }
+
+  if (name == "serialize") {
+    if (arguments.empty() || arguments.size() > 2) {
+      throw std::runtime_error("serialize() expects a value and an optional "
+                               "path");
+    }
+    Value value = evaluate(*arguments[0]);
+    if (arguments.size() == 1) {
+      return Value(serializeValue(value));
+    }
+    Value target = evaluate(*arguments[1]);
+    if (auto *path = std::get_if<std::string>(&target)) {
+      serializeValueToFile(value, *path);
+    } else if (auto *file = std::get_if<std::shared_ptr<FileValue>>(&target)) {
+      serializeValueToFile(value, (*file)->path);
+    } else {
+      throw std::runtime_error("serialize() expects a path or a File");
+    }
+    return Value();
+  }
+
+  if (name == "deserialize") {
+    if (arguments.size() != 1) {
+      throw std::runtime_error("deserialize() expects bytes or a File");
+    }
+    Value source = evaluate(*arguments[0]);
+    ClassLookup findClass = [this](const std::string &className)
+        -> std::shared_ptr<ClassDefinition> {
+      Value *found = environment->lookup(className);
+      auto *definition =
+          found ? std::get_if<std::shared_ptr<ClassDefinition>>(found)
+                : nullptr;
+      return definition ? *definition : nullptr;
+    };
+    if (auto *bytes = std::get_if<std::string>(&source)) {
+      return deserializeValue(*bytes, findClass);
+    }
+    if (auto *file = std::get_if<std::shared_ptr<FileValue>>(&source)) {
+      return deserializeFile((*file)->path, findClass);
+    }
+    throw std::runtime_error("deserialize() expects bytes or a File");
+  }
+
   if (name == "writeFile") {
     if (arguments.size() != 2) {
       throw std::runtime_error(
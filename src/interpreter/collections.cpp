@@ -0,0 +1,355 @@
+#include "dotlin/collections.h"
+#include "dotlin/array_functions.h"
+#include "dotlin/lambda_frame.h"
+#include <stdexcept>
+#include <utility>
+
+namespace dotlin {
+
+bool valuesEqual(const Value &v1, const Value &v2);
+std::string valueToString(const Value &value);
+
+namespace {
+
+const Value &nullValue() {
+  static const Value null(std::string("null"));
+  return null;
+}
+
+void requireMutable(bool isMutable, const std::string &kind,
+                    const std::string &method) {
+  if (!isMutable) {
+    throw std::runtime_error("Cannot call " + method + " on a read-only " +
+                             kind + "; create it with mutable" +
+                             (kind == "map" ? "MapOf" : "SetOf") + "()");
+  }
+}
+
+void requireArgs(const std::vector<Value> &args, size_t count,
+                 const std::string &method) {
+  if (args.size() != count) {
+    throw std::runtime_error(method + " expects " + std::to_string(count) +
+                             (count == 1 ? " argument" : " arguments"));
+  }
+}
+
+} // namespace
+
+Value makePair(const Value &first, const Value &second) {
+  return Value(ArrayValue(std::vector<Value>{first, second}));
+}
+
+std::shared_ptr<MapValue> makeMap(const std::vector<Value> &pairs,
+                                  bool isMutable) {
+  auto map = std::make_shared<MapValue>();
+  map->isMutable = isMutable;
+  map->table.reserve(pairs.size());
+  for (const auto &pair : pairs) {
+    auto *entry = std::get_if<ArrayValue>(&pair);
+    if (!entry || entry->size() != 2) {
+      throw std::runtime_error("Map entries must be written as key to value");
+    }
+    mapSet(*map, entry->at(0), entry->at(1));
+  }
+  return map;
+}
+
+std::shared_ptr<SetValue> makeSet(const std::vector<Value> &elements,
+                                  bool isMutable) {
+  auto set = std::make_shared<SetValue>();
+  set->isMutable = isMutable;
+  set->table.reserve(elements.size());
+  for (const auto &element : elements) {
+    set->table.insert(element);
+  }
+  return set;
+}
+
+Value mapGet(const MapValue &map, const Value &key) {
+  size_t entry = map.table.find(key);
+  return entry == ValueTable::npos ? nullValue() : map.table.valueAt(entry);
+}
+
+void mapSet(MapValue &map, const Value &key, const Value &value) {
+  size_t entry = map.table.insert(key).first;
+  map.table.valueAt(entry) = value;
+}
+
+ArrayValue mapEntries(const MapValue &map) {
+  const ValueTable &table = map.table;
+  std::vector<Value> out;
+  out.reserve(table.size());
+  for (size_t i = 0; i < table.entryCount(); ++i) {
+    if (table.isLive(i)) {
+      out.push_back(makePair(table.keyAt(i), table.valueAt(i)));
+    }
+  }
+  return ArrayValue(std::move(out));
+}
+
+ArrayValue setElements(const SetValue &set) {
+  const ValueTable &table = set.table;
+  std::vector<Value> out;
+  out.reserve(table.size());
+  for (size_t i = 0; i < table.entryCount(); ++i) {
+    if (table.isLive(i)) {
+      out.push_back(table.keyAt(i));
+    }
+  }
+  return ArrayValue(std::move(out));
+}
+
+bool mapsEqual(const MapValue &lhs, const MapValue &rhs) {
+  if (lhs.table.size() != rhs.table.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < lhs.table.entryCount(); ++i) {
+    if (!lhs.table.isLive(i)) {
+      continue;
+    }
+    size_t other = rhs.table.find(lhs.table.keyAt(i));
+    if (other == ValueTable::npos ||
+        !valuesEqual(lhs.table.valueAt(i), rhs.table.valueAt(other))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool setsEqual(const SetValue &lhs, const SetValue &rhs) {
+  if (lhs.table.size() != rhs.table.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < lhs.table.entryCount(); ++i) {
+    if (lhs.table.isLive(i) &&
+        rhs.table.find(lhs.table.keyAt(i)) == ValueTable::npos) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string mapToString(const MapValue &map) {
+  std::string out = "{";
+  bool first = true;
+  for (size_t i = 0; i < map.table.entryCount(); ++i) {
+    if (!map.table.isLive(i)) {
+      continue;
+    }
+    if (!first) {
+      out += ", ";
+    }
+    first = false;
+    out += valueToString(map.table.keyAt(i)) + "=" +
+           valueToString(map.table.valueAt(i));
+  }
+  return out + "}";
+}
+
+std::string setToString(const SetValue &set) {
+  return valueToString(Value(setElements(set)));
+}
+
+Value callMapMethod(Interpreter &interpreter,
+                    const std::shared_ptr<MapValue> &map,
+                    const std::string &method,
+                    const std::vector<Value> &args) {
+  ValueTable &table = map->table;
+
+  // Queries
+  if (method == "size" && args.empty()) {
+    return Value(static_cast<int>(table.size()));
+  }
+  if (method == "isEmpty" && args.empty()) {
+    return Value(table.size() == 0);
+  }
+  if (method == "isNotEmpty" && args.empty()) {
+    return Value(table.size() != 0);
+  }
+  if (method == "get") {
+    requireArgs(args, 1, method);
+    return mapGet(*map, args[0]);
+  }
+  if (method == "getOrDefault") {
+    requireArgs(args, 2, method);
+    size_t entry = table.find(args[0]);
+    return entry == ValueTable::npos ? args[1] : table.valueAt(entry);
+  }
+  if (method == "getValue") {
+    requireArgs(args, 1, method);
+    size_t entry = table.find(args[0]);
+    if (entry == ValueTable::npos) {
+      throw std::runtime_error("Key " + valueToString(args[0]) +
+                               " is missing in the map.");
+    }
+    return table.valueAt(entry);
+  }
+  if (method == "containsKey") {
+    requireArgs(args, 1, method);
+    return Value(table.find(args[0]) != ValueTable::npos);
+  }
+  if (method == "containsValue") {
+    requireArgs(args, 1, method);
+    for (size_t i = 0; i < table.entryCount(); ++i) {
+      if (table.isLive(i) && valuesEqual(table.valueAt(i), args[0])) {
+        return Value(true);
+      }
+    }
+    return Value(false);
+  }
+
+  // Views and copies
+  if (method == "keys" && args.empty()) {
+    auto keys = std::make_shared<SetValue>();
+    keys->table.reserve(table.size());
+    for (size_t i = 0; i < table.entryCount(); ++i) {
+      if (table.isLive(i)) {
+        keys->table.insert(table.keyAt(i));
+      }
+    }
+    return Value(keys);
+  }
+  if (method == "values" && args.empty()) {
+    std::vector<Value> values;
+    values.reserve(table.size());
+    for (size_t i = 0; i < table.entryCount(); ++i) {
+      if (table.isLive(i)) {
+        values.push_back(table.valueAt(i));
+      }
+    }
+    return Value(ArrayValue(std::move(values)));
+  }
+  if ((method == "entries" || method == "toList") && args.empty()) {
+    return Value(mapEntries(*map));
+  }
+  if ((method == "toMap" || method == "toMutableMap") && args.empty()) {
+    auto copy = std::make_shared<MapValue>(*map);
+    copy->isMutable = method == "toMutableMap";
+    return Value(copy);
+  }
+  if (method == "forEach") {
+    // { key, value -> } or { entry -> } with entry = [key, value]
+    auto lambda = lambdaArg(args, 0, method);
+    bool twoParams = lambda->parameters.size() == 2;
+    // Iterate over a snapshot, like for loops do: removing an entry from
+    // the callback compacts the table and would shift the later ones
+    std::vector<std::pair<Value, Value>> entries;
+    entries.reserve(table.size());
+    for (size_t i = 0; i < table.entryCount(); ++i) {
+      if (table.isLive(i)) {
+        entries.emplace_back(table.keyAt(i), table.valueAt(i));
+      }
+    }
+    LambdaFrame frame(interpreter, lambda, twoParams ? 2 : 1,
+                      "lambda@forEach");
+    for (const auto &[key, value] : entries) {
+      if (twoParams) {
+        frame.call(key, value);
+      } else {
+        frame.call(makePair(key, value));
+      }
+    }
+    return Value();
+  }
+
+  // Updates
+  if (method == "set") {
+    requireArgs(args, 2, method);
+    requireMutable(map->isMutable, "map", method);
+    mapSet(*map, args[0], args[1]);
+    return Value();
+  }
+  if (method == "put") {
+    requireArgs(args, 2, method);
+    requireMutable(map->isMutable, "map", method);
+    auto [entry, added] = table.insert(args[0]);
+    Value previous = added ? nullValue() : table.valueAt(entry);
+    table.valueAt(entry) = args[1];
+    return previous;
+  }
+  if (method == "getOrPut") {
+    requireArgs(args, 2, method);
+    requireMutable(map->isMutable, "map", method);
+    size_t entry = table.find(args[0]);
+    if (entry != ValueTable::npos) {
+      return table.valueAt(entry);
+    }
+    // The lambda may itself update the map, so insert only afterwards
+    LambdaFrame frame(interpreter, lambdaArg(args, 1, method), 1,
+                      "lambda@getOrPut");
+    Value value = frame.call(args[0]);
+    mapSet(*map, args[0], value);
+    return value;
+  }
+  if (method == "remove") {
+    requireArgs(args, 1, method);
+    requireMutable(map->isMutable, "map", method);
+    Value previous = mapGet(*map, args[0]);
+    table.erase(args[0]);
+    return previous;
+  }
+  if (method == "clear" && args.empty()) {
+    requireMutable(map->isMutable, "map", method);
+    table.clear();
+    return Value();
+  }
+
+  throw std::runtime_error("Cannot call method '" + method + "' on a map");
+}
+
+Value callSetMethod(Interpreter &interpreter,
+                    const std::shared_ptr<SetValue> &set,
+                    const std::string &method,
+                    const std::vector<Value> &args) {
+  ValueTable &table = set->table;
+
+  if (method == "size" && args.empty()) {
+    return Value(static_cast<int>(table.size()));
+  }
+  if (method == "isEmpty" && args.empty()) {
+    return Value(table.size() == 0);
+  }
+  if (method == "isNotEmpty" && args.empty()) {
+    return Value(table.size() != 0);
+  }
+  if (method == "contains") {
+    requireArgs(args, 1, method);
+    return Value(table.find(args[0]) != ValueTable::npos);
+  }
+  if (method == "toList" && args.empty()) {
+    return Value(setElements(*set));
+  }
+  if ((method == "toSet" || method == "toMutableSet") && args.empty()) {
+    auto copy = std::make_shared<SetValue>(*set);
+    copy->isMutable = method == "toMutableSet";
+    return Value(copy);
+  }
+
+  if (method == "add") {
+    requireArgs(args, 1, method);
+    requireMutable(set->isMutable, "set", method);
+    return Value(table.insert(args[0]).second);
+  }
+  if (method == "remove") {
+    requireArgs(args, 1, method);
+    requireMutable(set->isMutable, "set", method);
+    return Value(table.erase(args[0]));
+  }
+  if (method == "clear" && args.empty()) {
+    requireMutable(set->isMutable, "set", method);
+    table.clear();
+    return Value();
+  }
+
+  // Higher-order functions run over the elements in insertion order and,
+  // like Kotlin's, return lists
+  if (method == "map" || method == "filter" || method == "forEach" ||
+      method == "reduce" || method == "fold" || method == "any" ||
+      method == "all" || method == "count" || method == "sumOf") {
+    return callArrayHigherOrder(interpreter, setElements(*set), method, args);
+  }
+
+  throw std::runtime_error("Cannot call method '" + method + "' on a set");
+}
+
+} // namespace dotlin
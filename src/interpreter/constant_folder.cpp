@@ -1,3 +1,5 @@
+#include "dotlin/number_format.h"
+#include "dotlin/trace.h"
 #include "dotlin/visitors.h"
 // #include <iostream>
 #include <variant>
@@ -26,8 +28,8 @@ Expression::Ptr ConstantFolderVisitor::fold(Expression::Ptr expr) {
   resultExpr = nullptr;
   expr->accept(*this);
   if (resultExpr) {
-    // std::cout << "FOLDED Expression at L" << expr->line << ":" <<
-    // expr->column << std::endl;
+    DOTLIN_TRACE(Optimize, Debug, "folded expression at ", expr->line, ":",
+                 expr->column);
     Expression::Ptr res = std::move(resultExpr);
     resultExpr = nullptr;
     return res;
@@ -73,11 +75,11 @@ void ConstantFolderVisitor::visit(StringInterpolationExpr &node) {
       if (std::holds_alternative<std::string>(lit->value))
         resultStr += std::get<std::string>(lit->value);
       else if (std::holds_alternative<int>(lit->value))
-        resultStr += std::to_string(std::get<int>(lit->value));
+        appendNumber(resultStr, std::get<int>(lit->value));
       else if (std::holds_alternative<int64_t>(lit->value))
-        resultStr += std::to_string(std::get<int64_t>(lit->value));
+        appendNumber(resultStr, std::get<int64_t>(lit->value));
       else if (std::holds_alternative<double>(lit->value))
-        resultStr += std::to_string(std::get<double>(lit->value));
+        appendNumber(resultStr, std::get<double>(lit->value));
       else if (std::holds_alternative<bool>(lit->value))
         resultStr += std::get<bool>(lit->value) ? "true" : "false";
       else
@@ -0,0 +1,465 @@
+#include "dotlin/csv.h"
+#include "dotlin/collections.h"
+#include "dotlin/file_io.h"
+#include "dotlin/input.h"
+#include "dotlin/lambda_frame.h"
+#include "dotlin/number_format.h"
+#include "dotlin/string_kernels.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace dotlin {
+
+namespace {
+
+constexpr size_t kReadSize = size_t{1} << 20;
+constexpr size_t kBatchBlocks = 64;
+
+// Streams the records of one file. Fields are views into the read buffer;
+// quoted fields are unquoted in place, which only ever shrinks them. The
+// views stay valid until the next call to next().
+class CsvReader {
+public:
+  CsvReader(const std::string &path, const CsvOptions &options)
+      : filePath(path), file(path), special{options.delimiter, options.quote,
+                                            '\n'} {}
+
+  // The next non-blank record; false at the end of the file
+  bool next(std::vector<std::string_view> &fields) {
+    for (;;) {
+      fields.clear();
+      size_t end = nextSeparator;
+      while (end < separators.size() && buffer[separators[end]] != '\n') {
+        ++end;
+      }
+      size_t recordEnd;
+      if (end < separators.size()) {
+        recordEnd = separators[end];
+      } else if (!atEnd) {
+        refill();
+        continue;
+      } else if (start < filled) {
+        // The last record has no line break after it
+        recordEnd = filled;
+        end = separators.size();
+      } else {
+        return false;
+      }
+
+      // Count the line breaks before quoted ones are unquoted away
+      line = linesBefore + 1;
+      linesBefore += static_cast<size_t>(
+          std::count(buffer.data() + start,
+                     buffer.data() + std::min(recordEnd + 1, filled), '\n'));
+      size_t fieldStart = start;
+      for (size_t i = nextSeparator; i < end; ++i) {
+        fields.push_back(field(fieldStart, separators[i]));
+        fieldStart = separators[i] + 1;
+      }
+      size_t lastEnd = recordEnd;
+      if (lastEnd > fieldStart && buffer[lastEnd - 1] == '\r') {
+        --lastEnd;
+      }
+      fields.push_back(field(fieldStart, lastEnd));
+      start = std::min(recordEnd + 1, filled);
+      nextSeparator = std::min(end + 1, separators.size());
+      if (fields.size() > 1 || !fields[0].empty()) {
+        return true;
+      }
+    }
+  }
+
+  // Line on which the last record starts
+  size_t recordLine() const { return line; }
+
+private:
+  std::string filePath;
+  ReadDescriptor file;
+  char special[3]; // delimiter, quote, line break
+  std::string buffer;
+  size_t start = 0;   // first byte not yet returned
+  size_t scanned = 0; // bytes classified so far
+  size_t filled = 0;  // bytes read so far
+  // Delimiters and line breaks outside quotes, from `start` on
+  std::vector<uint32_t> separators;
+  size_t nextSeparator = 0;
+  uint64_t inQuotes = 0; // all ones when the last block ended in quotes
+  bool atEnd = false;
+  size_t line = 0;
+  size_t linesBefore = 0; // line breaks before `start`
+
+  // Moves the unfinished record to the front, reads the next block and
+  // classifies it
+  void refill() {
+    if (start > 0) {
+      std::memmove(buffer.data(), buffer.data() + start, filled - start);
+      size_t kept = separators.size() - nextSeparator;
+      for (size_t i = 0; i < kept; ++i) {
+        separators[i] =
+            separators[nextSeparator + i] - static_cast<uint32_t>(start);
+      }
+      separators.resize(kept);
+      nextSeparator = 0;
+      scanned -= start;
+      filled -= start;
+      start = 0;
+    }
+    // A record longer than the buffer makes it grow
+    if (buffer.size() - filled < kReadSize / 2) {
+      buffer.resize(std::max(buffer.size() * 2, kReadSize));
+      if (buffer.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("readCsv(): a record in " + filePath +
+                                 " is larger than 4 GiB");
+      }
+    }
+    size_t got =
+        readBlock(file.get(), buffer.data() + filled, buffer.size() - filled);
+    filled += got;
+    atEnd = got == 0;
+    scan();
+  }
+
+  void scan() {
+    std::string_view chars(special, 3);
+    uint64_t masks[kBatchBlocks * 3];
+    while (filled - scanned >= 64) {
+      size_t blocks = std::min(kBatchBlocks, (filled - scanned) / 64);
+      byteMasks64(buffer.data() + scanned, blocks, chars, masks);
+      for (size_t b = 0; b < blocks; ++b, scanned += 64) {
+        indexBlock(masks + b * 3, ~uint64_t{0});
+      }
+    }
+    if (atEnd && scanned < filled) {
+      char tail[64] = {};
+      std::memcpy(tail, buffer.data() + scanned, filled - scanned);
+      byteMasks64(tail, 1, chars, masks);
+      indexBlock(masks, (uint64_t{1} << (filled - scanned)) - 1);
+      scanned = filled;
+    }
+    if (atEnd && inQuotes) {
+      throw std::runtime_error("readCsv(): unterminated quoted field in " +
+                               filePath);
+    }
+  }
+
+  // Records the separators of the 64 bytes at `scanned`; `valid` masks off
+  // the padding after the end of the file
+  void indexBlock(const uint64_t *masks, uint64_t valid) {
+    uint64_t quoted = prefixXor(masks[1] & valid) ^ inQuotes;
+    inQuotes = (quoted >> 63) ? ~uint64_t{0} : 0;
+    uint64_t bits = (masks[0] | masks[2]) & ~quoted & valid;
+    for (; bits != 0; bits &= bits - 1) {
+      separators.push_back(static_cast<uint32_t>(
+          scanned + static_cast<size_t>(std::countr_zero(bits))));
+    }
+  }
+
+  std::string_view field(size_t begin, size_t end) {
+    char *data = buffer.data();
+    char quote = special[1];
+    if (begin == end || data[begin] != quote) {
+      if (std::memchr(data + begin, quote, end - begin)) {
+        fail("a quote inside an unquoted field");
+      }
+      return {data + begin, end - begin};
+    }
+    if (end - begin < 2 || data[end - 1] != quote) {
+      fail("text after a closing quote");
+    }
+    size_t out = begin;
+    for (size_t i = begin + 1; i < end - 1; ++i) {
+      // Inside quotes, quotes only come in doubled pairs
+      if (data[i] == quote) {
+        ++i;
+      }
+      data[out++] = data[i];
+    }
+    return {data + begin, out - begin};
+  }
+
+  [[noreturn]] void fail(const std::string &what) const {
+    throw std::runtime_error("readCsv(): " + what + " at line " +
+                             std::to_string(line) + " of " + filePath);
+  }
+};
+
+enum class CsvType { Int, Double, String };
+
+std::string_view trimBlanks(std::string_view text) {
+  while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+    text.remove_prefix(1);
+  }
+  while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+// The narrowest type holding every non-empty sampled field of column `c`
+CsvType inferType(const std::vector<std::vector<std::string>> &sample,
+                  size_t c) {
+  bool any = false;
+  CsvType type = CsvType::Int;
+  for (const auto &record : sample) {
+    std::string_view text =
+        c < record.size() ? trimBlanks(record[c]) : std::string_view();
+    if (text.empty()) {
+      continue;
+    }
+    any = true;
+    if (type == CsvType::Int && !parseInt(text)) {
+      type = CsvType::Double;
+    }
+    if (type == CsvType::Double && !parseDouble(text)) {
+      return CsvType::String;
+    }
+  }
+  return any ? type : CsvType::String;
+}
+
+// One column being filled, kept unboxed while it is numeric
+struct CsvColumn {
+  CsvType type;
+  std::vector<int> ints;
+  std::vector<double> doubles;
+  std::vector<Value> strings;
+
+  void append(std::string_view text) {
+    if (type != CsvType::String) {
+      std::string_view number = trimBlanks(text);
+      if (type == CsvType::Int) {
+        if (auto value = parseInt(number)) {
+          ints.push_back(*value);
+          return;
+        }
+        widenToDouble();
+      }
+      if (number.empty()) {
+        doubles.push_back(std::numeric_limits<double>::quiet_NaN());
+        return;
+      }
+      if (auto value = parseDouble(number)) {
+        doubles.push_back(*value);
+        return;
+      }
+      widenToString();
+    }
+    strings.emplace_back(std::string(text));
+  }
+
+  void widenToDouble() {
+    doubles.assign(ints.begin(), ints.end());
+    ints = {};
+    type = CsvType::Double;
+  }
+
+  void widenToString() {
+    strings.reserve(doubles.size() + 1);
+    for (double value : doubles) {
+      std::string text;
+      if (!std::isnan(value)) {
+        appendNumber(text, value);
+      }
+      strings.emplace_back(std::move(text));
+    }
+    doubles = {};
+    type = CsvType::String;
+  }
+
+  Value finish() {
+    switch (type) {
+    case CsvType::Int:
+      return Value(ArrayValue(std::move(ints)));
+    case CsvType::Double:
+      return Value(ArrayValue(std::move(doubles)));
+    default:
+      return Value(ArrayValue(std::move(strings), ArrayElementType::STRING));
+    }
+  }
+};
+
+// Field of a record passed to the row callback
+Value typedField(CsvType type, std::string_view text) {
+  if (type != CsvType::String) {
+    std::string_view number = trimBlanks(text);
+    if (number.empty()) {
+      return Value(std::string("null"));
+    }
+    if (type == CsvType::Int) {
+      if (auto value = parseInt(number)) {
+        return Value(*value);
+      }
+    }
+    if (auto value = parseDouble(number)) {
+      return Value(*value);
+    }
+  }
+  return Value(std::string(text));
+}
+
+// Reads the header and up to sampleRows records, which decide the types
+struct CsvStart {
+  std::vector<std::string> names;
+  std::vector<std::vector<std::string>> sample;
+  std::vector<size_t> sampleLines;
+  std::vector<CsvType> types;
+};
+
+CsvStart readStart(CsvReader &reader, const CsvOptions &options,
+                   std::vector<std::string_view> &fields) {
+  CsvStart start;
+  if (options.header && reader.next(fields)) {
+    start.names.assign(fields.begin(), fields.end());
+  }
+  size_t width = start.names.size();
+  while (start.sample.size() < options.sampleRows && reader.next(fields)) {
+    start.sample.emplace_back(fields.begin(), fields.end());
+    start.sampleLines.push_back(reader.recordLine());
+    width = std::max(width, fields.size());
+  }
+  if (!options.header) {
+    for (size_t c = start.names.size(); c < width; ++c) {
+      start.names.push_back("column" + std::to_string(c + 1));
+    }
+  }
+  for (size_t c = 0; c < start.names.size(); ++c) {
+    start.types.push_back(inferType(start.sample, c));
+  }
+  return start;
+}
+
+void checkWidth(const std::string &path, size_t line, size_t fields,
+                size_t columns) {
+  if (fields > columns) {
+    throw std::runtime_error("readCsv(): line " + std::to_string(line) +
+                             " of " + path + " has " + std::to_string(fields) +
+                             " fields, but there are " +
+                             std::to_string(columns) + " columns");
+  }
+}
+
+char optionChar(const Value &value, const std::string &name) {
+  auto *text = std::get_if<std::string>(&value);
+  if (!text || text->size() != 1 || (*text)[0] == '\n' || (*text)[0] == '\r') {
+    throw std::runtime_error("readCsv() expects the " + name +
+                             " option to be a one-character string");
+  }
+  return (*text)[0];
+}
+
+} // namespace
+
+CsvOptions csvOptions(const Value &options) {
+  CsvOptions result;
+  auto *map = std::get_if<std::shared_ptr<MapValue>>(&options);
+  if (!map) {
+    throw std::runtime_error("readCsv() expects its options as a map, not " +
+                             getTypeOfValue(options));
+  }
+  const ValueTable &table = (*map)->table;
+  for (size_t i = 0; i < table.entryCount(); ++i) {
+    if (!table.isLive(i)) {
+      continue;
+    }
+    auto *name = std::get_if<std::string>(&table.keyAt(i));
+    const Value &value = table.valueAt(i);
+    if (name && *name == "delimiter") {
+      result.delimiter = optionChar(value, *name);
+    } else if (name && *name == "quote") {
+      result.quote = optionChar(value, *name);
+    } else if (name && *name == "header") {
+      auto *flag = std::get_if<bool>(&value);
+      if (!flag) {
+        throw std::runtime_error("readCsv() expects the header option to be "
+                                 "a Boolean");
+      }
+      result.header = *flag;
+    } else if (name && *name == "sampleRows") {
+      auto *count = std::get_if<int>(&value);
+      if (!count || *count < 1) {
+        throw std::runtime_error("readCsv() expects sampleRows to be a "
+                                 "positive Int");
+      }
+      result.sampleRows = static_cast<size_t>(*count);
+    } else {
+      throw std::runtime_error("readCsv() has no option " +
+                               valueToString(table.keyAt(i)));
+    }
+  }
+  if (result.delimiter == result.quote) {
+    throw std::runtime_error("readCsv() needs different delimiter and quote "
+                             "characters");
+  }
+  return result;
+}
+
+Value readCsvColumns(const std::string &path, const CsvOptions &options) {
+  CsvReader reader(path, options);
+  std::vector<std::string_view> fields;
+  CsvStart start = readStart(reader, options, fields);
+  size_t width = start.names.size();
+
+  std::vector<CsvColumn> columns;
+  for (CsvType type : start.types) {
+    columns.push_back(CsvColumn{type, {}, {}, {}});
+  }
+  for (size_t r = 0; r < start.sample.size(); ++r) {
+    const auto &record = start.sample[r];
+    checkWidth(path, start.sampleLines[r], record.size(), width);
+    for (size_t c = 0; c < width; ++c) {
+      columns[c].append(c < record.size() ? record[c] : std::string_view());
+    }
+  }
+  start.sample = {};
+  while (reader.next(fields)) {
+    checkWidth(path, reader.recordLine(), fields.size(), width);
+    for (size_t c = 0; c < width; ++c) {
+      columns[c].append(c < fields.size() ? fields[c] : std::string_view());
+    }
+  }
+
+  auto map = std::make_shared<MapValue>();
+  map->table.reserve(width);
+  for (size_t c = 0; c < width; ++c) {
+    auto [entry, inserted] = map->table.insert(Value(start.names[c]));
+    if (!inserted) {
+      throw std::runtime_error("readCsv(): " + path +
+                               " has two columns named '" + start.names[c] +
+                               "'");
+    }
+    map->table.valueAt(entry) = columns[c].finish();
+  }
+  return Value(map);
+}
+
+void forEachCsvRow(Interpreter &interpreter, const std::string &path,
+                   const CsvOptions &options,
+                   const std::shared_ptr<LambdaValue> &lambda) {
+  CsvReader reader(path, options);
+  std::vector<std::string_view> fields;
+  CsvStart start = readStart(reader, options, fields);
+  LambdaFrame frame(interpreter, lambda, 1, "lambda@readCsv");
+  auto emit = [&](const auto &record) {
+    std::vector<Value> row;
+    row.reserve(record.size());
+    for (size_t c = 0; c < record.size(); ++c) {
+      CsvType type = c < start.types.size() ? start.types[c] : CsvType::String;
+      row.push_back(typedField(type, record[c]));
+    }
+    frame.call(Value(ArrayValue(std::move(row))));
+  };
+  for (const auto &record : start.sample) {
+    emit(record);
+  }
+  start.sample = {};
+  while (reader.next(fields)) {
+    emit(fields);
+  }
+}
+
+} // namespace dotlin
@@ -1,3 +1,4 @@
+#include "dotlin/trace.h"
 #include "dotlin/visitors.h"
 #include <iostream>
 #include <vector>
@@ -30,12 +31,15 @@ Statement::Ptr DeadCodeEliminationVisitor::eliminate(Statement::Ptr stmt)
 void DeadCodeEliminationVisitor::visit(BlockStmt& node)
 {
     std::vector<Statement::Ptr> newStatements;
+    bool returned = false;
 
     for (auto& stmt : node.statements)
     {
-        if (hasReturn)
+        if (returned)
         {
             // Skip all statements after a return (unreachable code)
+            DOTLIN_TRACE(Optimize, Debug, "removed unreachable statement at ",
+                         stmt->line, ":", stmt->column);
             hasUnreachable = true;
             continue;
         }
@@ -46,22 +50,14 @@ void DeadCodeEliminationVisitor::visit(BlockStmt& node)
         {
             newStatements.push_back(eliminatedStmt);
 
-            // If this statement caused a return, we don't need to process more
-            if (dynamic_cast<ReturnStmt*>(eliminatedStmt.get()))
-            {
-                hasReturn = true;
-            }
+            // Only a return at this level ends the block; one inside an if
+            // or loop body may not run
+            returned = dynamic_cast<ReturnStmt*>(eliminatedStmt.get()) != nullptr;
         }
     }
 
-    // If the block ends with a return statement, we can set hasReturn for outer context
-    if (!newStatements.empty())
-    {
-        if (dynamic_cast<ReturnStmt*>(newStatements.back().get()))
-        {
-            hasReturn = true;
-        }
-    }
+    // Tell the outer context whether this block always returns
+    hasReturn = returned;
 
     // Create a new block with cleaned statements
     resultStmt = std::make_shared<BlockStmt>(std::move(newStatements), node.line, node.column);
@@ -140,13 +136,15 @@ void DeadCodeEliminationVisitor::visit(VariableDeclStmt& node)
     }
 
     // Variable declarations don't affect control flow
-    resultStmt = std::make_shared<VariableDeclStmt>(
+    auto decl = std::make_shared<VariableDeclStmt>(
         node.isVal, // Add the missing isVal parameter
         node.name,
         node.typeAnnotation,
         std::move(node.initializer),
         node.line,
         node.column);
+    decl->index = node.index; // Keep the slot assigned by the resolver
+    resultStmt = decl;
 }
 
 void DeadCodeEliminationVisitor::visit(FunctionDeclStmt& node)
@@ -156,23 +154,27 @@ void DeadCodeEliminationVisitor::visit(FunctionDeclStmt& node)
     if (node.body)
     {
         auto newBody = eliminate(node.body);
-        resultStmt = std::make_shared<FunctionDeclStmt>(
+        auto decl = std::make_shared<FunctionDeclStmt>(
             node.name,
             node.parameters,
             std::move(newBody),
             node.returnType,
             node.line,
             node.column);
+        decl->index = node.index; // Keep the slot assigned by the resolver
+        resultStmt = decl;
     }
     else
     {
-        resultStmt = std::make_shared<FunctionDeclStmt>(
+        auto decl = std::make_shared<FunctionDeclStmt>(
             node.name,
             node.parameters,
             std::move(node.body),
             node.returnType,
             node.line,
             node.column);
+        decl->index = node.index;
+        resultStmt = decl;
     }
 }
 
@@ -222,7 +224,7 @@ void DeadCodeEliminationVisitor::visit(WhenStmt& node)
         newBranches.emplace_back(std::move(branch.first), std::move(newBranchBody));
     }
 
-    Statement::Ptr newElseBranch = nullptr;
+    std::optional<Statement::Ptr> newElseBranch;
     if (node.elseBranch)
     {
         newElseBranch = eliminate(node.elseBranch.value());
@@ -245,7 +247,9 @@ void DeadCodeEliminationVisitor::visit(TryStmt& node)
 
     auto newCatchBlock = eliminate(node.catchBlock);
 
-    Statement::Ptr newFinallyBlock = nullptr;
+    // Stays empty without a finally block: an engaged null pointer would be
+    // executed
+    std::optional<Statement::Ptr> newFinallyBlock;
     if (node.finallyBlock)
     {
         newFinallyBlock = eliminate(node.finallyBlock.value());
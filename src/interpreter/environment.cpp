@@ -1,4 +1,5 @@
 #include "dotlin/interpreter.h"
+#include "dotlin/trace.h"
 #include <stdexcept>
 
 namespace dotlin {
@@ -17,9 +18,7 @@ Value Environment::get(const std::string &name) {
     return enclosing->get(name);
   }
 
-  /* std::cout << "[DEBUG] Environment(" << this << ")::get failed for '" <<
-     name
-            << "'" << std::endl; */
+  DOTLIN_TRACE(Exec, Debug, "'", name, "' is not defined");
   throw std::runtime_error("Undefined variable: " + name);
 }
 
@@ -38,6 +37,11 @@ void Environment::assign(const std::string &name, Value value) {
   throw std::runtime_error("Undefined variable: " + name);
 }
 
+void Environment::bind(int index, const std::string &name, Value value) {
+  defineAt(index, value);
+  values[name] = std::move(value);
+}
+
 std::shared_ptr<Environment> Environment::ancestor(int distance) {
   std::shared_ptr<Environment> environment = shared_from_this();
   for (int i = 0; i < distance; i++) {
@@ -75,4 +79,22 @@ void Environment::assignAt(int distance, int index, Value value) {
   env->indexedValues[static_cast<size_t>(index)] = value;
 }
 
+Value *Environment::slotAt(int distance, int index) {
+  auto env = ancestor(distance);
+  if (env && static_cast<size_t>(index) < env->indexedValues.size()) {
+    return &env->indexedValues[static_cast<size_t>(index)];
+  }
+  return nullptr;
+}
+
+Value *Environment::lookup(const std::string &name) {
+  for (Environment *env = this; env; env = env->enclosing.get()) {
+    auto it = env->values.find(name);
+    if (it != env->values.end()) {
+      return &it->second;
+    }
+  }
+  return nullptr;
+}
+
 } // namespace dotlin
@@ -1,5 +1,17 @@
+#include "dotlin/array_functions.h"
+#include "dotlin/array_kernels.h"
+#include "dotlin/array_sort.h"
+#include "dotlin/collections.h"
+#include "dotlin/file_io.h"
 #include "dotlin/interpreter.h"
+#include "dotlin/number_format.h"
+#include "dotlin/parallel.h"
 #include "dotlin/parser.h"
+#include "dotlin/sequence.h"
+#include "dotlin/string_builder.h"
+#include "dotlin/string_functions.h"
+#include "dotlin/string_kernels.h"
+#include "dotlin/trace.h"
 #include "dotlin/visitors.h"
 #include <algorithm>
 // #include <cmath>
@@ -25,8 +37,7 @@ void EvalVisitor::visit(LiteralExpr &node) {
 void EvalVisitor::visit(StringInterpolationExpr &node) {
   std::string resultStr = "";
   for (const auto &part : node.parts) {
-    Value partValue = interpreter->evaluate(*part);
-    resultStr += interpreter->valueToString(partValue);
+    appendValueString(resultStr, interpreter->evaluate(*part));
   }
   result = Value(resultStr);
 }
@@ -35,11 +46,7 @@ void EvalVisitor::visit(IdentifierExpr &node) {
   // Check if this is a special identifier like "args"
   if (node.name == "args") {
     // Return the command-line arguments array
-    ArrayValue argsArray;
-    for (const auto &arg : interpreter->commandLineArgs) {
-      argsArray.elements->push_back(Value(arg));
-    }
-    result = Value(argsArray);
+    result = Value(interpreter->argsArray);
     return;
   }
   // Special handling for "this" keyword
@@ -55,9 +62,12 @@ void EvalVisitor::visit(IdentifierExpr &node) {
     try {
       auto location = interpreter->getResolvedLocation(&node);
       if (location) {
+        DOTLIN_TRACE(Exec, Debug, "lookup '", node.name, "' at distance ",
+                     location->first, ", slot ", location->second);
         result =
             interpreter->environment->getAt(location->first, location->second);
       } else {
+        DOTLIN_TRACE(Exec, Debug, "lookup '", node.name, "' in globals");
         result = interpreter->globals->get(node.name);
       }
     } catch (const std::runtime_error &e) {
@@ -77,19 +87,7 @@ void EvalVisitor::visit(IdentifierExpr &node) {
       }
 
       // Check if this is a built-in function
-      if (node.name == "println" || node.name == "print" ||
-          node.name == "sqrt" || node.name == "abs" || node.name == "pow" ||
-          node.name == "readln" || node.name == "arrayOf" ||
-          node.name == "sin" || node.name == "cos" || node.name == "tan" ||
-          node.name == "min" || node.name == "max" || node.name == "round" ||
-          node.name == "ceil" || node.name == "floor" ||
-          node.name == "random" || node.name == "clock" ||
-          node.name == "exit" || node.name == "readLine" ||
-          node.name == "toInt" || node.name == "toString" ||
-          node.name == "format" || node.name == "readFile" ||
-          node.name == "writeFile" || node.name == "exists" ||
-          node.name == "now" || node.name == "currentTimeMillis" ||
-          node.name == "sleep" || node.name == "printStackTrace") {
+      if (Interpreter::isBuiltinFunction(node.name)) {
         // Return a special lambda that represents a built-in function
         auto builtinLambda =
             std::make_shared<LambdaValue>(std::vector<FunctionParameter>(),
@@ -110,12 +108,76 @@ void EvalVisitor::visit(LambdaExpr &node) {
   result = Value(lambda);
 }
 
+// True for expressions that cannot write any variable: no assignments and
+// no calls other than the built-in toString(). `s = s + e` may then append
+// `e` to s in place, since evaluating `e` cannot change s.
+static bool isSideEffectFree(const Expression *expr) {
+  if (!expr || dynamic_cast<const LiteralExpr *>(expr) ||
+      dynamic_cast<const IdentifierExpr *>(expr)) {
+    return true;
+  }
+  if (auto *binary = dynamic_cast<const BinaryExpr *>(expr)) {
+    return binary->op != TokenType::ASSIGN &&
+           isSideEffectFree(binary->left.get()) &&
+           isSideEffectFree(binary->right.get());
+  }
+  if (auto *unary = dynamic_cast<const UnaryExpr *>(expr)) {
+    return isSideEffectFree(unary->operand.get());
+  }
+  if (auto *member = dynamic_cast<const MemberAccessExpr *>(expr)) {
+    return isSideEffectFree(member->object.get());
+  }
+  if (auto *access = dynamic_cast<const ArrayAccessExpr *>(expr)) {
+    return isSideEffectFree(access->array.get()) &&
+           isSideEffectFree(access->index.get());
+  }
+  if (auto *interpolation =
+          dynamic_cast<const StringInterpolationExpr *>(expr)) {
+    for (const auto &part : interpolation->parts) {
+      if (!isSideEffectFree(part.get())) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (auto *call = dynamic_cast<const CallExpr *>(expr)) {
+    auto *member = dynamic_cast<const MemberAccessExpr *>(call->callee.get());
+    return member && member->property == "toString" &&
+           call->arguments.empty() && isSideEffectFree(member->object.get());
+  }
+  return false;
+}
+
 void EvalVisitor::visit(BinaryExpr &node) {
   if (node.op == TokenType::ASSIGN) {
     // Handle assignment
     if (auto *ident = dynamic_cast<IdentifierExpr *>(node.left.get())) {
-      Value value = interpreter->evaluate(*node.right);
       auto location = interpreter->getResolvedLocation(ident);
+      auto slotOf = [&]() {
+        return location ? interpreter->environment->slotAt(location->first,
+                                                           location->second)
+                        : interpreter->globals->lookup(ident->name);
+      };
+
+      // `s = s + e` and `s += e` on a String append to the variable's own
+      // buffer instead of building a new string, keeping loops linear
+      auto *sum = dynamic_cast<BinaryExpr *>(node.right.get());
+      auto *self = sum && sum->op == TokenType::PLUS
+                       ? dynamic_cast<IdentifierExpr *>(sum->left.get())
+                       : nullptr;
+      if (self && self->name == ident->name &&
+          interpreter->getResolvedLocation(self) == location &&
+          isSideEffectFree(sum->right.get())) {
+        Value *slot = slotOf();
+        if (slot && std::holds_alternative<std::string>(*slot)) {
+          Value suffix = interpreter->evaluate(*sum->right);
+          appendValueString(std::get<std::string>(*slotOf()), suffix);
+          result = Value();
+          return;
+        }
+      }
+
+      Value value = interpreter->evaluate(*node.right);
       if (location) {
         interpreter->environment->assignAt(location->first, location->second,
                                            value);
@@ -140,6 +202,32 @@ void EvalVisitor::visit(BinaryExpr &node) {
       }
       throw std::runtime_error("Cannot assign to non-object field");
     }
+    // Handle indexed assignment (e.g., array[i] = value, map[key] = value)
+    else if (auto *access = dynamic_cast<ArrayAccessExpr *>(node.left.get())) {
+      Value target = interpreter->evaluate(*access->array);
+      Value index = interpreter->evaluate(*access->index);
+      Value value = interpreter->evaluate(*node.right);
+
+      if (auto *map = std::get_if<std::shared_ptr<MapValue>>(&target)) {
+        callMapMethod(*interpreter, *map, "set", {index, value});
+        result = value;
+        return;
+      }
+      if (auto *array = std::get_if<ArrayValue>(&target)) {
+        auto *i = std::get_if<int>(&index);
+        if (!i) {
+          throw std::runtime_error("Array index must be an integer");
+        }
+        if (*i < 0 || static_cast<size_t>(*i) >= array->size()) {
+          throw std::runtime_error("Array index out of bounds");
+        }
+        array->set(static_cast<size_t>(*i), value);
+        result = value;
+        return;
+      }
+      throw std::runtime_error("Cannot assign by index to " +
+                               getTypeOfValue(target));
+    }
     throw std::runtime_error("Invalid assignment target");
   }
 
@@ -190,8 +278,9 @@ void EvalVisitor::visit(BinaryExpr &node) {
     // Handle string concatenation FIRST
     if (std::holds_alternative<std::string>(left) ||
         std::holds_alternative<std::string>(right)) {
-      result = Value(interpreter->valueToString(left) +
-                     interpreter->valueToString(right));
+      std::string text = interpreter->valueToString(left);
+      appendValueString(text, right);
+      result = Value(std::move(text));
       return;
     }
 
@@ -429,15 +518,15 @@ void EvalVisitor::visit(CallExpr &node) {
       return;
     } else if (auto *array = std::get_if<ArrayValue>(&objValue)) {
       if (methodName == "size" && args.empty()) {
-        result = Value(static_cast<int>(array->elements->size()));
+        result = Value(static_cast<int>(array->size()));
         return;
       } else if (methodName == "contentToString" && args.empty()) {
         std::string content = "[";
-        for (size_t i = 0; i < array->elements->size(); ++i) {
+        for (size_t i = 0; i < array->size(); ++i) {
           if (i > 0) {
             content += ", ";
           }
-          content += interpreter->valueToString((*array->elements)[i]);
+          content += interpreter->valueToString(array->at(i));
         }
         content += "]";
         result = Value(content);
@@ -488,53 +577,32 @@ void EvalVisitor::visit(CallExpr &node) {
         }
       } else if (methodName == "remove") {
         if (args.size() == 1) {
-          Value elementToRemove = args[0];
-          bool found = false;
-          for (size_t i = 0; i < array->elements->size(); ++i) {
-            if (valuesEqual((*array->elements)[i], elementToRemove)) {
-              array->removeAt(i);
-              found = true;
-              break;
-            }
+          std::ptrdiff_t foundIndex = arrayIndexOf(*array, args[0]);
+          if (foundIndex >= 0) {
+            array->removeAt(static_cast<size_t>(foundIndex));
           }
-          result = Value(found);
+          result = Value(foundIndex >= 0);
           return;
         } else {
           throw std::runtime_error("remove method requires 1 argument");
         }
       } else if (methodName == "indexOf") {
         if (args.size() == 1) {
-          Value elementToFind = args[0];
-          int foundIndex = -1;
-          for (size_t i = 0; i < array->elements->size(); ++i) {
-            if (valuesEqual((*array->elements)[i], elementToFind)) {
-              foundIndex = static_cast<int>(i);
-              break;
-            }
-          }
-          result = Value(foundIndex);
+          result = Value(static_cast<int>(arrayIndexOf(*array, args[0])));
           return;
         } else {
           throw std::runtime_error("indexOf method requires 1 argument");
         }
       } else if (methodName == "contains") {
         if (args.size() == 1) {
-          Value elementToFind = args[0];
-          bool found = false;
-          for (const auto &element : *array->elements) {
-            if (valuesEqual(element, elementToFind)) {
-              found = true;
-              break;
-            }
-          }
-          result = Value(found);
+          result = Value(arrayIndexOf(*array, args[0]) >= 0);
           return;
         } else {
           throw std::runtime_error("contains method requires 1 argument");
         }
       } else if (methodName == "clear") {
         if (args.empty()) {
-          array->elements->clear();
+          array->clear();
           result = Value(); // Unit/Void
           return;
         } else {
@@ -542,125 +610,101 @@ void EvalVisitor::visit(CallExpr &node) {
         }
       } else if (methodName == "isEmpty") {
         if (args.empty()) {
-          result = Value(array->elements->empty());
+          result = Value(array->empty());
           return;
         } else {
           throw std::runtime_error("isEmpty method takes no arguments");
         }
-      } else if (methodName == "map") {
-        if (args.size() == 1) {
-          Value callback = args[0];
-          if (auto *lambda =
-                  std::get_if<std::shared_ptr<LambdaValue>>(&callback)) {
-            ArrayValue resultArr;
-            for (const auto &element : *array->elements) {
-              auto closure = (*lambda)->closure;
-              auto lambdaEnv = std::make_shared<Environment>(closure);
-              if (!(*lambda)->parameters.empty()) {
-                lambdaEnv->define((*lambda)->parameters[0].name, element);
-              } else {
-                lambdaEnv->define("it", element);
-              }
-              auto prevEnv = interpreter->environment;
-              auto prevFuncEnv = interpreter->functionEnvironment;
-              interpreter->environment = lambdaEnv;
-              interpreter->functionEnvironment = lambdaEnv;
-              Value mappedVal;
-              try {
-                mappedVal = interpreter->executeFunction(
-                    "lambda@map", (*lambda)->body.get(), lambdaEnv);
-              } catch (DotlinError &e) {
-                if (e.stackTrace.empty())
-                  e.setStackTrace(interpreter->callStack);
-                interpreter->environment = prevEnv;
-                interpreter->functionEnvironment = prevFuncEnv;
-                throw;
-              } catch (...) {
-                interpreter->environment = prevEnv;
-                interpreter->functionEnvironment = prevFuncEnv;
-                throw;
-              }
-              interpreter->environment = prevEnv;
-              interpreter->functionEnvironment = prevFuncEnv;
-              resultArr.elements->push_back(mappedVal);
-            }
-            result = Value(resultArr);
-            return;
-          }
-          throw std::runtime_error("map expects a lambda function");
-        }
-        throw std::runtime_error("map expects 1 argument");
-      } else if (methodName == "filter") {
-        if (args.size() == 1) {
-          Value callback = args[0];
-          if (auto *lambda =
-                  std::get_if<std::shared_ptr<LambdaValue>>(&callback)) {
-            ArrayValue resultArr;
-            for (const auto &element : *array->elements) {
-              auto closure = (*lambda)->closure;
-              auto lambdaEnv = std::make_shared<Environment>(closure);
-              if (!(*lambda)->parameters.empty()) {
-                lambdaEnv->define((*lambda)->parameters[0].name, element);
-              } else {
-                lambdaEnv->define("it", element);
-              }
-              auto prevEnv = interpreter->environment;
-              auto prevFuncEnv = interpreter->functionEnvironment;
-              interpreter->environment = lambdaEnv;
-              interpreter->functionEnvironment = lambdaEnv;
-              Value funcResult;
-              try {
-                funcResult = interpreter->executeFunction(
-                    "lambda@filter", (*lambda)->body.get(), lambdaEnv);
-              } catch (DotlinError &e) {
-                if (e.stackTrace.empty())
-                  e.setStackTrace(interpreter->callStack);
-                interpreter->environment = prevEnv;
-                interpreter->functionEnvironment = prevFuncEnv;
-                throw;
-              } catch (...) {
-                interpreter->environment = prevEnv;
-                interpreter->functionEnvironment = prevFuncEnv;
-                throw;
-              }
-              interpreter->environment = prevEnv;
-              interpreter->functionEnvironment = prevFuncEnv;
-
-              bool keep = false;
-              if (auto *b = std::get_if<bool>(&funcResult)) {
-                keep = *b;
-              }
-              if (keep) {
-                resultArr.elements->push_back(element);
-              }
-            }
-            result = Value(resultArr);
-            return;
-          }
-          throw std::runtime_error("filter expects a lambda function");
-        }
-        throw std::runtime_error("filter expects 1 argument");
+      } else if (methodName == "copyOf" && args.empty()) {
+        result = Value(array->copy());
+        return;
+      } else if (methodName == "sum" && args.empty()) {
+        result = arraySum(*array);
+        return;
+      } else if (methodName == "min" && args.empty()) {
+        result = arrayMin(*array);
+        return;
+      } else if (methodName == "max" && args.empty()) {
+        result = arrayMax(*array);
+        return;
+      } else if (methodName == "average" && args.empty()) {
+        result = arrayAverage(*array);
+        return;
+      } else if (methodName == "map" || methodName == "filter" ||
+                 methodName == "forEach" || methodName == "reduce" ||
+                 methodName == "fold" || methodName == "any" ||
+                 methodName == "all" || methodName == "count" ||
+                 methodName == "sumOf") {
+        result = callArrayHigherOrder(*interpreter, *array, methodName, args);
+        return;
+      } else if (methodName == "asSequence" && args.empty()) {
+        result = Value(sequenceOf(*array));
+        return;
+      } else if (methodName == "parallelMap" ||
+                 methodName == "parallelFilter" ||
+                 methodName == "parallelForEach" ||
+                 methodName == "parallelReduce") {
+        result = callArrayParallel(*interpreter, *array, methodName, args);
+        return;
+      } else if (methodName == "sort" || methodName == "sortDescending" ||
+                 methodName == "sorted" || methodName == "sortedDescending" ||
+                 methodName == "sortedBy" ||
+                 methodName == "sortedByDescending" ||
+                 methodName == "sortedWith" || methodName == "binarySearch") {
+        result = callArraySort(*interpreter, *array, methodName, args);
+        return;
+      } else if (methodName == "shuffle" && args.empty()) {
+        shuffleArray(interpreter->rng, *array);
+        result = Value();
+        return;
+      } else if ((methodName == "toSet" || methodName == "toMutableSet") &&
+                 args.empty()) {
+        result =
+            Value(makeSet(array->toValues(), methodName == "toMutableSet"));
+        return;
       }
+    } else if (auto *sequence =
+                   std::get_if<std::shared_ptr<SequenceValue>>(&objValue)) {
+      result = callSequenceMethod(*interpreter, *sequence, methodName, args);
+      return;
+    } else if (auto *map = std::get_if<std::shared_ptr<MapValue>>(&objValue)) {
+      result = callMapMethod(*interpreter, *map, methodName, args);
+      return;
+    } else if (auto *set = std::get_if<std::shared_ptr<SetValue>>(&objValue)) {
+      result = callSetMethod(*interpreter, *set, methodName, args);
+      return;
+    } else if (auto *builder =
+                   std::get_if<std::shared_ptr<StringBuilderValue>>(
+                       &objValue)) {
+      result = callStringBuilderMethod(*builder, methodName, args);
+      return;
+    } else if (auto *file =
+                   std::get_if<std::shared_ptr<FileValue>>(&objValue)) {
+      result = callFileMethod(*interpreter, *file, methodName, args);
+      return;
+    } else if (auto *writer = std::get_if<std::shared_ptr<FileWriterValue>>(
+                   &objValue)) {
+      result = callFileWriterMethod(*interpreter, *writer, methodName, args);
+      return;
     } else if (methodName == "substring" && args.size() >= 1) {
       // Handle substring method calls
       if (auto *strValue = std::get_if<std::string>(&objValue)) {
+        std::string_view str = *strValue;
         if (args.size() == 1 && std::holds_alternative<int>(args[0])) {
-          std::string str = *strValue;
           int start = std::get<int>(args[0]);
           if (start >= 0 && static_cast<size_t>(start) <= str.length()) {
-            result = Value(str.substr(static_cast<size_t>(start)));
+            result = Value(std::string(str.substr(static_cast<size_t>(start))));
           } else {
             result = Value(std::string(""));
           }
         } else if (args.size() == 2 && std::holds_alternative<int>(args[0]) &&
                    std::holds_alternative<int>(args[1])) {
-          std::string str = *strValue;
           int start = std::get<int>(args[0]);
           int end = std::get<int>(args[1]);
           if (start >= 0 && static_cast<size_t>(end) <= str.length() &&
               start <= end) {
-            result = Value(str.substr(static_cast<size_t>(start),
-                                      static_cast<size_t>(end - start)));
+            result = Value(std::string(str.substr(
+                static_cast<size_t>(start), static_cast<size_t>(end - start))));
           } else {
             result = Value(std::string(""));
           }
@@ -671,23 +715,26 @@ void EvalVisitor::visit(CallExpr &node) {
                std::holds_alternative<std::string>(args[0])) {
       // Handle indexOf method calls
       if (auto *strValue = std::get_if<std::string>(&objValue)) {
-        std::string str = *strValue;
-        std::string substr = std::get<std::string>(args[0]);
-        size_t pos = str.find(substr);
+        size_t pos = findSubstring(*strValue, std::get<std::string>(args[0]));
         result = Value(static_cast<int>(
             pos != std::string::npos ? static_cast<int>(pos) : -1));
       } else {
         result = Value(-1);
       }
       return;
+    } else if (methodName == "contains" && args.size() == 1 &&
+               std::holds_alternative<std::string>(objValue) &&
+               std::holds_alternative<std::string>(args[0])) {
+      result = Value(findSubstring(std::get<std::string>(objValue),
+                                   std::get<std::string>(args[0])) !=
+                     std::string::npos);
+      return;
     } else if (methodName == "startsWith" && args.size() == 1 &&
                std::holds_alternative<std::string>(args[0])) {
       // Handle startsWith method calls
       if (auto *strValue = std::get_if<std::string>(&objValue)) {
-        std::string str = *strValue;
-        std::string prefix = std::get<std::string>(args[0]);
-        result =
-            Value(static_cast<bool>(str.substr(0, prefix.length()) == prefix));
+        std::string_view str = *strValue;
+        result = Value(str.starts_with(std::get<std::string>(args[0])));
       } else {
         result = Value(false);
       }
@@ -696,15 +743,8 @@ void EvalVisitor::visit(CallExpr &node) {
                std::holds_alternative<std::string>(args[0])) {
       // Handle endsWith method calls
       if (auto *strValue = std::get_if<std::string>(&objValue)) {
-        std::string str = *strValue;
-        std::string suffix = std::get<std::string>(args[0]);
-        if (str.length() >= suffix.length()) {
-          result =
-              Value(static_cast<bool>(str.substr(str.length() - suffix.length(),
-                                                 suffix.length()) == suffix));
-        } else {
-          result = Value(false);
-        }
+        std::string_view str = *strValue;
+        result = Value(str.ends_with(std::get<std::string>(args[0])));
       } else {
         result = Value(false);
       }
@@ -713,8 +753,8 @@ void EvalVisitor::visit(CallExpr &node) {
       // Handle toUpperCase method calls
       if (auto *strValue = std::get_if<std::string>(&objValue)) {
         std::string str = *strValue;
-        std::transform(str.begin(), str.end(), str.begin(), ::toupper);
-        result = Value(str);
+        asciiToUpper(str.data(), str.data(), str.size());
+        result = Value(std::move(str));
       } else {
         result = Value(std::string(""));
       }
@@ -723,8 +763,8 @@ void EvalVisitor::visit(CallExpr &node) {
       // Handle toLowerCase method calls
       if (auto *strValue = std::get_if<std::string>(&objValue)) {
         std::string str = *strValue;
-        std::transform(str.begin(), str.end(), str.begin(), ::tolower);
-        result = Value(str);
+        asciiToLower(str.data(), str.data(), str.size());
+        result = Value(std::move(str));
       } else {
         result = Value(std::string(""));
       }
@@ -732,14 +772,7 @@ void EvalVisitor::visit(CallExpr &node) {
     } else if (methodName == "trim" && args.empty()) {
       // Handle trim method calls
       if (auto *strValue = std::get_if<std::string>(&objValue)) {
-        std::string str = *strValue;
-        size_t start = str.find_first_not_of(" \t\n\r\f\v");
-        if (start == std::string::npos) {
-          result = Value(str);
-        } else {
-          size_t end = str.find_last_not_of(" \t\n\r\f\v");
-          result = Value(str.substr(start, end - start + 1));
-        }
+        result = Value(std::string(trimView(*strValue)));
       } else {
         result = Value(std::string(""));
       }
@@ -748,35 +781,25 @@ void EvalVisitor::visit(CallExpr &node) {
                std::holds_alternative<std::string>(args[0])) {
       // Handle split method calls
       if (auto *strValue = std::get_if<std::string>(&objValue)) {
-        std::string str = *strValue;
-        std::string delim = std::get<std::string>(args[0]);
-        std::vector<Value> parts;
-        size_t pos = 0;
-        size_t delimLen = delim.length();
-        std::string remaining = str;
-
-        while ((pos = remaining.find(delim, pos)) != std::string::npos) {
-          parts.push_back(Value(remaining.substr(0, pos)));
-          pos += delimLen;
-          remaining = remaining.substr(pos);
-          pos = 0;
-        }
-        // Add the remaining part
-        parts.push_back(Value(remaining));
-        result = Value(ArrayValue(parts));
+        result = Value(toStringArray(
+            splitView(*strValue, std::get<std::string>(args[0]))));
       } else {
         result = Value(ArrayValue());
       }
       return;
+    } else if (methodName == "lines" && args.empty() &&
+               std::holds_alternative<std::string>(objValue)) {
+      result = Value(toStringArray(linesView(std::get<std::string>(objValue))));
+      return;
     } else if (methodName == "toInt" && args.empty()) {
       // Handle toInt method calls on String
       if (auto *strValue = std::get_if<std::string>(&objValue)) {
-        try {
-          result = Value(std::stoi(*strValue));
-        } catch (...) {
+        auto parsed = parseInt(*strValue);
+        if (!parsed) {
           throw std::runtime_error("Invalid number format for toInt: " +
                                    *strValue);
         }
+        result = Value(*parsed);
       } else if (auto *doubleValue = std::get_if<double>(&objValue)) {
         // Allow double -> int conversion via toInt()
         result = Value(static_cast<int>(*doubleValue));
@@ -791,12 +814,12 @@ void EvalVisitor::visit(CallExpr &node) {
     } else if (methodName == "toDouble" && args.empty()) {
       // Handle toDouble method calls on String
       if (auto *strValue = std::get_if<std::string>(&objValue)) {
-        try {
-          result = Value(std::stod(*strValue));
-        } catch (...) {
+        auto parsed = parseDouble(*strValue);
+        if (!parsed) {
           throw std::runtime_error("Invalid number format for toDouble: " +
                                    *strValue);
         }
+        result = Value(*parsed);
       } else if (auto *longValue = std::get_if<int64_t>(&objValue)) {
         // Allow long -> double conversion via toDouble()
         result = Value(static_cast<double>(*longValue));
@@ -805,6 +828,25 @@ void EvalVisitor::visit(CallExpr &node) {
             "toDouble method only supported on String, Int, and Long");
       }
       return;
+    } else if ((methodName == "toIntOrNull" || methodName == "toLongOrNull" ||
+                methodName == "toDoubleOrNull") &&
+               args.empty() && std::holds_alternative<std::string>(objValue)) {
+      // Kotlin's parse-or-null conversions; null when the text is not a
+      // number
+      const auto &text = std::get<std::string>(objValue);
+      result = Value(std::string("null"));
+      if (methodName == "toIntOrNull") {
+        if (auto parsed = parseInt(text)) {
+          result = Value(*parsed);
+        }
+      } else if (methodName == "toLongOrNull") {
+        if (auto parsed = parseLong(text)) {
+          result = Value(*parsed);
+        }
+      } else if (auto parsed = parseDouble(text)) {
+        result = Value(*parsed);
+      }
+      return;
     }
 
     // Check if the object is a class instance
@@ -819,15 +861,16 @@ void EvalVisitor::visit(CallExpr &node) {
             // Found the method, execute it
             auto methodEnv =
                 std::make_shared<Environment>(interpreter->environment);
-            methodEnv->define("this", Value(*instance));
+            methodEnv->bind(0, "this", Value(*instance));
 
-            // Bind method parameters to arguments
+            // Bind method parameters to arguments (slot 0 holds `this`)
             for (size_t i = 0; i < method->parameters.size(); ++i) {
+              int slot = static_cast<int>(i) + 1;
               if (i < node.arguments.size()) {
                 Value argValue = interpreter->evaluate(*node.arguments[i]);
-                methodEnv->define(method->parameters[i].name, argValue);
+                methodEnv->bind(slot, method->parameters[i].name, argValue);
               } else {
-                methodEnv->define(method->parameters[i].name, Value());
+                methodEnv->bind(slot, method->parameters[i].name, Value());
               }
             }
 
@@ -878,15 +921,18 @@ void EvalVisitor::visit(CallExpr &node) {
           // receiver
           if (!(*lambda)->parameters.empty()) {
             // Add the object instance as the first argument
-            extFuncEnv->define((*lambda)->parameters[0].name, Value(*instance));
+            extFuncEnv->bind(0, (*lambda)->parameters[0].name,
+                             Value(*instance));
 
             // Bind the rest of the parameters to the arguments
             for (size_t i = 1; i < (*lambda)->parameters.size(); ++i) {
               if (i - 1 < node.arguments.size()) {
                 Value argValue = interpreter->evaluate(*node.arguments[i - 1]);
-                extFuncEnv->define((*lambda)->parameters[i].name, argValue);
+                extFuncEnv->bind(static_cast<int>(i),
+                                 (*lambda)->parameters[i].name, argValue);
               } else {
-                extFuncEnv->define((*lambda)->parameters[i].name, Value());
+                extFuncEnv->bind(static_cast<int>(i),
+                                 (*lambda)->parameters[i].name, Value());
               }
             }
           } else {
@@ -970,15 +1016,17 @@ void EvalVisitor::visit(CallExpr &node) {
         // receiver
         if (!(*lambda)->parameters.empty()) {
           // Add the object value as the first argument
-          extFuncEnv->define((*lambda)->parameters[0].name, objValue);
+          extFuncEnv->bind(0, (*lambda)->parameters[0].name, objValue);
 
           // Bind the rest of the parameters to the arguments
           for (size_t i = 1; i < (*lambda)->parameters.size(); ++i) {
             if (i - 1 < node.arguments.size()) {
               Value argValue = interpreter->evaluate(*node.arguments[i - 1]);
-              extFuncEnv->define((*lambda)->parameters[i].name, argValue);
+              extFuncEnv->bind(static_cast<int>(i),
+                               (*lambda)->parameters[i].name, argValue);
             } else {
-              extFuncEnv->define((*lambda)->parameters[i].name, Value());
+              extFuncEnv->bind(static_cast<int>(i),
+                               (*lambda)->parameters[i].name, Value());
             }
           }
         } else {
@@ -1058,10 +1106,12 @@ void EvalVisitor::visit(CallExpr &node) {
     for (size_t i = 0; i < (*lambda)->parameters.size(); ++i) {
       if (i < node.arguments.size()) {
         Value argValue = interpreter->evaluate(*node.arguments[i]);
-        funcEnv->define((*lambda)->parameters[i].name, argValue);
+        funcEnv->bind(static_cast<int>(i), (*lambda)->parameters[i].name,
+                      argValue);
       } else {
         // Default parameter value
-        funcEnv->define((*lambda)->parameters[i].name, Value());
+        funcEnv->bind(static_cast<int>(i), (*lambda)->parameters[i].name,
+                      Value());
       }
     }
 
@@ -1184,11 +1234,12 @@ void EvalVisitor::visit(CallExpr &node) {
 
       if (bestMatch) {
         auto ctorEnv = std::make_shared<Environment>(interpreter->environment);
-        ctorEnv->define("this", Value(instance));
+        ctorEnv->bind(0, "this", Value(instance));
 
-        // Bind parameters
+        // Bind parameters (slot 0 holds `this`)
         for (size_t i = 0; i < bestMatch->parameters.size(); ++i) {
-          ctorEnv->define(bestMatch->parameters[i].name, argValues[i]);
+          ctorEnv->bind(static_cast<int>(i) + 1, bestMatch->parameters[i].name,
+                        argValues[i]);
         }
 
         auto prevFuncEnv = interpreter->functionEnvironment;
@@ -1227,7 +1278,8 @@ void EvalVisitor::visit(CallExpr &node) {
 
 void EvalVisitor::visit(MemberAccessExpr &node) {
   if (!node.object) {
-    std::cerr << "ERROR: Member access expression has null object" << std::endl;
+    DOTLIN_TRACE(Exec, Warn, "member access .", node.property, " at ",
+                 node.line, ":", node.column, " has no object");
     return;
   }
 
@@ -1240,17 +1292,17 @@ void EvalVisitor::visit(MemberAccessExpr &node) {
     if (identifier->name == "args") {
       if (node.property == "size") {
         if (auto *argsArray = std::get_if<ArrayValue>(&objValue)) {
-          result = Value(static_cast<int>(argsArray->elements->size()));
+          result = Value(static_cast<int>(argsArray->size()));
           return;
         }
       } else if (node.property == "contentToString") {
         if (auto *argsArray = std::get_if<ArrayValue>(&objValue)) {
           std::string content = "[";
-          for (size_t i = 0; i < argsArray->elements->size(); ++i) {
+          for (size_t i = 0; i < argsArray->size(); ++i) {
             if (i > 0) {
               content += ", ";
             }
-            content += valueToString((*argsArray->elements)[i]);
+            content += valueToString(argsArray->at(i));
           }
           content += "]";
           result = Value(content);
@@ -1278,19 +1330,13 @@ void EvalVisitor::visit(MemberAccessExpr &node) {
       result = Value(static_cast<int>(strValue->length()));
       return;
     } else if (node.property == "trim") {
-      std::string trimmedStr = *strValue;
-      size_t start = trimmedStr.find_first_not_of(" \t\n\r\f\v");
-      if (start == std::string::npos) {
-        result = Value(trimmedStr);
-      } else {
-        size_t end = trimmedStr.find_last_not_of(" \t\n\r\f\v");
-        result = Value(trimmedStr.substr(start, end - start + 1));
-      }
+      result = Value(std::string(trimView(*strValue)));
       return;
     } else if (node.property == "substring" || node.property == "indexOf" ||
                node.property == "startsWith" || node.property == "endsWith" ||
                node.property == "toUpperCase" ||
-               node.property == "toLowerCase" || node.property == "split") {
+               node.property == "toLowerCase" || node.property == "split" ||
+               node.property == "lines") {
       throw std::runtime_error("Method '" + node.property +
                                "' must be called with ()");
     } else if (node.property == "contentToString") {
@@ -1311,15 +1357,15 @@ void EvalVisitor::visit(MemberAccessExpr &node) {
   // Check if the object is an array
   if (auto *array = std::get_if<ArrayValue>(&objValue)) {
     if (node.property == "size") {
-      result = Value(static_cast<int>(array->elements->size()));
+      result = Value(static_cast<int>(array->size()));
       return;
     }
     if (node.property == "contentToString") {
       std::string content = "[";
-      for (size_t i = 0; i < array->elements->size(); ++i) {
+      for (size_t i = 0; i < array->size(); ++i) {
         if (i > 0)
           content += ", ";
-        content += valueToString((*array->elements)[i]);
+        content += valueToString(array->at(i));
       }
       content += "]";
       result = Value(content);
@@ -1330,16 +1376,62 @@ void EvalVisitor::visit(MemberAccessExpr &node) {
                              "'");
   }
 
+  // Map and set properties
+  if (auto *map = std::get_if<std::shared_ptr<MapValue>>(&objValue)) {
+    if (node.property == "size" || node.property == "keys" ||
+        node.property == "values" || node.property == "entries") {
+      result = callMapMethod(*interpreter, *map, node.property, {});
+      return;
+    }
+    throw std::runtime_error("Map does not have property '" + node.property +
+                             "'");
+  }
+  if (auto *set = std::get_if<std::shared_ptr<SetValue>>(&objValue)) {
+    if (node.property == "size") {
+      result = callSetMethod(*interpreter, *set, node.property, {});
+      return;
+    }
+    throw std::runtime_error("Set does not have property '" + node.property +
+                             "'");
+  }
+  if (auto *builder =
+          std::get_if<std::shared_ptr<StringBuilderValue>>(&objValue)) {
+    if (node.property == "length") {
+      result = callStringBuilderMethod(*builder, node.property, {});
+      return;
+    }
+    throw std::runtime_error("StringBuilder does not have property '" +
+                             node.property + "'");
+  }
+  if (auto *file = std::get_if<std::shared_ptr<FileValue>>(&objValue)) {
+    if (node.property == "path" || node.property == "name") {
+      result = callFileMethod(*interpreter, *file, node.property, {});
+      return;
+    }
+    throw std::runtime_error("File does not have property '" + node.property +
+                             "'");
+  }
+  if (auto *writer =
+          std::get_if<std::shared_ptr<FileWriterValue>>(&objValue)) {
+    if (node.property == "path" || node.property == "isOpen") {
+      result = callFileWriterMethod(*interpreter, *writer, node.property, {});
+      return;
+    }
+    throw std::runtime_error("FileWriter does not have property '" +
+                             node.property + "'");
+  }
+
   throw std::runtime_error("Cannot access member '" + node.property +
                            "' on type " + getTypeOfValue(objValue));
 }
 
 void EvalVisitor::visit(ArrayLiteralExpr &node) {
-  ArrayValue array;
+  std::vector<Value> elements;
+  elements.reserve(node.elements.size());
   for (const auto &element : node.elements) {
-    array.elements->push_back(interpreter->evaluate(*element));
+    elements.push_back(interpreter->evaluate(*element));
   }
-  result = Value(array);
+  result = Value(ArrayValue(std::move(elements)));
 }
 
 void EvalVisitor::visit(ArrayAccessExpr &node) {
@@ -1348,8 +1440,8 @@ void EvalVisitor::visit(ArrayAccessExpr &node) {
 
   if (auto *array = std::get_if<ArrayValue>(&arrayValue)) {
     if (auto *index = std::get_if<int>(&indexValue)) {
-      if (*index >= 0 && *index < static_cast<int>(array->elements->size())) {
-        result = (*array->elements)[static_cast<size_t>(*index)];
+      if (*index >= 0 && static_cast<size_t>(*index) < array->size()) {
+        result = array->at(static_cast<size_t>(*index));
         return;
       }
       throw std::runtime_error("Array index out of bounds");
@@ -1357,6 +1449,11 @@ void EvalVisitor::visit(ArrayAccessExpr &node) {
     throw std::runtime_error("Array index must be an integer");
   }
 
+  if (auto *map = std::get_if<std::shared_ptr<MapValue>>(&arrayValue)) {
+    result = mapGet(**map, indexValue);
+    return;
+  }
+
   throw std::runtime_error("Invalid array access");
 }
 
@@ -1406,9 +1503,9 @@ void EvalVisitor::visit(ForStmt &node) {
     auto loopScope = std::make_shared<Environment>(interpreter->environment);
 
     // Iterate through array elements
-    for (const auto &element : *arrayValue->elements) {
+    for (size_t i = 0; i < arrayValue->size(); ++i) {
       // Set the loop variable in the new scope
-      loopScope->define(node.variable, element);
+      loopScope->bind(0, node.variable, arrayValue->at(i));
 
       // Temporarily switch to loop scope
       auto oldEnv = interpreter->environment;
@@ -1,3 +1,4 @@
+#include "dotlin/collections.h"
 #include "dotlin/interpreter.h"
 #include "dotlin/parser.h"
 #include "dotlin/visitors.h"
@@ -21,8 +22,7 @@ void ExecVisitor::visit(VariableDeclStmt &node) {
   Value value;
   if (node.initializer) {
     if (!node.initializer.value()) {
-      std::cout << "CRITICAL: Initializer is NULL for " << node.name
-                << std::endl;
+      throw std::runtime_error("Missing initializer for " + node.name);
     }
     value = interpreter->evaluate(*node.initializer.value());
   }
@@ -37,7 +37,11 @@ void ExecVisitor::visit(FunctionDeclStmt &node) {
   // Create a lambda value for the function
   auto lambda = std::make_shared<LambdaValue>(node.parameters, node.body,
                                               interpreter->environment);
-  interpreter->environment->define(node.name, Value(lambda));
+  if (node.index != -1) {
+    interpreter->environment->bind(node.index, node.name, Value(lambda));
+  } else {
+    interpreter->environment->define(node.name, Value(lambda));
+  }
 
   // Store function definition for overload resolution and main function
   // detection
@@ -212,15 +216,24 @@ void ExecVisitor::visit(ForStmt &node) {
   // Evaluate the iterable expression
   Value iterableValue = interpreter->evaluate(*node.iterable);
 
+  // Maps yield [key, value] pairs and sets their elements, both from a
+  // snapshot so the body may update the collection
+  if (auto *map = std::get_if<std::shared_ptr<MapValue>>(&iterableValue)) {
+    iterableValue = Value(mapEntries(**map));
+  } else if (auto *set =
+                 std::get_if<std::shared_ptr<SetValue>>(&iterableValue)) {
+    iterableValue = Value(setElements(**set));
+  }
+
   // Check if it's an array
   if (auto *arrayValue = std::get_if<ArrayValue>(&iterableValue)) {
     // Create a new scope for the loop variable
     auto loopScope = std::make_shared<Environment>(interpreter->environment);
 
     // Iterate through array elements
-    for (const auto &element : *arrayValue->elements) {
+    for (size_t i = 0; i < arrayValue->size(); ++i) {
       // Set the loop variable in the new scope
-      loopScope->define(node.variable, element);
+      loopScope->bind(0, node.variable, arrayValue->at(i));
 
       // Temporarily switch to loop scope
       auto oldEnv = interpreter->environment;
@@ -287,7 +300,7 @@ void ExecVisitor::visit(TryStmt &node) {
     // Define the exception variable (remove "Runtime Error: " prefix if present
     // for cleaner access)
     std::string msg = e.what();
-    catchEnv->define(node.exceptionVar, Value(msg));
+    catchEnv->bind(0, node.exceptionVar, Value(msg));
 
     // Execute catch block in the new scope
     auto oldEnv = interpreter->environment;
@@ -0,0 +1,428 @@
+#include "dotlin/file_io.h"
+#include "dotlin/array_functions.h"
+#include "dotlin/input.h"
+#include "dotlin/lambda_frame.h"
+#include "dotlin/sequence.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define DOTLIN_OPEN _open
+#define DOTLIN_CLOSE _close
+#define DOTLIN_READ _read
+#define DOTLIN_WRITE _write
+#define DOTLIN_WRITE_FLAGS (_O_WRONLY | _O_CREAT | _O_BINARY)
+#define DOTLIN_APPEND _O_APPEND
+#define DOTLIN_TRUNCATE _O_TRUNC
+#define DOTLIN_FILE_MODE (_S_IREAD | _S_IWRITE)
+#define DOTLIN_READ_FLAGS (_O_RDONLY | _O_BINARY)
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#define DOTLIN_OPEN ::open
+#define DOTLIN_CLOSE ::close
+#define DOTLIN_READ ::read
+#define DOTLIN_WRITE ::write
+#define DOTLIN_WRITE_FLAGS (O_WRONLY | O_CREAT)
+#define DOTLIN_APPEND O_APPEND
+#define DOTLIN_TRUNCATE O_TRUNC
+#define DOTLIN_FILE_MODE 0666
+#define DOTLIN_READ_FLAGS O_RDONLY
+#endif
+
+namespace dotlin {
+
+namespace {
+
+constexpr size_t kWriteBufferSize = size_t{1} << 18;
+
+struct ArrayFileHeader {
+  char magic[8];
+  uint32_t byteOrder;
+  uint32_t elementType;
+  uint64_t count;
+  uint64_t reserved;
+};
+static_assert(sizeof(ArrayFileHeader) == 32);
+
+constexpr char kArrayMagic[8] = {'D', 'O', 'T', 'L', 'N', 'A', 'R', 'R'};
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr uint32_t kIntArray = 1;
+constexpr uint32_t kLongArray = 2;
+constexpr uint32_t kDoubleArray = 3;
+
+template <typename T>
+std::vector<T> copyElements(std::string_view bytes, size_t count) {
+  std::vector<T> data(count);
+  std::memcpy(data.data(), bytes.data(), count * sizeof(T));
+  return data;
+}
+
+} // namespace
+
+ReadDescriptor::ReadDescriptor(const std::string &path)
+    : fd(DOTLIN_OPEN(path.c_str(), DOTLIN_READ_FLAGS)) {
+  if (fd < 0) {
+    throw std::runtime_error("Could not open file: " + path + " (" +
+                             std::strerror(errno) + ")");
+  }
+}
+
+ReadDescriptor::~ReadDescriptor() { DOTLIN_CLOSE(fd); }
+
+MappedFile::MappedFile(int fd) {
+#ifndef _WIN32
+  struct stat info;
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+    return;
+  }
+  size_t size = static_cast<size_t>(info.st_size);
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapping == MAP_FAILED) {
+    return;
+  }
+  madvise(mapping, size, MADV_SEQUENTIAL);
+  bytes = std::string_view(static_cast<const char *>(mapping), size);
+#else
+  (void)fd;
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if (!bytes.empty()) {
+    munmap(const_cast<char *>(bytes.data()), bytes.size());
+  }
+#endif
+}
+
+FileWriterValue::FileWriterValue(std::string path, bool append)
+    : filePath(std::move(path)),
+      fd(DOTLIN_OPEN(filePath.c_str(),
+                     DOTLIN_WRITE_FLAGS |
+                         (append ? DOTLIN_APPEND : DOTLIN_TRUNCATE),
+                     DOTLIN_FILE_MODE)) {
+  if (fd < 0) {
+    throw std::runtime_error("Could not write to file: " + filePath + " (" +
+                             std::strerror(errno) + ")");
+  }
+  buffer.reserve(kWriteBufferSize);
+}
+
+FileWriterValue::~FileWriterValue() {
+  try {
+    close();
+  } catch (const std::exception &) {
+    // Nothing can report the error once the script has let go of the writer
+  }
+}
+
+void FileWriterValue::write(std::string_view text) {
+  if (!isOpen()) {
+    throw std::runtime_error("Cannot write to closed file: " + filePath);
+  }
+  if (buffer.size() + text.size() > kWriteBufferSize) {
+    flush();
+  }
+  if (text.size() >= kWriteBufferSize) {
+    writeAll(text);
+  } else {
+    buffer += text;
+  }
+}
+
+void FileWriterValue::flush() {
+  if (!isOpen()) {
+    throw std::runtime_error("Cannot flush closed file: " + filePath);
+  }
+  writeAll(buffer);
+  buffer.clear();
+}
+
+void FileWriterValue::close() {
+  if (!isOpen()) {
+    return;
+  }
+  // Close even when the final write fails, then report the failure
+  int closing = fd;
+  try {
+    flush();
+  } catch (...) {
+    fd = -1;
+    DOTLIN_CLOSE(closing);
+    throw;
+  }
+  fd = -1;
+  if (DOTLIN_CLOSE(closing) != 0) {
+    throw std::runtime_error("Could not close file: " + filePath + " (" +
+                             std::strerror(errno) + ")");
+  }
+}
+
+void FileWriterValue::writeAll(std::string_view text) {
+  while (!text.empty()) {
+    auto written = DOTLIN_WRITE(fd, text.data(), text.size());
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error("Could not write to file: " + filePath + " (" +
+                               std::strerror(errno) + ")");
+    }
+    text.remove_prefix(static_cast<size_t>(written));
+  }
+}
+
+std::string readFileContents(const std::string &path) {
+  ReadDescriptor file(path);
+  MappedFile mapping(file.get());
+  if (mapping.mapped()) {
+    return std::string(mapping.view());
+  }
+  std::string content;
+  // Files of unknown size: read blocks until the end
+  char block[1 << 16];
+  for (;;) {
+    auto got =
+        DOTLIN_READ(file.get(), block, static_cast<unsigned>(sizeof block));
+    if (got > 0) {
+      content.append(block, static_cast<size_t>(got));
+    } else if (got == 0) {
+      return content;
+    } else if (errno != EINTR) {
+      throw std::runtime_error("Could not read file: " + path + " (" +
+                               std::strerror(errno) + ")");
+    }
+  }
+}
+
+void saveArrayFile(const std::string &path, const ArrayValue &array) {
+  ArrayFileHeader header{};
+  std::memcpy(header.magic, kArrayMagic, sizeof kArrayMagic);
+  header.byteOrder = kByteOrderMark;
+  header.count = array.size();
+
+  std::string_view payload;
+  std::vector<int64_t> longs;
+  if (auto ints = array.elements<int>()) {
+    header.elementType = kIntArray;
+    payload = {reinterpret_cast<const char *>(ints->data()), ints->size_bytes()};
+  } else if (auto doubles = array.elements<double>()) {
+    header.elementType = kDoubleArray;
+    payload = {reinterpret_cast<const char *>(doubles->data()),
+               doubles->size_bytes()};
+  } else if (auto unboxed = array.elements<int64_t>()) {
+    header.elementType = kLongArray;
+    payload = {reinterpret_cast<const char *>(unboxed->data()),
+               unboxed->size_bytes()};
+  } else if (array.values()) {
+    // Long arrays are boxed; Int elements among them widen to Long
+    longs.reserve(array.size());
+    for (const Value &element : *array.values()) {
+      if (auto *l = std::get_if<int64_t>(&element)) {
+        longs.push_back(*l);
+      } else if (auto *i = std::get_if<int>(&element)) {
+        longs.push_back(*i);
+      } else {
+        throw std::runtime_error(
+            "saveArray() supports Int, Long and Double arrays, not " +
+            getTypeOfValue(element) + " elements");
+      }
+    }
+    header.elementType = array.empty() ? kIntArray : kLongArray;
+    payload = {reinterpret_cast<const char *>(longs.data()),
+               longs.size() * sizeof(int64_t)};
+  } else {
+    throw std::runtime_error(
+        "saveArray() supports Int, Long and Double arrays, not Boolean");
+  }
+
+  // Write a new file and rename it over the old one rather than truncating
+  // in place: arrays still mapped from the old file, possibly the one being
+  // saved, keep reading it
+  std::string temporary = path + ".tmp";
+  try {
+    FileWriterValue writer(temporary, false);
+    writer.write({reinterpret_cast<const char *>(&header), sizeof header});
+    writer.write(payload);
+    writer.close();
+    std::filesystem::rename(temporary, path);
+  } catch (const std::exception &error) {
+    std::error_code ignored;
+    std::filesystem::remove(temporary, ignored);
+    throw std::runtime_error("Could not write to file: " + path + " (" +
+                             error.what() + ")");
+  }
+}
+
+ArrayValue loadArrayFile(const std::string &path) {
+  ReadDescriptor file(path);
+  auto mapping = std::make_shared<const MappedFile>(file.get());
+  std::string content;
+  std::string_view bytes = mapping->view();
+  if (!mapping->mapped()) {
+    content = readFileContents(path);
+    bytes = content;
+  }
+
+  ArrayFileHeader header;
+  if (bytes.size() < sizeof header) {
+    throw std::runtime_error("Not an array file: " + path);
+  }
+  std::memcpy(&header, bytes.data(), sizeof header);
+  if (std::memcmp(header.magic, kArrayMagic, sizeof kArrayMagic) != 0) {
+    throw std::runtime_error("Not an array file: " + path);
+  }
+  if (header.byteOrder != kByteOrderMark) {
+    throw std::runtime_error("Array file was saved with a different byte "
+                             "order: " + path);
+  }
+  size_t width = header.elementType == kIntArray ? sizeof(int) : 8;
+  bytes.remove_prefix(sizeof header);
+  if (header.elementType < kIntArray || header.elementType > kDoubleArray ||
+      header.count > bytes.size() / width ||
+      header.count * width != bytes.size()) {
+    throw std::runtime_error("Corrupt array file: " + path);
+  }
+
+  size_t count = static_cast<size_t>(header.count);
+  ArrayElementType type = header.elementType == kIntArray ? ArrayElementType::INT
+                          : header.elementType == kLongArray
+                              ? ArrayElementType::LONG
+                              : ArrayElementType::DOUBLE;
+  if (mapping->mapped()) {
+    MappedElements elements;
+    elements.file = mapping;
+    elements.bytes = bytes.data();
+    elements.count = count;
+    elements.type = type;
+    return ArrayValue(std::move(elements));
+  }
+  // Without a mapping, copy the elements out of the contents read above
+  if (type == ArrayElementType::INT) {
+    return ArrayValue(copyElements<int>(bytes, count));
+  }
+  if (type == ArrayElementType::LONG) {
+    return ArrayValue(copyElements<int64_t>(bytes, count));
+  }
+  return ArrayValue(copyElements<double>(bytes, count));
+}
+
+void forEachFileLine(const std::string &path,
+                     const std::function<bool(const std::string &)> &onLine) {
+  ReadDescriptor file(path);
+  InputReader reader(file.get());
+  std::string line;
+  while (reader.readLine(line) && onLine(line)) {
+  }
+}
+
+Value callFileMethod(Interpreter &interpreter,
+                     const std::shared_ptr<FileValue> &file,
+                     const std::string &method,
+                     const std::vector<Value> &args) {
+  if (method == "path" && args.empty()) {
+    return Value(file->path);
+  }
+  if (method == "name" && args.empty()) {
+    return Value(std::filesystem::path(file->path).filename().string());
+  }
+  if (method == "exists" && args.empty()) {
+    return Value(std::filesystem::exists(file->path));
+  }
+  if (method == "delete" && args.empty()) {
+    // Like Kotlin's File.delete(): false instead of an error on failure
+    std::error_code error;
+    return Value(std::filesystem::remove(file->path, error));
+  }
+  if (method == "readText" && args.empty()) {
+    return Value(readFileContents(file->path));
+  }
+  if (method == "readLines" && args.empty()) {
+    std::vector<Value> lines;
+    forEachFileLine(file->path, [&](const std::string &line) {
+      lines.emplace_back(line);
+      return true;
+    });
+    return Value(ArrayValue(std::move(lines), ArrayElementType::STRING));
+  }
+  if (method == "lines" && args.empty()) {
+    return Value(fileLines(file->path));
+  }
+  if (method == "forEachLine") {
+    LambdaFrame frame(interpreter, lambdaArg(args, 0, method), 1,
+                      "lambda@forEachLine");
+    forEachFileLine(file->path, [&](const std::string &line) {
+      frame.call(Value(line));
+      return true;
+    });
+    return Value();
+  }
+  throw std::runtime_error("Cannot call method '" + method + "' on a File");
+}
+
+Value callFileWriterMethod(Interpreter &interpreter,
+                           const std::shared_ptr<FileWriterValue> &writer,
+                           const std::string &method,
+                           const std::vector<Value> &args) {
+  if (method == "write" && args.size() == 1) {
+    if (auto *text = std::get_if<std::string>(&args[0])) {
+      writer->write(*text);
+    } else {
+      std::string formatted;
+      appendValueString(formatted, args[0]);
+      writer->write(formatted);
+    }
+    return Value();
+  }
+  if (method == "writeLine" && args.size() <= 1) {
+    std::string line;
+    if (!args.empty()) {
+      appendValueString(line, args[0]);
+    }
+    line += '\n';
+    writer->write(line);
+    return Value();
+  }
+  if (method == "flush" && args.empty()) {
+    writer->flush();
+    return Value();
+  }
+  if (method == "close" && args.empty()) {
+    writer->close();
+    return Value();
+  }
+  if (method == "isOpen" && args.empty()) {
+    return Value(writer->isOpen());
+  }
+  if (method == "path" && args.empty()) {
+    return Value(writer->path());
+  }
+  if (method == "use") {
+    Value result;
+    try {
+      LambdaFrame frame(interpreter, lambdaArg(args, 0, method), 1,
+                        "lambda@use");
+      result = frame.call(Value(writer));
+    } catch (...) {
+      try {
+        writer->close();
+      } catch (const std::exception &) {
+        // The lambda's error is the one worth reporting
+      }
+      throw;
+    }
+    writer->close();
+    return result;
+  }
+  throw std::runtime_error("Cannot call method '" + method +
+                           "' on a FileWriter");
+}
+
+} // namespace dotlin
@@ -0,0 +1,337 @@
+#include "dotlin/hash_table.h"
+#include "dotlin/collections.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DOTLIN_HAVE_SSE2 1
+#endif
+
+namespace dotlin {
+
+bool valuesEqual(const Value &v1, const Value &v2);
+
+namespace {
+
+// Control bytes: a full slot holds the low 7 bits of its hash (0..127), free
+// slots have the sign bit set
+constexpr int8_t kEmpty = -128;
+constexpr int8_t kDeleted = -2;
+constexpr size_t kGroupWidth = 16;
+// Tables this small have no index; a scan of the cached hashes is faster
+// than building one
+constexpr size_t kLinearEntries = 8;
+
+uint64_t mix(uint64_t x) {
+  // splitmix64 finalizer: spreads every input bit over the whole word
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+uint64_t hashInteger(int64_t value) {
+  return mix(static_cast<uint64_t>(value));
+}
+
+// Bit i is set when control byte i of the group equals `tag`
+uint32_t matchTag(const int8_t *group, int8_t tag) {
+#ifdef DOTLIN_HAVE_SSE2
+  __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+  return static_cast<uint32_t>(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag))));
+#else
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kGroupWidth; ++i) {
+    if (group[i] == tag) {
+      mask |= 1u << i;
+    }
+  }
+  return mask;
+#endif
+}
+
+// Bit i is set when slot i of the group is empty or deleted
+uint32_t matchFree(const int8_t *group) {
+#ifdef DOTLIN_HAVE_SSE2
+  __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+  return static_cast<uint32_t>(_mm_movemask_epi8(ctrl));
+#else
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kGroupWidth; ++i) {
+    if (group[i] < 0) {
+      mask |= 1u << i;
+    }
+  }
+  return mask;
+#endif
+}
+
+int8_t tagOf(uint64_t hash) { return static_cast<int8_t>(hash & 0x7f); }
+
+// 0 marks erased entries, so real hashes never use it
+uint64_t entryHash(const Value &key) {
+  uint64_t hash = hashValue(key);
+  return hash == 0 ? 1 : hash;
+}
+
+size_t maxLoad(size_t slotCount) { return slotCount - slotCount / 8; }
+
+} // namespace
+
+uint64_t hashValue(const Value &value) {
+  return std::visit(
+      [](auto &&arg) -> uint64_t {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_same_v<T, int> || std::is_same_v<T, int64_t>) {
+          return hashInteger(arg);
+        } else if constexpr (std::is_same_v<T, double>) {
+          // Whole doubles hash like the Int/Long they compare equal to
+          if (std::trunc(arg) == arg && arg >= -9.2e18 && arg <= 9.2e18) {
+            return hashInteger(static_cast<int64_t>(arg));
+          }
+          return mix(std::bit_cast<uint64_t>(arg));
+        } else if constexpr (std::is_same_v<T, bool>) {
+          return mix(arg ? 0x51ed270b27cd5ULL : 0x2545f4914f6cdd1dULL);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+          return mix(std::hash<std::string>{}(arg));
+        } else if constexpr (std::is_same_v<T, ArrayValue>) {
+          uint64_t hash = arg.size();
+          for (size_t i = 0; i < arg.size(); ++i) {
+            hash = mix(hash + hashValue(arg.at(i)));
+          }
+          return hash;
+        } else if constexpr (std::is_same_v<T, std::shared_ptr<MapValue>> ||
+                             std::is_same_v<T, std::shared_ptr<SetValue>>) {
+          // Order-independent so equal maps built in any order match
+          const ValueTable &table = arg->table;
+          uint64_t hash = 0;
+          for (size_t i = 0; i < table.entryCount(); ++i) {
+            if (!table.isLive(i)) {
+              continue;
+            }
+            uint64_t entry = hashValue(table.keyAt(i));
+            if constexpr (std::is_same_v<T, std::shared_ptr<MapValue>>) {
+              entry = mix(entry ^ hashValue(table.valueAt(i)));
+            }
+            hash += entry;
+          }
+          return mix(hash + table.size());
+        } else {
+          return mix(reinterpret_cast<uintptr_t>(arg.get()));
+        }
+      },
+      value);
+}
+
+size_t ValueTable::findSlot(const Value &key, uint64_t hash) const {
+  if (control.empty()) {
+    return npos;
+  }
+  size_t groupMask = control.size() / kGroupWidth - 1;
+  size_t group = (hash >> 7) & groupMask;
+  int8_t tag = tagOf(hash);
+  // Triangular probing visits every group once when the count is a power
+  // of two
+  for (size_t step = 1;; ++step) {
+    const int8_t *ctrl = control.data() + group * kGroupWidth;
+    for (uint32_t mask = matchTag(ctrl, tag); mask != 0; mask &= mask - 1) {
+      size_t slot = group * kGroupWidth +
+                    static_cast<size_t>(std::countr_zero(mask));
+      uint32_t entry = slots[slot];
+      if (hashes[entry] == hash && valuesEqual(keys[entry], key)) {
+        return slot;
+      }
+    }
+    if (matchTag(ctrl, kEmpty) != 0 || step > groupMask) {
+      return npos;
+    }
+    group = (group + step) & groupMask;
+  }
+}
+
+size_t ValueTable::linearFind(const Value &key, uint64_t hash) const {
+  // Erased entries have hash 0, which no key has
+  for (size_t entry = 0; entry < keys.size(); ++entry) {
+    if (hashes[entry] == hash && valuesEqual(keys[entry], key)) {
+      return entry;
+    }
+  }
+  return npos;
+}
+
+size_t ValueTable::find(const Value &key) const {
+  uint64_t hash = entryHash(key);
+  if (control.empty()) {
+    return linearFind(key, hash);
+  }
+  size_t slot = findSlot(key, hash);
+  return slot == npos ? npos : slots[slot];
+}
+
+void ValueTable::placeEntry(uint32_t entry, uint64_t hash) {
+  size_t groupMask = control.size() / kGroupWidth - 1;
+  size_t group = (hash >> 7) & groupMask;
+  for (size_t step = 1;; ++step) {
+    const int8_t *ctrl = control.data() + group * kGroupWidth;
+    if (uint32_t mask = matchFree(ctrl)) {
+      size_t slot = group * kGroupWidth +
+                    static_cast<size_t>(std::countr_zero(mask));
+      if (control[slot] == kEmpty) {
+        ++used;
+      }
+      control[slot] = tagOf(hash);
+      slots[slot] = entry;
+      return;
+    }
+    group = (group + step) & groupMask;
+  }
+}
+
+void ValueTable::rebuild(size_t slotCount) {
+  // Drop erased entries so the dense list only holds live ones
+  size_t out = 0;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (hashes[i] == 0) {
+      continue;
+    }
+    if (out != i) {
+      keys[out] = std::move(keys[i]);
+      hashes[out] = hashes[i];
+      if (hasValues) {
+        values[out] = std::move(values[i]);
+      }
+    }
+    ++out;
+  }
+  keys.resize(out);
+  hashes.resize(out);
+  if (hasValues) {
+    values.resize(out);
+  }
+
+  control.assign(slotCount, kEmpty);
+  slots.assign(slotCount, 0);
+  used = 0;
+  if (slotCount == 0) {
+    return;
+  }
+  for (size_t i = 0; i < keys.size(); ++i) {
+    placeEntry(static_cast<uint32_t>(i), hashes[i]);
+  }
+}
+
+std::pair<size_t, bool> ValueTable::insert(const Value &key) {
+  uint64_t hash = entryHash(key);
+  if (control.empty()) {
+    size_t entry = linearFind(key, hash);
+    if (entry != npos) {
+      return {entry, false};
+    }
+    if (keys.size() < kLinearEntries) {
+      keys.push_back(key);
+      hashes.push_back(hash);
+      if (hasValues) {
+        values.emplace_back();
+      }
+      ++live;
+      return {keys.size() - 1, true};
+    }
+  } else {
+    size_t slot = findSlot(key, hash);
+    if (slot != npos) {
+      return {slots[slot], false};
+    }
+  }
+  if (keys.size() >= UINT32_MAX) {
+    throw std::runtime_error("Hash table is too large");
+  }
+  if (used + 1 > maxLoad(control.size())) {
+    // Double when live entries fill over half the maximum load; otherwise
+    // rebuilding at the same size just clears the deleted slots
+    size_t slotCount = std::max(control.size(), kGroupWidth);
+    while (live + 1 > maxLoad(slotCount) / 2) {
+      slotCount *= 2;
+    }
+    rebuild(slotCount);
+  }
+  size_t entry = keys.size();
+  keys.push_back(key);
+  hashes.push_back(hash);
+  if (hasValues) {
+    values.emplace_back();
+  }
+  placeEntry(static_cast<uint32_t>(entry), hash);
+  ++live;
+  return {entry, true};
+}
+
+bool ValueTable::erase(const Value &key) {
+  uint64_t hash = entryHash(key);
+  size_t entry;
+  if (control.empty()) {
+    entry = linearFind(key, hash);
+    if (entry == npos) {
+      return false;
+    }
+  } else {
+    size_t slot = findSlot(key, hash);
+    if (slot == npos) {
+      return false;
+    }
+    entry = slots[slot];
+    control[slot] = kDeleted;
+  }
+  hashes[entry] = 0;
+  keys[entry] = Value();
+  if (hasValues) {
+    values[entry] = Value();
+  }
+  --live;
+  // Compact once erased entries outnumber the live ones
+  if (keys.size() > 2 * live + kGroupWidth) {
+    rebuild(control.size());
+  }
+  return true;
+}
+
+void ValueTable::clear() {
+  keys.clear();
+  values.clear();
+  hashes.clear();
+  control.clear();
+  slots.clear();
+  live = 0;
+  used = 0;
+}
+
+void ValueTable::reserve(size_t count) {
+  if (control.empty() && count <= kLinearEntries) {
+    keys.reserve(count);
+    hashes.reserve(count);
+    if (hasValues) {
+      values.reserve(count);
+    }
+    return;
+  }
+  size_t slotCount = std::max(control.size(), kGroupWidth);
+  while (count > maxLoad(slotCount)) {
+    slotCount *= 2;
+  }
+  if (slotCount != control.size()) {
+    rebuild(slotCount);
+  }
+  keys.reserve(count);
+  hashes.reserve(count);
+  if (hasValues) {
+    values.reserve(count);
+  }
+}
+
+} // namespace dotlin
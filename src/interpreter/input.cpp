@@ -0,0 +1,214 @@
+#include "dotlin/input.h"
+#include "dotlin/number_format.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace dotlin {
+
+namespace {
+
+constexpr size_t kBlockSize = size_t{64} << 10;
+
+bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+} // namespace
+
+size_t readBlock(int fd, char *data, size_t n) {
+  for (;;) {
+#ifdef _WIN32
+    int got = ::_read(fd, data, static_cast<unsigned>(n));
+#else
+    ssize_t got = ::read(fd, data, n);
+#endif
+    if (got >= 0) {
+      return static_cast<size_t>(got);
+    }
+    if (errno != EINTR) {
+      throw std::runtime_error(std::string("Cannot read input: ") +
+                               std::strerror(errno));
+    }
+  }
+}
+
+InputReader::InputReader(int descriptor)
+    : fd(descriptor), buffer(kBlockSize) {}
+
+// Appends another block after the unread bytes, moving them to the front
+// first or growing the buffer when a line or token fills all of it.
+// Returns false at end of input.
+bool InputReader::fill() {
+  if (atEof) {
+    return false;
+  }
+  if (begin > 0) {
+    std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+    end -= begin;
+    begin = 0;
+  }
+  if (buffer.size() - end < kBlockSize / 2) {
+    buffer.resize(buffer.size() * 2);
+  }
+  size_t got = readBlock(fd, buffer.data() + end, buffer.size() - end);
+  if (got == 0) {
+    atEof = true;
+    return false;
+  }
+  end += got;
+  return true;
+}
+
+bool InputReader::readLine(std::string &line) {
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t scanned = begin;
+  for (;;) {
+    auto *newline = static_cast<const char *>(
+        std::memchr(buffer.data() + scanned, '\n', end - scanned));
+    if (newline) {
+      size_t stop = static_cast<size_t>(newline - buffer.data());
+      size_t length = stop - begin;
+      if (length > 0 && buffer[stop - 1] == '\r') {
+        --length;
+      }
+      line.assign(buffer.data() + begin, length);
+      begin = stop + 1;
+      return true;
+    }
+    size_t offset = end - begin;
+    if (!fill()) {
+      if (begin == end) {
+        return false;
+      }
+      // A last line without a line ending
+      line.assign(buffer.data() + begin, end - begin);
+      begin = end;
+      return true;
+    }
+    scanned = begin + offset;
+  }
+}
+
+ArrayValue InputReader::readAllLines() {
+  std::vector<Value> lines;
+  std::string line;
+  while (readLine(line)) {
+    lines.emplace_back(line);
+  }
+  return ArrayValue(std::move(lines), ArrayElementType::STRING);
+}
+
+// Skips blanks, and newlines unless `sameLine`, and returns the token that
+// follows as a view into the buffer, valid until the next fill. Empty when
+// the line or the input ends first.
+std::string_view InputReader::nextToken(bool sameLine) {
+  for (;;) {
+    while (begin < end &&
+           (isBlank(buffer[begin]) || (!sameLine && buffer[begin] == '\n'))) {
+      ++begin;
+    }
+    if (begin < end || !fill()) {
+      break;
+    }
+  }
+  if (begin == end || buffer[begin] == '\n') {
+    return {};
+  }
+  size_t stop = begin;
+  for (;;) {
+    while (stop < end && !isBlank(buffer[stop]) && buffer[stop] != '\n') {
+      ++stop;
+    }
+    if (stop < end) {
+      break;
+    }
+    // fill() may move the unread bytes to the front of the buffer, even
+    // when it then finds nothing more to read
+    size_t offset = stop - begin;
+    bool more = fill();
+    stop = begin + offset;
+    if (!more) {
+      break;
+    }
+  }
+  std::string_view token(buffer.data() + begin, stop - begin);
+  begin = stop;
+  return token;
+}
+
+// Consumes the rest of the current line, including its line ending
+void InputReader::finishLine() {
+  for (;;) {
+    while (begin < end && isBlank(buffer[begin])) {
+      ++begin;
+    }
+    if (begin < end) {
+      if (buffer[begin] == '\n') {
+        ++begin;
+      }
+      return;
+    }
+    if (!fill()) {
+      return;
+    }
+  }
+}
+
+template <typename T, typename Parse>
+std::vector<T> InputReader::readNumbers(std::optional<size_t> count,
+                                        const char *what, Parse parse) {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<T> values;
+  if (count) {
+    values.reserve(*count);
+  }
+  while (!count || values.size() < *count) {
+    std::string_view token = nextToken(!count);
+    if (token.empty()) {
+      if (count) {
+        throw std::runtime_error("Expected " + std::to_string(*count) + " " +
+                                 what + "s but input ended after " +
+                                 std::to_string(values.size()));
+      }
+      break;
+    }
+    auto value = parse(token);
+    if (!value) {
+      throw std::runtime_error("Invalid " + std::string(what) + " in input: " +
+                               std::string(token));
+    }
+    values.push_back(*value);
+  }
+  finishLine();
+  return values;
+}
+
+ArrayValue InputReader::readInts(std::optional<size_t> count) {
+  return ArrayValue(readNumbers<int>(count, "Int", parseInt));
+}
+
+ArrayValue InputReader::readDoubles(std::optional<size_t> count) {
+  return ArrayValue(readNumbers<double>(count, "Double", parseDouble));
+}
+
+ArrayValue InputReader::readWords() {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<Value> words;
+  for (std::string_view token = nextToken(true); !token.empty();
+       token = nextToken(true)) {
+    words.emplace_back(std::string(token));
+  }
+  finishLine();
+  return ArrayValue(std::move(words), ArrayElementType::STRING);
+}
+
+InputReader &standardInput() {
+  static InputReader reader(0);
+  return reader;
+}
+
+} // namespace dotlin
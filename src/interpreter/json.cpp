@@ -0,0 +1,602 @@
+#include "dotlin/json.h"
+#include "dotlin/collections.h"
+#include "dotlin/file_io.h"
+#include "dotlin/number_format.h"
+#include "dotlin/string_builder.h"
+#include "dotlin/string_kernels.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace dotlin {
+
+namespace {
+
+// ---- Stage 1: structural index ----
+
+// Quote, backslash, the six structural characters, then whitespace
+constexpr std::string_view kJsonChars{"\"\\{}[]:, \t\n\r", 12};
+
+// What one block passes on to the next
+struct IndexCarry {
+  bool escapeNext = false; // the block ended with an escaping backslash
+  uint64_t inString = 0;   // all ones when the block ended inside a string
+  uint64_t inLiteral = 0;  // 1 when its last byte belonged to a literal
+};
+
+// Bytes escaped by a backslash. A backslash that is itself escaped does
+// not escape the byte after it, so runs of them are walked in order; they
+// are rare enough that this costs little.
+uint64_t escapedBytes(uint64_t backslash, IndexCarry &carry) {
+  uint64_t escaped = carry.escapeNext ? 1 : 0;
+  carry.escapeNext = false;
+  for (uint64_t rest = backslash & ~escaped; rest != 0;) {
+    unsigned i = static_cast<unsigned>(std::countr_zero(rest));
+    if (i == 63) {
+      carry.escapeNext = true;
+      break;
+    }
+    escaped |= uint64_t{1} << (i + 1);
+    // Drop this backslash and the byte it escapes
+    rest &= ~((uint64_t{2} << (i + 1)) - 1);
+  }
+  return escaped;
+}
+
+// Blocks classified per kernel call
+constexpr size_t kBatchBlocks = 64;
+
+uint32_t *indexBlock(const uint64_t *masks, uint32_t base, IndexCarry &carry,
+                     uint32_t *out) {
+  uint64_t quote = masks[0];
+  uint64_t backslash = masks[1];
+  uint64_t structural =
+      masks[2] | masks[3] | masks[4] | masks[5] | masks[6] | masks[7];
+  uint64_t space = masks[8] | masks[9] | masks[10] | masks[11];
+
+  uint64_t escaped =
+      (backslash != 0 || carry.escapeNext) ? escapedBytes(backslash, carry)
+                                           : 0;
+  uint64_t realQuote = quote & ~escaped;
+  uint64_t inString = prefixXor(realQuote) ^ carry.inString;
+  carry.inString = (inString >> 63) ? ~uint64_t{0} : 0;
+
+  uint64_t literal = ~(structural | space | quote | inString);
+  uint64_t literalStart = literal & ~((literal << 1) | carry.inLiteral);
+  carry.inLiteral = literal >> 63;
+
+  uint64_t bits = (structural & ~inString) | realQuote | literalStart;
+  for (; bits != 0; bits &= bits - 1) {
+    *out++ = base + static_cast<uint32_t>(std::countr_zero(bits));
+  }
+  return out;
+}
+
+// ---- Stage 2: build values by walking the index ----
+
+constexpr unsigned kMaxDepth = 512;
+
+bool isJsonSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+void appendUtf8(std::string &out, uint32_t code) {
+  if (code < 0x80) {
+    out += static_cast<char>(code);
+  } else if (code < 0x800) {
+    out += static_cast<char>(0xc0 | (code >> 6));
+    out += static_cast<char>(0x80 | (code & 0x3f));
+  } else if (code < 0x10000) {
+    out += static_cast<char>(0xe0 | (code >> 12));
+    out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+    out += static_cast<char>(0x80 | (code & 0x3f));
+  } else {
+    out += static_cast<char>(0xf0 | (code >> 18));
+    out += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+    out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+    out += static_cast<char>(0x80 | (code & 0x3f));
+  }
+}
+
+class JsonParser {
+public:
+  JsonParser(std::string_view source, const std::vector<uint32_t> &offsets)
+      : text(source), index(offsets) {}
+
+  Value parseDocument() {
+    Value value = parseValue(0);
+    if (next < index.size()) {
+      fail(index[next], "unexpected content after the document");
+    }
+    return value;
+  }
+
+private:
+  std::string_view text;
+  const std::vector<uint32_t> &index;
+  size_t next = 0;
+  std::vector<Value> members;
+
+  [[noreturn]] void fail(size_t offset, const std::string &what) const {
+    throw std::runtime_error("Invalid JSON at offset " +
+                             std::to_string(offset) + ": " + what);
+  }
+
+  // Offset of the next token
+  size_t take(const char *expected) {
+    if (next == index.size()) {
+      fail(text.size(), std::string("expected ") + expected);
+    }
+    return index[next++];
+  }
+
+  char peek() const { return next < index.size() ? text[index[next]] : '\0'; }
+
+  Value parseValue(unsigned depth) {
+    size_t at = take("a value");
+    switch (text[at]) {
+    case '{':
+      return parseObject(at, depth);
+    case '[':
+      return parseArray(at, depth);
+    case '"':
+      return Value(parseString(at));
+    case '}':
+    case ']':
+    case ':':
+    case ',':
+      fail(at, std::string("unexpected '") + text[at] + "'");
+    default:
+      return parseLiteral(at);
+    }
+  }
+
+  Value parseObject(size_t at, unsigned depth) {
+    if (depth >= kMaxDepth) {
+      fail(at, "nested too deeply");
+    }
+    auto map = std::make_shared<MapValue>();
+    map->isMutable = true;
+    if (peek() == '}') {
+      ++next;
+      return Value(map);
+    }
+    // Members wait on a shared stack so the table is sized once; nested
+    // objects push above them and pop before this one resumes
+    size_t base = members.size();
+    for (;;) {
+      size_t keyAt = take("a key");
+      if (text[keyAt] != '"') {
+        fail(keyAt, "expected a string key");
+      }
+      members.emplace_back(parseString(keyAt));
+      size_t colon = take("':'");
+      if (text[colon] != ':') {
+        fail(colon, "expected ':'");
+      }
+      members.push_back(parseValue(depth + 1));
+      size_t separator = take("',' or '}'");
+      if (text[separator] == '}') {
+        break;
+      }
+      if (text[separator] != ',') {
+        fail(separator, "expected ',' or '}'");
+      }
+    }
+    map->table.reserve((members.size() - base) / 2);
+    for (size_t i = base; i < members.size(); i += 2) {
+      // A repeated key keeps its first position and its last value
+      size_t entry = map->table.insert(members[i]).first;
+      map->table.valueAt(entry) = std::move(members[i + 1]);
+    }
+    members.resize(base);
+    return Value(map);
+  }
+
+  Value parseArray(size_t at, unsigned depth) {
+    if (depth >= kMaxDepth) {
+      fail(at, "nested too deeply");
+    }
+    std::vector<Value> elements;
+    if (peek() == ']') {
+      ++next;
+      return Value(ArrayValue(std::move(elements)));
+    }
+    for (;;) {
+      elements.push_back(parseValue(depth + 1));
+      size_t separator = take("',' or ']'");
+      if (text[separator] == ']') {
+        return Value(ArrayValue(std::move(elements)));
+      }
+      if (text[separator] != ',') {
+        fail(separator, "expected ',' or ']'");
+      }
+    }
+  }
+
+  // Stage 1 pairs the quotes, so the next token closes the string
+  std::string parseString(size_t open) {
+    size_t close = take("'\"'");
+    std::string_view raw = text.substr(open + 1, close - open - 1);
+    // Strings without escapes are copied as they are, once checked for raw
+    // control characters
+    for (size_t i = 0; i < raw.size(); ++i) {
+      if (static_cast<unsigned char>(raw[i]) < 0x20) {
+        fail(open + 1 + i, "invalid control character");
+      }
+      if (raw[i] == '\\') {
+        return unescape(raw, open + 1);
+      }
+    }
+    return std::string(raw);
+  }
+
+  std::string unescape(std::string_view raw, size_t offset) const {
+    std::string out;
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+      if (raw[i] != '\\') {
+        if (static_cast<unsigned char>(raw[i]) < 0x20) {
+          fail(offset + i, "invalid control character");
+        }
+        out += raw[i];
+        continue;
+      }
+      // Stage 1 never ends a string on an escaping backslash
+      char c = raw[++i];
+      switch (c) {
+      case '"':
+      case '\\':
+      case '/':
+        out += c;
+        break;
+      case 'b':
+        out += '\b';
+        break;
+      case 'f':
+        out += '\f';
+        break;
+      case 'n':
+        out += '\n';
+        break;
+      case 'r':
+        out += '\r';
+        break;
+      case 't':
+        out += '\t';
+        break;
+      case 'u': {
+        uint32_t code = hex4(raw, i + 1, offset);
+        i += 4;
+        // A high surrogate followed by a low one encodes one code point
+        if (code >= 0xd800 && code < 0xdc00 && i + 6 < raw.size() &&
+            raw[i + 1] == '\\' && raw[i + 2] == 'u') {
+          uint32_t low = hex4(raw, i + 3, offset);
+          if (low >= 0xdc00 && low < 0xe000) {
+            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+            i += 6;
+          }
+        }
+        appendUtf8(out, code);
+        break;
+      }
+      default:
+        fail(offset + i, std::string("invalid escape '\\") + c + "'");
+      }
+    }
+    return out;
+  }
+
+  uint32_t hex4(std::string_view raw, size_t at, size_t offset) const {
+    if (at + 4 > raw.size()) {
+      fail(offset + at, "truncated \\u escape");
+    }
+    uint32_t code = 0;
+    for (size_t i = at; i < at + 4; ++i) {
+      char c = raw[i];
+      uint32_t digit;
+      if (isDigit(c)) {
+        digit = static_cast<uint32_t>(c - '0');
+      } else if (c >= 'a' && c <= 'f') {
+        digit = static_cast<uint32_t>(c - 'a' + 10);
+      } else if (c >= 'A' && c <= 'F') {
+        digit = static_cast<uint32_t>(c - 'A' + 10);
+      } else {
+        fail(offset + i, "invalid \\u escape");
+      }
+      code = code << 4 | digit;
+    }
+    return code;
+  }
+
+  // true, false, null or a number, which runs up to the next token
+  Value parseLiteral(size_t at) {
+    size_t end = next < index.size() ? index[next] : text.size();
+    std::string_view token = text.substr(at, end - at);
+    while (!token.empty() && isJsonSpace(token.back())) {
+      token.remove_suffix(1);
+    }
+    if (token == "true") {
+      return Value(true);
+    }
+    if (token == "false") {
+      return Value(false);
+    }
+    if (token == "null") {
+      return Value(std::string("null"));
+    }
+    return parseNumber(token, at);
+  }
+
+  // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+  Value parseNumber(std::string_view token, size_t at) const {
+    size_t i = 0;
+    auto digits = [&] {
+      size_t start = i;
+      while (i < token.size() && isDigit(token[i])) {
+        ++i;
+      }
+      return i > start;
+    };
+    if (i < token.size() && token[i] == '-') {
+      ++i;
+    }
+    bool leadingZero = i < token.size() && token[i] == '0';
+    size_t intStart = i;
+    bool valid = digits() && !(leadingZero && i - intStart > 1);
+    bool integral = true;
+    if (valid && i < token.size() && token[i] == '.') {
+      ++i;
+      valid = digits();
+      integral = false;
+    }
+    if (valid && i < token.size() && (token[i] == 'e' || token[i] == 'E')) {
+      ++i;
+      if (i < token.size() && (token[i] == '+' || token[i] == '-')) {
+        ++i;
+      }
+      valid = digits();
+      integral = false;
+    }
+    if (!valid || i != token.size()) {
+      fail(at, "invalid literal '" + std::string(token) + "'");
+    }
+
+    if (integral) {
+      if (auto value = parseLong(token)) {
+        if (*value >= std::numeric_limits<int>::min() &&
+            *value <= std::numeric_limits<int>::max()) {
+          return Value(static_cast<int>(*value));
+        }
+        return Value(*value);
+      }
+    }
+    // Fractions, exponents and integers too large for a Long
+    return Value(*parseDouble(token));
+  }
+};
+
+// ---- Serializer ----
+
+void appendJsonString(std::string &out, std::string_view text) {
+  static const char hex[] = "0123456789abcdef";
+  out += '"';
+  size_t run = 0;
+  for (size_t i = 0; i < text.size(); ++i) {
+    auto c = static_cast<unsigned char>(text[i]);
+    if (c != '"' && c != '\\' && c >= 0x20) {
+      continue;
+    }
+    out.append(text.data() + run, i - run);
+    run = i + 1;
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      out += "\\u00";
+      out += hex[c >> 4];
+      out += hex[c & 0xf];
+    }
+  }
+  out.append(text.data() + run, text.size() - run);
+  out += '"';
+}
+
+void appendJsonDouble(std::string &out, double value) {
+  if (std::isfinite(value)) {
+    appendNumber(out, value);
+  } else {
+    out += "null";
+  }
+}
+
+// Fields in declaration order, base class first, then any others by name
+std::vector<std::string> fieldOrder(const ClassInstance &instance) {
+  std::vector<const ClassDefinition *> chain;
+  for (auto *def = instance.classDef.get(); def; def = def->superclass.get()) {
+    chain.push_back(def);
+  }
+  std::vector<std::string> names;
+  for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+    for (const auto &field : (*it)->fields) {
+      if (instance.fields.count(field.first) &&
+          std::find(names.begin(), names.end(), field.first) == names.end()) {
+        names.push_back(field.first);
+      }
+    }
+  }
+  std::vector<std::string> others;
+  for (const auto &field : instance.fields) {
+    if (std::find(names.begin(), names.end(), field.first) == names.end()) {
+      others.push_back(field.first);
+    }
+  }
+  std::sort(others.begin(), others.end());
+  names.insert(names.end(), others.begin(), others.end());
+  return names;
+}
+
+} // namespace
+
+void indexJson(std::string_view text, std::vector<uint32_t> &index) {
+  if (text.size() > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("parseJson() supports documents up to 4 GiB");
+  }
+  // Typical documents have an entry every four bytes or more
+  index.resize(text.size() / 4 + kBatchBlocks * 64);
+  uint64_t masks[kBatchBlocks * kJsonChars.size()];
+  IndexCarry carry;
+  size_t count = 0;
+  size_t i = 0;
+  while (i < text.size()) {
+    size_t blocks = std::min(kBatchBlocks, (text.size() - i) / 64);
+    const char *data = text.data() + i;
+    // The last partial block is padded with spaces
+    char tail[64];
+    if (blocks == 0) {
+      std::memset(tail, ' ', sizeof tail);
+      std::memcpy(tail, data, text.size() - i);
+      data = tail;
+      blocks = 1;
+    }
+    byteMasks64(data, blocks, kJsonChars, masks);
+
+    // Each byte yields at most one entry
+    if (index.size() < count + blocks * 64) {
+      index.resize(std::max(index.size() * 2, count + blocks * 64));
+    }
+    uint32_t *out = index.data() + count;
+    IndexCarry local = carry;
+    for (size_t b = 0; b < blocks; ++b, i += 64) {
+      out = indexBlock(masks + b * kJsonChars.size(),
+                       static_cast<uint32_t>(i), local, out);
+    }
+    carry = local;
+    count = static_cast<size_t>(out - index.data());
+  }
+  index.resize(count);
+  if (carry.inString) {
+    throw std::runtime_error("Invalid JSON: unterminated string");
+  }
+}
+
+Value parseJson(std::string_view text) {
+  std::vector<uint32_t> index;
+  indexJson(text, index);
+  return JsonParser(text, index).parseDocument();
+}
+
+void appendJson(std::string &out, const Value &value) {
+  if (auto *str = std::get_if<std::string>(&value)) {
+    if (*str == "null") {
+      out += "null";
+    } else {
+      appendJsonString(out, *str);
+    }
+  } else if (auto *i = std::get_if<int>(&value)) {
+    appendNumber(out, *i);
+  } else if (auto *l = std::get_if<int64_t>(&value)) {
+    appendNumber(out, *l);
+  } else if (auto *d = std::get_if<double>(&value)) {
+    appendJsonDouble(out, *d);
+  } else if (auto *b = std::get_if<bool>(&value)) {
+    out += *b ? "true" : "false";
+  } else if (auto *array = std::get_if<ArrayValue>(&value)) {
+    out += '[';
+    if (auto ints = array->elements<int>()) {
+      for (size_t k = 0; k < ints->size(); ++k) {
+        if (k > 0) {
+          out += ',';
+        }
+        appendNumber(out, (*ints)[k]);
+      }
+    } else if (auto doubles = array->elements<double>()) {
+      for (size_t k = 0; k < doubles->size(); ++k) {
+        if (k > 0) {
+          out += ',';
+        }
+        appendJsonDouble(out, (*doubles)[k]);
+      }
+    } else {
+      for (size_t k = 0; k < array->size(); ++k) {
+        if (k > 0) {
+          out += ',';
+        }
+        appendJson(out, array->at(k));
+      }
+    }
+    out += ']';
+  } else if (auto *map = std::get_if<std::shared_ptr<MapValue>>(&value)) {
+    const ValueTable &table = (*map)->table;
+    out += '{';
+    bool first = true;
+    for (size_t k = 0; k < table.entryCount(); ++k) {
+      if (!table.isLive(k)) {
+        continue;
+      }
+      if (!first) {
+        out += ',';
+      }
+      first = false;
+      const Value &key = table.keyAt(k);
+      if (auto *name = std::get_if<std::string>(&key)) {
+        appendJsonString(out, *name);
+      } else {
+        appendJsonString(out, valueToString(key));
+      }
+      out += ':';
+      appendJson(out, table.valueAt(k));
+    }
+    out += '}';
+  } else if (auto *set = std::get_if<std::shared_ptr<SetValue>>(&value)) {
+    appendJson(out, Value(setElements(**set)));
+  } else if (auto *instance =
+                 std::get_if<std::shared_ptr<ClassInstance>>(&value)) {
+    out += '{';
+    bool first = true;
+    for (const std::string &name : fieldOrder(**instance)) {
+      if (!first) {
+        out += ',';
+      }
+      first = false;
+      appendJsonString(out, name);
+      out += ':';
+      appendJson(out, (*instance)->fields.at(name));
+    }
+    out += '}';
+  } else if (auto *builder =
+                 std::get_if<std::shared_ptr<StringBuilderValue>>(&value)) {
+    appendJsonString(out, (*builder)->buffer);
+  } else if (auto *file = std::get_if<std::shared_ptr<FileValue>>(&value)) {
+    appendJsonString(out, (*file)->path);
+  } else {
+    throw std::runtime_error("toJson() cannot encode a " +
+                             getTypeOfValue(value));
+  }
+}
+
+std::string toJson(const Value &value) {
+  std::string out;
+  appendJson(out, value);
+  return out;
+}
+
+} // namespace dotlin
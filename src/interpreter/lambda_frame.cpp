@@ -0,0 +1,101 @@
+#include "dotlin/lambda_frame.h"
+#include <stdexcept>
+#include <string_view>
+
+namespace dotlin {
+
+LambdaFrame::LambdaFrame(Interpreter &interp,
+                         std::shared_ptr<LambdaValue> fn, size_t n,
+                         std::string frameName)
+    : interpreter(interp), lambda(std::move(fn)), arity(n) {
+  size_t declared = lambda->parameters.size();
+  if (declared != arity && !(declared == 0 && arity == 1)) {
+    throw std::runtime_error(frameName + " expects a lambda with " +
+                             std::to_string(arity) +
+                             (arity == 1 ? " parameter" : " parameters"));
+  }
+  block = dynamic_cast<const BlockStmt *>(lambda->body.get());
+  allocate();
+  interpreter.callStack.push_back(std::move(frameName));
+}
+
+LambdaFrame::~LambdaFrame() { interpreter.callStack.pop_back(); }
+
+void LambdaFrame::allocate() {
+  frameEnv = std::make_shared<Environment>(lambda->closure);
+  frameEnv->indexedValues.resize(arity);
+  for (size_t i = 0; i < arity; ++i) {
+    const std::string &name =
+        lambda->parameters.empty() ? "it" : lambda->parameters[i].name;
+    namedSlots[i] = &frameEnv->values[name];
+  }
+  bodyEnv = block ? std::make_shared<Environment>(frameEnv) : nullptr;
+}
+
+void LambdaFrame::bind(size_t index, const Value &value) {
+  frameEnv->indexedValues[index] = value;
+  *namedSlots[index] = value;
+}
+
+Value LambdaFrame::call() { return run(); }
+
+Value LambdaFrame::call(const Value &arg) {
+  bind(0, arg);
+  return run();
+}
+
+Value LambdaFrame::call(const Value &first, const Value &second) {
+  bind(0, first);
+  bind(1, second);
+  return run();
+}
+
+Value LambdaFrame::run() {
+  if (!lambda->body) {
+    return Value();
+  }
+
+  auto previousEnv = interpreter.environment;
+  auto previousFuncEnv = interpreter.functionEnvironment;
+  interpreter.functionEnvironment = frameEnv;
+  interpreter.lastEvaluatedValue = Value();
+
+  try {
+    if (block) {
+      interpreter.environment = bodyEnv;
+      for (const auto &stmt : block->statements) {
+        if (stmt) {
+          interpreter.execute(*stmt);
+        }
+      }
+    } else {
+      interpreter.environment = frameEnv;
+      interpreter.execute(*lambda->body);
+    }
+  } catch (DotlinError &e) {
+    if (e.stackTrace.empty()) {
+      e.setStackTrace(interpreter.callStack);
+    }
+    interpreter.environment = previousEnv;
+    interpreter.functionEnvironment = previousFuncEnv;
+    throw;
+  } catch (const std::runtime_error &e) {
+    interpreter.environment = previousEnv;
+    interpreter.functionEnvironment = previousFuncEnv;
+    if (std::string_view(e.what()) != "RETURN_SIGNAL") {
+      throw;
+    }
+  }
+  interpreter.environment = previousEnv;
+  interpreter.functionEnvironment = previousFuncEnv;
+
+  // A closure created by the body now shares these environments; give the
+  // next call its own so the closure keeps the bindings it saw.
+  long expected = bodyEnv ? 2 : 1;
+  if (frameEnv.use_count() > expected || (bodyEnv && bodyEnv.use_count() > 1)) {
+    allocate();
+  }
+  return interpreter.lastEvaluatedValue;
+}
+
+} // namespace dotlin
@@ -1,5 +1,7 @@
+#include "dotlin/benchmark.h"
 #include "dotlin/interpreter.h"
 #include "dotlin/parser.h"
+#include "dotlin/trace.h"
 #include "dotlin/visitors.h"
 // #include <chrono>
 // #include <iostream>
@@ -10,6 +12,17 @@ using namespace dotlin;
 
 namespace dotlin {
 
+namespace {
+
+template <typename Pass>
+void timePhase(std::vector<PhaseTime> &phases, const char *name, Pass pass) {
+  int64_t start = nanoTime();
+  pass();
+  phases.push_back({name, nanoTime() - start});
+}
+
+} // namespace
+
 // Define the static member
 std::map<std::string, std::vector<std::shared_ptr<FunctionDef>>>
     Interpreter::functionDefinitions;
@@ -25,29 +38,36 @@ std::string Interpreter::typeToString(const std::shared_ptr<Type> &type) {
 Interpreter::Interpreter()
     : globals(std::make_shared<Environment>()), environment(globals),
       functionEnvironment(nullptr), hasMainFunction(false),
-      mainFunctionStmt(nullptr), commandLineArgs({}) {}
+      mainFunctionStmt(nullptr), commandLineArgs({}),
+      output(std::make_shared<OutputSink>()),
+      locals(std::make_shared<
+             std::map<const Expression *, std::pair<int, int>>>()) {}
+
+Interpreter::Interpreter(const Interpreter &parent, const Random &generator)
+    : globals(parent.globals), environment(parent.environment),
+      functionEnvironment(parent.functionEnvironment),
+      hasMainFunction(parent.hasMainFunction), mainFunctionStmt(nullptr),
+      argsArray(parent.argsArray), callStack(parent.callStack),
+      sourceName(parent.sourceName), output(parent.output), rng(generator),
+      optimizationLevel(parent.optimizationLevel), locals(parent.locals) {}
+
+std::unique_ptr<Interpreter> Interpreter::fork(const Random &generator) const {
+  return std::unique_ptr<Interpreter>(new Interpreter(*this, generator));
+}
 
 void Interpreter::resolve(const Expression *expr, int depth, int index) {
-  locals[expr] = {depth, index};
+  (*locals)[expr] = {depth, index};
 }
 
 std::optional<std::pair<int, int>>
 Interpreter::getResolvedLocation(const Expression *expr) {
-  auto it = locals.find(expr);
-  if (it != locals.end()) {
+  auto it = locals->find(expr);
+  if (it != locals->end()) {
     return it->second;
   }
   return std::nullopt;
 }
 
-// Helper to trace lookups in Evaluator (will be called from Evaluator)
-void Interpreter::traceLookup(const std::string &name,
-                              std::optional<int> distance) {
-  std::cout << "[DEBUG] Looking up '" << name << "' at distance "
-            << (distance.has_value() ? std::to_string(*distance) : "global")
-            << std::endl;
-}
-
 Value Interpreter::interpret(const Program &program) {
   std::vector<std::string> empty_args;
   return interpret(program, empty_args, sourceName);
@@ -64,12 +84,24 @@ Value Interpreter::interpret(const Program &program,
   sourceName = srcName;
   // Store command-line arguments
   commandLineArgs = args;
+  std::vector<Value> argValues(commandLineArgs.begin(), commandLineArgs.end());
+  argsArray = ArrayValue(std::move(argValues));
+
+  phaseTimes.clear();
+  auto &mutableProgram = const_cast<Program &>(program);
+  // Nothing at run time reads the inferred types, so O0 skips the checker
+  if (optimizationLevel != OptimizationLevel::O0) {
+    timePhase(phaseTimes, "typeInference",
+              [&] { performTypeInference(mutableProgram); });
+  }
+  performOptimization(mutableProgram);
 
-  // Perform type inference before execution
-  performTypeInference(const_cast<Program &>(program));
-
-  // Perform optimizations
-  performOptimization(const_cast<Program &>(program));
+  // Records the execution time on every way out, including exceptions
+  struct ExecutionTimer {
+    std::vector<PhaseTime> &phases;
+    int64_t start = nanoTime();
+    ~ExecutionTimer() { phases.push_back({"execute", nanoTime() - start}); }
+  } executionTimer{phaseTimes};
 
   // First, execute all statements to register functions and declare variables
   for (const auto &stmt : program.statements) {
@@ -92,7 +124,8 @@ Value Interpreter::interpret(const Program &program,
       for (size_t i = 0; i < mainDef->parameters.size(); ++i) {
         std::string paramName = mainDef->parameters[i].name;
         if (i < commandLineArgs.size()) {
-          environment->define(paramName, commandLineArgs[i]);
+          environment->bind(static_cast<int>(i), paramName,
+                            commandLineArgs[i]);
         } else {
           Value defaultValue;
           if (mainDef->parameters[i].typeAnnotation.has_value() &&
@@ -116,7 +149,7 @@ Value Interpreter::interpret(const Program &program,
               break;
             }
           }
-          environment->define(paramName, defaultValue);
+          environment->bind(static_cast<int>(i), paramName, defaultValue);
         }
       }
 
@@ -210,6 +243,7 @@ Value Interpreter::executeFunction(const std::string &name, Statement *body,
   lastEvaluatedValue = Value();
 
   callStack.push_back(name);
+  DOTLIN_TRACE(Exec, Info, "call ", name, " at depth ", callStack.size());
 
   try {
     execute(*body);
@@ -315,6 +349,7 @@ void Interpreter::performTypeInference(Program &program) {
   typeEnv->define("print", std::make_shared<Type>(TypeKind::VOID));
   typeEnv->define("readln", std::make_shared<Type>(TypeKind::STRING));
   typeEnv->define("readLine", std::make_shared<Type>(TypeKind::STRING));
+  typeEnv->define("flush", std::make_shared<Type>(TypeKind::VOID));
   typeEnv->define("sqrt", std::make_shared<Type>(TypeKind::DOUBLE));
   typeEnv->define("abs", std::make_shared<Type>(TypeKind::DOUBLE));
   typeEnv->define("sin", std::make_shared<Type>(TypeKind::DOUBLE));
@@ -333,17 +368,33 @@ void Interpreter::performTypeInference(Program &program) {
 }
 
 void Interpreter::performOptimization(Program &program) {
-  // First perform constant folding
+  if (optimizationLevel == OptimizationLevel::O2) {
+    timePhase(phaseTimes, "constantFolding",
+              [&] { performConstantFolding(program); });
+  }
+  // Every level resolves: locals are only found through their slots
+  timePhase(phaseTimes, "resolution", [&] { performResolution(program); });
+  if (optimizationLevel == OptimizationLevel::O2) {
+    timePhase(phaseTimes, "deadCodeElimination",
+              [&] { performDeadCodeElimination(program); });
+  }
+}
+
+void Interpreter::performConstantFolding(Program &program) {
   ConstantFolderVisitor folder;
   for (auto &stmt : program.statements) {
     stmt = folder.fold(stmt);
   }
+}
 
-  // Perform variable resolution (Resolver)
+// Resolves variables to (distance, slot) pairs; must run after constant
+// folding, which replaces expression nodes
+void Interpreter::performResolution(Program &program) {
   ResolverVisitor resolver(this);
   resolver.resolve(program.statements);
+}
 
-  // Then perform dead code elimination
+void Interpreter::performDeadCodeElimination(Program &program) {
   DeadCodeEliminationVisitor dce;
   for (auto &stmt : program.statements) {
     stmt = dce.eliminate(stmt);
@@ -0,0 +1,155 @@
+#include "dotlin/number_format.h"
+#include "dotlin/string_kernels.h"
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace dotlin {
+
+namespace {
+
+template <typename T> void appendInteger(std::string &out, T value) {
+  char buffer[24];
+  auto [end, ec] = std::to_chars(buffer, buffer + sizeof buffer, value);
+  out.append(buffer, end);
+}
+
+template <typename T> std::optional<T> parseInteger(std::string_view text) {
+  // from_chars rejects a leading '+', which Kotlin allows
+  if (text.size() > 1 && text[0] == '+' && text[1] != '-') {
+    text.remove_prefix(1);
+  }
+  T value{};
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(),
+                                   value);
+  if (ec != std::errc() || end != text.data() + text.size()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+} // namespace
+
+void appendNumber(std::string &out, int value) { appendInteger(out, value); }
+
+void appendNumber(std::string &out, int64_t value) {
+  appendInteger(out, value);
+}
+
+void appendNumber(std::string &out, double value) {
+  if (std::isnan(value)) {
+    out += "NaN";
+    return;
+  }
+  if (std::isinf(value)) {
+    out += value < 0 ? "-Infinity" : "Infinity";
+    return;
+  }
+
+  // Shortest round-trip digits in the form d.ddde[+-]xx
+  char buffer[32];
+  auto [end, ec] = std::to_chars(buffer, buffer + sizeof buffer, value,
+                                 std::chars_format::scientific);
+  std::string_view sci(buffer, static_cast<size_t>(end - buffer));
+  size_t e = sci.find('e');
+  // to_chars does not terminate the buffer, so parse only up to end;
+  // from_chars takes no '+'
+  const char *exponentText = buffer + e + 1;
+  if (*exponentText == '+') {
+    ++exponentText;
+  }
+  int exponent = 0;
+  std::from_chars(exponentText, end, exponent);
+  std::string_view mantissa = sci.substr(0, e);
+  if (mantissa[0] == '-') {
+    out += '-';
+    mantissa.remove_prefix(1);
+  }
+  // The significant digits without the point: at most 17 for a double
+  char digitBuffer[24];
+  digitBuffer[0] = mantissa[0];
+  size_t count = 1;
+  if (mantissa.size() > 2) {
+    mantissa.copy(digitBuffer + 1, mantissa.size() - 2, 2);
+    count += mantissa.size() - 2;
+  }
+  std::string_view digits(digitBuffer, count);
+
+  // Like Java, plain notation for 1e-3 <= |value| < 1e7
+  if (value != 0 && (exponent < -3 || exponent >= 7)) {
+    out += digits[0];
+    out += '.';
+    out.append(count > 1 ? digits.substr(1) : "0");
+    out += 'E';
+    appendInteger(out, exponent);
+  } else if (exponent < 0) {
+    out += "0.";
+    out.append(static_cast<size_t>(-exponent - 1), '0');
+    out.append(digits);
+  } else {
+    auto point = static_cast<size_t>(exponent + 1);
+    if (count <= point) {
+      out.append(digits);
+      out.append(point - count, '0');
+      out += ".0";
+    } else {
+      out.append(digits.substr(0, point));
+      out += '.';
+      out.append(digits.substr(point));
+    }
+  }
+}
+
+std::string formatDouble(double value) {
+  std::string out;
+  appendNumber(out, value);
+  return out;
+}
+
+std::optional<int> parseInt(std::string_view text) {
+  return parseInteger<int>(text);
+}
+
+std::optional<int64_t> parseLong(std::string_view text) {
+  return parseInteger<int64_t>(text);
+}
+
+std::optional<double> parseDouble(std::string_view text) {
+  size_t start = firstNonWhitespace(text);
+  if (start == std::string_view::npos) {
+    return std::nullopt;
+  }
+  text = text.substr(start, lastNonWhitespace(text) - start + 1);
+  if (text.size() > 1 && text[0] == '+' && text[1] != '-') {
+    text.remove_prefix(1);
+  }
+  // from_chars also takes "inf", "infinity" and "nan" in any case; Kotlin
+  // only spells them "Infinity" and "NaN"
+  std::string_view magnitude = text.substr(text[0] == '-' ? 1 : 0);
+  if (!magnitude.empty() && std::strchr("iInN", magnitude[0])) {
+    if (magnitude == "NaN") {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (magnitude == "Infinity") {
+      double infinity = std::numeric_limits<double>::infinity();
+      return text[0] == '-' ? -infinity : infinity;
+    }
+    return std::nullopt;
+  }
+  double value = 0;
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(),
+                                   value);
+  // Out-of-range values round to infinity or zero as in Kotlin
+  if ((ec != std::errc() && ec != std::errc::result_out_of_range) ||
+      end != text.data() + text.size()) {
+    return std::nullopt;
+  }
+  if (ec == std::errc::result_out_of_range) {
+    return std::strtod(std::string(text).c_str(), nullptr);
+  }
+  return value;
+}
+
+} // namespace dotlin
@@ -0,0 +1,76 @@
+#include "dotlin/output.h"
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#define DOTLIN_ISATTY _isatty
+#define DOTLIN_FILENO _fileno
+#else
+#include <unistd.h>
+#define DOTLIN_ISATTY isatty
+#define DOTLIN_FILENO fileno
+#endif
+
+namespace dotlin {
+
+namespace {
+
+constexpr size_t kBufferSize = 64 * 1024;
+
+// Goes through stdio so the output stays ordered with what the host
+// program writes to std::cout
+void writeStdout(std::string_view text) {
+  std::fwrite(text.data(), 1, text.size(), stdout);
+  std::fflush(stdout);
+}
+
+} // namespace
+
+OutputSink::OutputSink()
+    : writeOutput(writeStdout),
+      lineBuffered(DOTLIN_ISATTY(DOTLIN_FILENO(stdout)) != 0) {
+  buffer.reserve(kBufferSize);
+}
+
+OutputSink::~OutputSink() { flush(); }
+
+void OutputSink::write(std::string_view text) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (buffer.size() + text.size() > kBufferSize) {
+    flushLocked();
+  }
+  if (text.size() >= kBufferSize) {
+    writeOutput(text);
+    return;
+  }
+  buffer.append(text);
+  if (lineBuffered && std::memchr(text.data(), '\n', text.size())) {
+    flushLocked();
+  }
+}
+
+void OutputSink::flush() {
+  std::lock_guard<std::mutex> lock(mutex);
+  flushLocked();
+}
+
+void OutputSink::setWriteOutput(WriteOutput hook) {
+  std::lock_guard<std::mutex> lock(mutex);
+  flushLocked();
+  writeOutput = std::move(hook);
+}
+
+void OutputSink::setLineBuffered(bool enabled) {
+  std::lock_guard<std::mutex> lock(mutex);
+  lineBuffered = enabled;
+}
+
+void OutputSink::flushLocked() {
+  if (!buffer.empty()) {
+    writeOutput(buffer);
+    buffer.clear();
+  }
+}
+
+} // namespace dotlin
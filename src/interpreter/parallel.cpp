@@ -0,0 +1,436 @@
+#include "dotlin/parallel.h"
+#include "dotlin/array_functions.h"
+#include "dotlin/lambda_frame.h"
+#include "dotlin/thread_pool.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+namespace dotlin {
+
+namespace {
+
+// Methods that modify their receiver; use { } closes a writer at the end
+bool isMutatingMethod(const std::string &name) {
+  static const std::unordered_set<std::string> names = {
+      "add",       "set",       "remove",  "removeAt", "insert",
+      "clear",     "put",       "getOrPut", "append",  "appendLine",
+      "setLength", "shuffle",   "sort",    "sortDescending",
+      "write",     "writeLine", "flush",   "close",   "use"};
+  return names.count(name) > 0;
+}
+
+// Methods that return a new collection rather than a view of the receiver
+bool isCopyingMethod(const std::string &name) {
+  static const std::unordered_set<std::string> names = {
+      "map",    "filter",        "sorted",       "sortedDescending",
+      "copyOf", "reversed",      "toList",       "toMutableList",
+      "toMutableMap", "toMutableSet", "toString"};
+  return names.count(name) > 0;
+}
+
+} // namespace
+
+// Whether the value of `expr` could be an object that already exists, so that
+// mutating it through a variable would be visible outside the function
+bool SharedStateChecker::mayAlias(const Expression *expr) {
+  if (!expr || dynamic_cast<const LiteralExpr *>(expr) ||
+      dynamic_cast<const ArrayLiteralExpr *>(expr) ||
+      dynamic_cast<const StringInterpolationExpr *>(expr) ||
+      dynamic_cast<const LambdaExpr *>(expr)) {
+    return false;
+  }
+  if (auto *binary = dynamic_cast<const BinaryExpr *>(expr)) {
+    return binary->op == TokenType::ASSIGN || binary->op == TokenType::ELVIS;
+  }
+  if (dynamic_cast<const UnaryExpr *>(expr)) {
+    return false;
+  }
+  if (auto *call = dynamic_cast<const CallExpr *>(expr)) {
+    const Expression *callee = call->callee.get();
+    if (auto *ident = dynamic_cast<const IdentifierExpr *>(callee)) {
+      return !Interpreter::isBuiltinFunction(ident->name) ||
+             Interpreter::functionDefinitions.count(ident->name) > 0;
+    }
+    if (auto *member = dynamic_cast<const MemberAccessExpr *>(callee)) {
+      return !isCopyingMethod(member->property);
+    }
+  }
+  return true;
+}
+
+// Loop variables are never collected, so they are never owned
+void SharedStateChecker::collectDeclarations(
+    const Statement *stmt, std::unordered_set<std::string> &declared,
+    std::unordered_set<std::string> &aliased) {
+  if (!stmt) {
+    return;
+  }
+  if (auto *exprStmt = dynamic_cast<const ExpressionStmt *>(stmt)) {
+    auto *binary = dynamic_cast<const BinaryExpr *>(exprStmt->expression.get());
+    if (binary && binary->op == TokenType::ASSIGN) {
+      auto *target = dynamic_cast<const IdentifierExpr *>(binary->left.get());
+      if (target && mayAlias(binary->right.get())) {
+        aliased.insert(target->name);
+      }
+    }
+  } else if (auto *varDecl = dynamic_cast<const VariableDeclStmt *>(stmt)) {
+    declared.insert(varDecl->name);
+    if (varDecl->initializer && mayAlias(varDecl->initializer->get())) {
+      aliased.insert(varDecl->name);
+    }
+  } else if (auto *block = dynamic_cast<const BlockStmt *>(stmt)) {
+    for (const auto &inner : block->statements) {
+      collectDeclarations(inner.get(), declared, aliased);
+    }
+  } else if (auto *ifStmt = dynamic_cast<const IfStmt *>(stmt)) {
+    collectDeclarations(ifStmt->thenBranch.get(), declared, aliased);
+    if (ifStmt->elseBranch) {
+      collectDeclarations(ifStmt->elseBranch->get(), declared, aliased);
+    }
+  } else if (auto *whileStmt = dynamic_cast<const WhileStmt *>(stmt)) {
+    collectDeclarations(whileStmt->body.get(), declared, aliased);
+  } else if (auto *forStmt = dynamic_cast<const ForStmt *>(stmt)) {
+    collectDeclarations(forStmt->body.get(), declared, aliased);
+  } else if (auto *when = dynamic_cast<const WhenStmt *>(stmt)) {
+    for (const auto &branch : when->branches) {
+      collectDeclarations(branch.second.get(), declared, aliased);
+    }
+    if (when->elseBranch) {
+      collectDeclarations(when->elseBranch->get(), declared, aliased);
+    }
+  } else if (auto *tryStmt = dynamic_cast<const TryStmt *>(stmt)) {
+    collectDeclarations(tryStmt->tryBlock.get(), declared, aliased);
+    collectDeclarations(tryStmt->catchBlock.get(), declared, aliased);
+    if (tryStmt->finallyBlock) {
+      collectDeclarations(tryStmt->finallyBlock->get(), declared, aliased);
+    }
+  }
+}
+
+void SharedStateChecker::check(const LambdaValue &lambda,
+                               const std::string &methodName) {
+  method = methodName;
+  scope = lambda.closure ? lambda.closure : interpreter.globals;
+  checkStatement(lambda.body.get(), Mode::LAMBDA);
+}
+
+void SharedStateChecker::reject(const std::string &what) const {
+  throw std::runtime_error(method + " lambda must not mutate shared state (" +
+                           what + ")");
+}
+
+bool SharedStateChecker::isLocal(const Expression *expr) const {
+  return dynamic_cast<const IdentifierExpr *>(expr) &&
+         interpreter.getResolvedLocation(expr).has_value();
+}
+
+bool SharedStateChecker::isOwned(const Expression *expr) const {
+  auto *ident = dynamic_cast<const IdentifierExpr *>(expr);
+  return ident && !ownedLocals.empty() &&
+         ownedLocals.back().count(ident->name) > 0 && isLocal(ident);
+}
+
+void SharedStateChecker::checkFunctionBody(const FunctionDef &def) {
+  const Statement *body = def.body.get();
+  if (!body || !checkedBodies.insert(body).second) {
+    return;
+  }
+  // Only variables the function declares and fills with a value it created
+  // are its own; parameters may refer to the caller's collections
+  std::unordered_set<std::string> declared;
+  std::unordered_set<std::string> aliased;
+  collectDeclarations(body, declared, aliased);
+  for (const auto &param : def.parameters) {
+    aliased.insert(param.name);
+  }
+  std::unordered_set<std::string> owned;
+  for (const auto &name : declared) {
+    if (aliased.count(name) == 0) {
+      owned.insert(name);
+    }
+  }
+  ownedLocals.push_back(std::move(owned));
+  checkStatement(body, Mode::FUNCTION);
+  ownedLocals.pop_back();
+}
+
+void SharedStateChecker::checkStatement(const Statement *stmt, Mode mode) {
+  if (!stmt) {
+    return;
+  }
+  if (auto *exprStmt = dynamic_cast<const ExpressionStmt *>(stmt)) {
+    checkExpression(exprStmt->expression.get(), mode);
+  } else if (auto *varDecl = dynamic_cast<const VariableDeclStmt *>(stmt)) {
+    if (varDecl->initializer) {
+      checkExpression(varDecl->initializer->get(), mode);
+    }
+  } else if (auto *block = dynamic_cast<const BlockStmt *>(stmt)) {
+    for (const auto &inner : block->statements) {
+      checkStatement(inner.get(), mode);
+    }
+  } else if (auto *ret = dynamic_cast<const ReturnStmt *>(stmt)) {
+    checkExpression(ret->value.get(), mode);
+  } else if (auto *ifStmt = dynamic_cast<const IfStmt *>(stmt)) {
+    checkExpression(ifStmt->condition.get(), mode);
+    checkStatement(ifStmt->thenBranch.get(), mode);
+    if (ifStmt->elseBranch) {
+      checkStatement(ifStmt->elseBranch->get(), mode);
+    }
+  } else if (auto *whileStmt = dynamic_cast<const WhileStmt *>(stmt)) {
+    checkExpression(whileStmt->condition.get(), mode);
+    checkStatement(whileStmt->body.get(), mode);
+  } else if (auto *forStmt = dynamic_cast<const ForStmt *>(stmt)) {
+    checkExpression(forStmt->iterable.get(), mode);
+    checkStatement(forStmt->body.get(), mode);
+  } else if (auto *when = dynamic_cast<const WhenStmt *>(stmt)) {
+    checkExpression(when->subject.get(), mode);
+    for (const auto &branch : when->branches) {
+      checkExpression(branch.first.get(), mode);
+      checkStatement(branch.second.get(), mode);
+    }
+    if (when->elseBranch) {
+      checkStatement(when->elseBranch->get(), mode);
+    }
+  } else if (auto *tryStmt = dynamic_cast<const TryStmt *>(stmt)) {
+    checkStatement(tryStmt->tryBlock.get(), mode);
+    checkStatement(tryStmt->catchBlock.get(), mode);
+    if (tryStmt->finallyBlock) {
+      checkStatement(tryStmt->finallyBlock->get(), mode);
+    }
+  } else if (dynamic_cast<const FunctionDeclStmt *>(stmt) ||
+             dynamic_cast<const ClassDeclStmt *>(stmt) ||
+             dynamic_cast<const ExtensionFunctionDeclStmt *>(stmt)) {
+    reject("declares a function or class");
+  }
+}
+
+void SharedStateChecker::checkExpression(const Expression *expr, Mode mode) {
+  if (!expr) {
+    return;
+  }
+  if (auto *binary = dynamic_cast<const BinaryExpr *>(expr)) {
+    if (binary->op == TokenType::ASSIGN) {
+      checkAssignmentTarget(binary->left.get(), mode);
+    } else {
+      checkExpression(binary->left.get(), mode);
+    }
+    checkExpression(binary->right.get(), mode);
+  } else if (auto *unary = dynamic_cast<const UnaryExpr *>(expr)) {
+    checkExpression(unary->operand.get(), mode);
+  } else if (auto *call = dynamic_cast<const CallExpr *>(expr)) {
+    checkCallee(call->callee.get(), mode);
+    // shuffle(array) is the one built-in function that mutates an argument
+    auto *ident = dynamic_cast<const IdentifierExpr *>(call->callee.get());
+    if (ident && ident->name == "shuffle" &&
+        Interpreter::functionDefinitions.count("shuffle") == 0 &&
+        (mode == Mode::LAMBDA || call->arguments.empty() ||
+         !isOwned(call->arguments[0].get()))) {
+      reject("calls shuffle()");
+    }
+    for (const auto &arg : call->arguments) {
+      checkExpression(arg.get(), mode);
+    }
+  } else if (auto *access = dynamic_cast<const MemberAccessExpr *>(expr)) {
+    checkExpression(access->object.get(), mode);
+  } else if (auto *index = dynamic_cast<const ArrayAccessExpr *>(expr)) {
+    checkExpression(index->array.get(), mode);
+    checkExpression(index->index.get(), mode);
+  } else if (auto *literal = dynamic_cast<const ArrayLiteralExpr *>(expr)) {
+    for (const auto &element : literal->elements) {
+      checkExpression(element.get(), mode);
+    }
+  } else if (auto *interpolation =
+                 dynamic_cast<const StringInterpolationExpr *>(expr)) {
+    for (const auto &part : interpolation->parts) {
+      checkExpression(part.get(), mode);
+    }
+  } else if (auto *lambda = dynamic_cast<const LambdaExpr *>(expr)) {
+    // A lambda created here may run as part of this one
+    checkStatement(lambda->body.get(), Mode::LAMBDA);
+  }
+}
+
+void SharedStateChecker::checkAssignmentTarget(const Expression *target,
+                                               Mode mode) {
+  if (auto *ident = dynamic_cast<const IdentifierExpr *>(target)) {
+    // Inside a named function a resolved identifier is one of its own
+    // variables; anything else is a global or a capture
+    if (mode == Mode::LAMBDA || !isLocal(ident)) {
+      reject("assigns to '" + ident->name + "'");
+    }
+    return;
+  }
+  if (auto *access = dynamic_cast<const ArrayAccessExpr *>(target)) {
+    if (mode == Mode::LAMBDA || !isOwned(access->array.get())) {
+      reject("assigns to an array element");
+    }
+    checkExpression(access->index.get(), mode);
+    return;
+  }
+  if (auto *member = dynamic_cast<const MemberAccessExpr *>(target)) {
+    reject("assigns to field '" + member->property + "'");
+  }
+  reject("assigns to an unsupported target");
+}
+
+void SharedStateChecker::checkCallee(const Expression *callee, Mode mode) {
+  if (auto *ident = dynamic_cast<const IdentifierExpr *>(callee)) {
+    checkNamedCallee(*ident, mode);
+    return;
+  }
+
+  auto *member = dynamic_cast<const MemberAccessExpr *>(callee);
+  if (!member) {
+    checkExpression(callee, mode);
+    return;
+  }
+  checkExpression(member->object.get(), mode);
+  const std::string &name = member->property;
+  if (isMutatingMethod(name)) {
+    if (mode == Mode::LAMBDA || !isOwned(member->object.get())) {
+      reject("calls " + name + "()");
+    }
+    return;
+  }
+
+  // The receiver type is unknown statically, so check every class method and
+  // extension function that could be the target
+  for (const auto &entry : interpreter.globals->values) {
+    auto *classDef =
+        std::get_if<std::shared_ptr<ClassDefinition>>(&entry.second);
+    for (auto cls = classDef ? *classDef : nullptr; cls;
+         cls = cls->superclass) {
+      for (const auto &methodDef : cls->methods) {
+        if (methodDef->name == name) {
+          checkFunctionBody(*methodDef);
+        }
+      }
+    }
+  }
+  std::string suffix = "_" + name;
+  for (const auto &entry : Interpreter::functionDefinitions) {
+    const std::string &key = entry.first;
+    if (key.rfind("ext_", 0) == 0 && key.size() > suffix.size() &&
+        key.compare(key.size() - suffix.size(), suffix.size(), suffix) == 0) {
+      for (const auto &def : entry.second) {
+        checkFunctionBody(*def);
+      }
+    }
+  }
+}
+
+void SharedStateChecker::checkNamedCallee(const IdentifierExpr &callee,
+                                          Mode mode) {
+  const std::string &name = callee.name;
+  auto it = Interpreter::functionDefinitions.find(name);
+  if (it != Interpreter::functionDefinitions.end()) {
+    for (const auto &def : it->second) {
+      checkFunctionBody(*def);
+    }
+    return;
+  }
+
+  // A lambda stored in a variable: a named function sees globals only. Local
+  // variables of enclosing functions live in slots that cannot be found by
+  // name, so calls through them are rejected below.
+  auto &env = mode == Mode::LAMBDA ? scope : interpreter.globals;
+  Value *value = env ? env->lookup(name) : nullptr;
+  if (value) {
+    if (auto *lambda = std::get_if<std::shared_ptr<LambdaValue>>(value)) {
+      if (*lambda && (*lambda)->body) {
+        const Statement *body = (*lambda)->body.get();
+        if (checkedBodies.insert(body).second) {
+          checkStatement(body, Mode::LAMBDA);
+        }
+        return;
+      }
+    } else if (std::holds_alternative<std::shared_ptr<ClassDefinition>>(
+                   *value)) {
+      // Constructing an object only writes to the new object
+      return;
+    }
+  }
+  if (!value && Interpreter::isBuiltinFunction(name)) {
+    return;
+  }
+  reject("calls '" + name + "', which is not a known function");
+}
+
+Value callArrayParallel(Interpreter &interpreter, const ArrayValue &array,
+                        const std::string &method,
+                        const std::vector<Value> &args) {
+  auto lambda = lambdaArg(args, 0, method);
+  SharedStateChecker(interpreter).check(*lambda, method);
+
+  ThreadPool &pool = ThreadPool::instance();
+  size_t n = array.size();
+  size_t chunks = std::min(n, (pool.size() + 1) * 4);
+  size_t arity = method == "parallelReduce" ? 2 : 1;
+  std::string frameName = "lambda@" + method;
+  std::vector<std::vector<Value>> partial(chunks);
+  // Chunk generators derive from one draw of the caller's, so after seed(n)
+  // the results are the same on every run with the same number of chunks
+  uint64_t streamSeed = interpreter.nextRandomSeed();
+
+  pool.parallelFor(chunks, [&](size_t chunk) {
+    size_t begin = chunk * n / chunks;
+    size_t end = (chunk + 1) * n / chunks;
+    auto context = interpreter.fork(Random(streamSeed, chunk));
+    LambdaFrame frame(*context, lambda, arity, frameName);
+    std::vector<Value> &out = partial[chunk];
+
+    if (method == "parallelMap") {
+      out.reserve(end - begin);
+      for (size_t i = begin; i < end; ++i) {
+        out.push_back(frame.call(array.at(i)));
+      }
+    } else if (method == "parallelFilter") {
+      for (size_t i = begin; i < end; ++i) {
+        Value element = array.at(i);
+        if (isTrue(frame.call(element))) {
+          out.push_back(std::move(element));
+        }
+      }
+    } else if (method == "parallelForEach") {
+      for (size_t i = begin; i < end; ++i) {
+        frame.call(array.at(i));
+      }
+    } else if (begin < end) {
+      Value acc = array.at(begin);
+      for (size_t i = begin + 1; i < end; ++i) {
+        acc = frame.call(acc, array.at(i));
+      }
+      out.push_back(std::move(acc));
+    }
+  });
+
+  if (method == "parallelForEach") {
+    return Value();
+  }
+  if (method == "parallelReduce") {
+    if (n == 0) {
+      throw std::runtime_error("Empty array can't be reduced.");
+    }
+    // Combine the chunk results in order; the lambda must be associative
+    LambdaFrame frame(interpreter, lambda, 2, frameName);
+    Value acc = partial[0][0];
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+      acc = frame.call(acc, partial[chunk][0]);
+    }
+    return acc;
+  }
+
+  std::vector<Value> joined;
+  size_t total = 0;
+  for (const auto &part : partial) {
+    total += part.size();
+  }
+  joined.reserve(total);
+  for (auto &part : partial) {
+    std::move(part.begin(), part.end(), std::back_inserter(joined));
+  }
+  return Value(ArrayValue(std::move(joined)));
+}
+
+} // namespace dotlin
@@ -0,0 +1,115 @@
+#include "dotlin/random.h"
+#include "dotlin/interpreter.h"
+#include <random>
+#include <utility>
+
+namespace dotlin {
+
+namespace {
+
+// splitmix64 step, used to expand seeds into generator states
+uint64_t splitMix(uint64_t &value) {
+  value += 0x9e3779b97f4a7c15ULL;
+  uint64_t z = value;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+template <typename T> void shuffleVector(Random &random, std::vector<T> &data) {
+  for (size_t i = data.size(); i > 1; --i) {
+    size_t j = static_cast<size_t>(random.nextBelow(i));
+    if constexpr (std::is_same_v<T, bool>) {
+      bool held = data[i - 1];
+      data[i - 1] = data[j];
+      data[j] = held;
+    } else {
+      std::swap(data[i - 1], data[j]);
+    }
+  }
+}
+
+} // namespace
+
+Random::Random() {
+  std::random_device device;
+  seed((static_cast<uint64_t>(device()) << 32) ^ device());
+}
+
+Random::Random(uint64_t value, uint64_t stream) {
+  seed(value ^ splitMix(stream));
+}
+
+void Random::seed(uint64_t value) {
+  for (uint64_t &word : state) {
+    word = splitMix(value);
+  }
+}
+
+uint64_t Random::nextBelow(uint64_t bound) {
+  if (bound <= UINT32_MAX) {
+    // Lemire's multiply-shift on 32 random bits; only products whose low
+    // half falls under 2^32 mod bound are biased and redrawn
+    uint64_t product = (next() >> 32) * bound;
+    if (static_cast<uint32_t>(product) < bound) {
+      uint64_t threshold = ((uint64_t{1} << 32) - bound) % bound;
+      while (static_cast<uint32_t>(product) < threshold) {
+        product = (next() >> 32) * bound;
+      }
+    }
+    return product >> 32;
+  }
+  // Reject the top partial multiple of bound
+  uint64_t limit = UINT64_MAX - UINT64_MAX % bound;
+  uint64_t value = next();
+  while (value >= limit) {
+    value = next();
+  }
+  return value % bound;
+}
+
+std::vector<int> Random::ints(size_t count, int from, int until) {
+  std::vector<int> out(count);
+  uint64_t bound = static_cast<uint64_t>(static_cast<int64_t>(until) - from);
+  for (int &value : out) {
+    value = static_cast<int>(from + static_cast<int64_t>(nextBelow(bound)));
+  }
+  return out;
+}
+
+std::vector<double> Random::doubles(size_t count) {
+  std::vector<double> out(count);
+  for (double &value : out) {
+    value = nextDouble();
+  }
+  return out;
+}
+
+void shuffleArray(Random &random, ArrayValue &array) {
+  // Shuffle a private copy, then swap it in like an in-place sort
+  ArrayValue shuffled;
+  if (auto ints = array.elements<int>()) {
+    std::vector<int> data(ints->begin(), ints->end());
+    shuffleVector(random, data);
+    shuffled = ArrayValue(std::move(data));
+  } else if (auto doubles = array.elements<double>()) {
+    std::vector<double> data(doubles->begin(), doubles->end());
+    shuffleVector(random, data);
+    shuffled = ArrayValue(std::move(data));
+  } else if (auto longs = array.elements<int64_t>()) {
+    std::vector<int64_t> data(longs->begin(), longs->end());
+    shuffleVector(random, data);
+    shuffled = ArrayValue(std::move(data));
+  } else if (auto *bools = array.bools()) {
+    std::vector<bool> data = *bools;
+    shuffleVector(random, data);
+    shuffled = ArrayValue(std::move(data));
+  } else {
+    std::vector<Value> data = array.toValues();
+    shuffleVector(random, data);
+    shuffled = ArrayValue(std::move(data), array.elementType());
+  }
+  array.assignFrom(shuffled);
+}
+
+} // namespace dotlin
@@ -1,3 +1,4 @@
+#include "dotlin/trace.h"
 #include "dotlin/visitors.h"
 // #include <iostream>
 
@@ -57,10 +58,14 @@ void ResolverVisitor::resolveLocal(Expression &expr, const std::string &name) {
     if (it != scopes[static_cast<size_t>(i)].end()) {
       int distance = static_cast<int>(scopes.size()) - 1 - i;
       int index = it->second.index;
+      DOTLIN_TRACE(Resolve, Debug, "'", name, "' at ", expr.line, ":",
+                   expr.column, " -> distance ", distance, ", slot ", index);
       interpreter->resolve(&expr, distance, index);
       return;
     }
   }
+  DOTLIN_TRACE(Resolve, Debug, "'", name, "' at ", expr.line, ":",
+               expr.column, " -> global");
 }
 
 void ResolverVisitor::visit(BlockStmt &node) {
@@ -85,6 +90,9 @@ void ResolverVisitor::visit(VariableDeclStmt &node) {
 void ResolverVisitor::visit(FunctionDeclStmt &node) {
   declare(node.name);
   define(node.name);
+  if (!scopes.empty()) {
+    node.index = scopes.back()[node.name].index;
+  }
 
   FunctionType enclosingFunction = currentFunction;
   currentFunction = FunctionType::FUNCTION;
@@ -213,6 +221,11 @@ void ResolverVisitor::visit(LambdaExpr &node) {
     declare(param.name);
     define(param.name);
   }
+  // A lambda without declared parameters gets its argument as `it`
+  if (node.parameters.empty()) {
+    declare("it");
+    define("it");
+  }
   resolve(node.body); // Body is Statement::Ptr (usually BlockStmt or
                       // ExpressionStmt? No, Body is Statement::Ptr)
   endScope();
@@ -0,0 +1,275 @@
+#include "dotlin/sequence.h"
+#include "dotlin/array_functions.h"
+#include "dotlin/file_io.h"
+#include "dotlin/lambda_frame.h"
+#include <stdexcept>
+
+namespace dotlin {
+
+namespace {
+
+bool isNull(const Value &value) {
+  auto *str = std::get_if<std::string>(&value);
+  return str && *str == "null";
+}
+
+// State of one pass over a sequence: a reusable frame per lambda stage and
+// the counters of take/drop
+class SequenceRun {
+public:
+  SequenceRun(Interpreter &interp, const SequenceValue &seq)
+      : interpreter(interp), sequence(seq), counters(seq.stages.size(), 0) {
+    frames.reserve(seq.stages.size());
+    for (const auto &stage : seq.stages) {
+      if (stage.fn) {
+        frames.push_back(std::make_unique<LambdaFrame>(
+            interpreter, stage.fn, 1, "lambda@" + stageName(stage.kind)));
+      } else {
+        frames.push_back(nullptr);
+      }
+    }
+  }
+
+  void run(const std::function<bool(const Value &)> &out) {
+    sink = &out;
+    if (sequence.array) {
+      const ArrayValue &array = *sequence.array;
+      for (size_t i = 0; i < array.size(); ++i) {
+        if (!push(0, array.at(i))) {
+          return;
+        }
+      }
+    } else if (sequence.generator) {
+      LambdaFrame next(interpreter, sequence.generator, 1,
+                       "lambda@generateSequence");
+      Value current = sequence.seed;
+      while (!isNull(current) && push(0, current)) {
+        current = next.call(current);
+      }
+    } else if (!sequence.linesPath.empty()) {
+      forEachFileLine(sequence.linesPath, [this](const std::string &line) {
+        return push(0, Value(line));
+      });
+    }
+  }
+
+private:
+  Interpreter &interpreter;
+  const SequenceValue &sequence;
+  std::vector<std::unique_ptr<LambdaFrame>> frames;
+  std::vector<size_t> counters;
+  const std::function<bool(const Value &)> *sink = nullptr;
+
+  static std::string stageName(SequenceStage::Kind kind) {
+    switch (kind) {
+    case SequenceStage::Kind::MAP:
+      return "map";
+    case SequenceStage::Kind::FILTER:
+      return "filter";
+    case SequenceStage::Kind::TAKE_WHILE:
+      return "takeWhile";
+    case SequenceStage::Kind::FLAT_MAP:
+      return "flatMap";
+    default:
+      return "sequence";
+    }
+  }
+
+  // Feed one element into stage `index`; false stops the whole pass
+  bool push(size_t index, const Value &value) {
+    if (index == sequence.stages.size()) {
+      return (*sink)(value);
+    }
+    const SequenceStage &stage = sequence.stages[index];
+    switch (stage.kind) {
+    case SequenceStage::Kind::MAP:
+      return push(index + 1, frames[index]->call(value));
+    case SequenceStage::Kind::FILTER:
+      if (isTrue(frames[index]->call(value))) {
+        return push(index + 1, value);
+      }
+      return true;
+    case SequenceStage::Kind::TAKE: {
+      if (counters[index] >= stage.count) {
+        return false;
+      }
+      ++counters[index];
+      bool more = push(index + 1, value);
+      return more && counters[index] < stage.count;
+    }
+    case SequenceStage::Kind::DROP:
+      if (counters[index] < stage.count) {
+        ++counters[index];
+        return true;
+      }
+      return push(index + 1, value);
+    case SequenceStage::Kind::TAKE_WHILE:
+      if (!isTrue(frames[index]->call(value))) {
+        return false;
+      }
+      return push(index + 1, value);
+    case SequenceStage::Kind::FLAT_MAP: {
+      Value inner = frames[index]->call(value);
+      if (auto *array = std::get_if<ArrayValue>(&inner)) {
+        for (size_t i = 0; i < array->size(); ++i) {
+          if (!push(index + 1, array->at(i))) {
+            return false;
+          }
+        }
+        return true;
+      }
+      if (auto *seq = std::get_if<std::shared_ptr<SequenceValue>>(&inner)) {
+        bool more = true;
+        iterateSequence(interpreter, **seq, [&](const Value &element) {
+          more = push(index + 1, element);
+          return more;
+        });
+        return more;
+      }
+      throw std::runtime_error(
+          "flatMap expects the lambda to return an array or a sequence");
+    }
+    }
+    return true;
+  }
+};
+
+size_t countArg(const std::vector<Value> &args, const std::string &method) {
+  if (args.size() != 1 || !std::holds_alternative<int>(args[0])) {
+    throw std::runtime_error(method + " expects an Int count");
+  }
+  int count = std::get<int>(args[0]);
+  if (count < 0) {
+    throw std::runtime_error("Requested element count " +
+                             std::to_string(count) + " is less than zero.");
+  }
+  return static_cast<size_t>(count);
+}
+
+} // namespace
+
+std::shared_ptr<SequenceValue> sequenceOf(const ArrayValue &array) {
+  auto seq = std::make_shared<SequenceValue>();
+  seq->array = std::make_shared<ArrayValue>(array);
+  return seq;
+}
+
+std::shared_ptr<SequenceValue>
+generateSequence(const Value &seed, std::shared_ptr<LambdaValue> next) {
+  auto seq = std::make_shared<SequenceValue>();
+  seq->seed = seed;
+  seq->generator = std::move(next);
+  return seq;
+}
+
+std::shared_ptr<SequenceValue> fileLines(const std::string &path) {
+  auto seq = std::make_shared<SequenceValue>();
+  seq->linesPath = path;
+  return seq;
+}
+
+void iterateSequence(Interpreter &interpreter, const SequenceValue &sequence,
+                     const std::function<bool(const Value &)> &sink) {
+  SequenceRun(interpreter, sequence).run(sink);
+}
+
+Value callSequenceMethod(Interpreter &interpreter,
+                         const std::shared_ptr<SequenceValue> &sequence,
+                         const std::string &method,
+                         const std::vector<Value> &args) {
+  // Intermediate operations: copy the pipeline and add a stage
+  auto extend = [&](SequenceStage stage) {
+    auto next = std::make_shared<SequenceValue>(*sequence);
+    next->stages.push_back(std::move(stage));
+    return Value(next);
+  };
+  using Kind = SequenceStage::Kind;
+  if (method == "map") {
+    return extend({Kind::MAP, lambdaArg(args, 0, method), 0});
+  }
+  if (method == "filter") {
+    return extend({Kind::FILTER, lambdaArg(args, 0, method), 0});
+  }
+  if (method == "takeWhile") {
+    return extend({Kind::TAKE_WHILE, lambdaArg(args, 0, method), 0});
+  }
+  if (method == "flatMap") {
+    return extend({Kind::FLAT_MAP, lambdaArg(args, 0, method), 0});
+  }
+  if (method == "take") {
+    return extend({Kind::TAKE, nullptr, countArg(args, method)});
+  }
+  if (method == "drop") {
+    return extend({Kind::DROP, nullptr, countArg(args, method)});
+  }
+  if (method == "asSequence" && args.empty()) {
+    return Value(sequence);
+  }
+
+  // Terminal operations
+  if (method == "toList" && args.empty()) {
+    ArrayValue out;
+    iterateSequence(interpreter, *sequence, [&](const Value &element) {
+      out.push_back(element);
+      return true;
+    });
+    return Value(std::move(out));
+  }
+  if (method == "sum" && args.empty()) {
+    Value total(0);
+    iterateSequence(interpreter, *sequence, [&](const Value &element) {
+      total = addNumbers(total, element);
+      return true;
+    });
+    return total;
+  }
+  if (method == "count" && args.empty()) {
+    int count = 0;
+    iterateSequence(interpreter, *sequence, [&](const Value &) {
+      ++count;
+      return true;
+    });
+    return Value(count);
+  }
+  if (method == "forEach") {
+    LambdaFrame frame(interpreter, lambdaArg(args, 0, method), 1,
+                      "lambda@forEach");
+    iterateSequence(interpreter, *sequence, [&](const Value &element) {
+      frame.call(element);
+      return true;
+    });
+    return Value();
+  }
+  if (method == "first" || method == "firstOrNull") {
+    std::unique_ptr<LambdaFrame> predicate;
+    if (!args.empty()) {
+      predicate = std::make_unique<LambdaFrame>(
+          interpreter, lambdaArg(args, 0, method), 1, "lambda@" + method);
+    }
+    bool found = false;
+    Value first;
+    iterateSequence(interpreter, *sequence, [&](const Value &element) {
+      if (predicate && !isTrue(predicate->call(element))) {
+        return true;
+      }
+      found = true;
+      first = element;
+      return false;
+    });
+    if (found) {
+      return first;
+    }
+    if (method == "firstOrNull") {
+      return Value(std::string("null"));
+    }
+    throw std::runtime_error(predicate
+                                 ? "Sequence contains no element matching "
+                                   "the predicate."
+                                 : "Sequence is empty.");
+  }
+
+  throw std::runtime_error("Cannot call method '" + method +
+                           "' on a sequence");
+}
+
+} // namespace dotlin
@@ -0,0 +1,571 @@
+#include "dotlin/serialize.h"
+#include "dotlin/collections.h"
+#include "dotlin/file_io.h"
+#include "dotlin/string_builder.h"
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace dotlin {
+
+namespace {
+
+constexpr unsigned kMaxDepth = 512;
+constexpr size_t kSpillSize = size_t{1} << 18;
+
+// Extension type codes
+constexpr uint8_t kIntArray = 1;
+constexpr uint8_t kDoubleArray = 2;
+constexpr uint8_t kBoolArray = 3;
+constexpr uint8_t kSet = 4;
+constexpr uint8_t kMutableMap = 5;
+constexpr uint8_t kInstance = 6;
+constexpr uint8_t kStringBuilder = 7;
+constexpr uint8_t kFile = 8;
+constexpr uint8_t kLongArray = 9;
+
+constexpr bool kLittleEndian = std::endian::native == std::endian::little;
+
+template <typename T> T byteSwap(T value) {
+  unsigned char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  for (size_t i = 0; i < sizeof(T) / 2; ++i) {
+    std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+  }
+  std::memcpy(&value, bytes, sizeof(T));
+  return value;
+}
+
+class Encoder {
+public:
+  // With a writer, output is handed over every kSpillSize bytes
+  explicit Encoder(FileWriterValue *sink = nullptr) : file(sink) {}
+
+  std::string &bytes() { return out; }
+
+  void finish() {
+    if (file) {
+      file->write(out);
+      out.clear();
+    }
+  }
+
+  void encode(const Value &value, unsigned depth) {
+    if (depth >= kMaxDepth) {
+      throw std::runtime_error("serialize(): values are nested too deeply "
+                               "(or contain themselves)");
+    }
+    if (file && out.size() >= kSpillSize) {
+      finish();
+    }
+    if (auto *i = std::get_if<int>(&value)) {
+      integer(*i);
+    } else if (auto *l = std::get_if<int64_t>(&value)) {
+      byte(0xd3);
+      big(static_cast<uint64_t>(*l));
+    } else if (auto *d = std::get_if<double>(&value)) {
+      byte(0xcb);
+      big(std::bit_cast<uint64_t>(*d));
+    } else if (auto *b = std::get_if<bool>(&value)) {
+      byte(*b ? 0xc3 : 0xc2);
+    } else if (auto *s = std::get_if<std::string>(&value)) {
+      if (*s == "null") {
+        byte(0xc0);
+      } else {
+        string(*s);
+      }
+    } else if (auto *array = std::get_if<ArrayValue>(&value)) {
+      encodeArray(*array, depth);
+    } else if (auto *map = std::get_if<std::shared_ptr<MapValue>>(&value)) {
+      if ((*map)->isMutable) {
+        extHeader(1, kMutableMap);
+        byte(0);
+      }
+      const ValueTable &table = (*map)->table;
+      count(table.size(), 0x80, 0xde);
+      for (size_t entry = 0; entry < table.entryCount(); ++entry) {
+        if (table.isLive(entry)) {
+          encode(table.keyAt(entry), depth + 1);
+          encode(table.valueAt(entry), depth + 1);
+        }
+      }
+    } else if (auto *set = std::get_if<std::shared_ptr<SetValue>>(&value)) {
+      extHeader(1, kSet);
+      byte((*set)->isMutable ? 1 : 0);
+      const ValueTable &table = (*set)->table;
+      count(table.size(), 0x90, 0xdc);
+      for (size_t entry = 0; entry < table.entryCount(); ++entry) {
+        if (table.isLive(entry)) {
+          encode(table.keyAt(entry), depth + 1);
+        }
+      }
+    } else if (auto *instance =
+                   std::get_if<std::shared_ptr<ClassInstance>>(&value)) {
+      const std::string &name = (*instance)->className;
+      extHeader(name.size(), kInstance);
+      out += name;
+      count((*instance)->fields.size(), 0x80, 0xde);
+      for (const auto &[field, fieldValue] : (*instance)->fields) {
+        string(field);
+        encode(fieldValue, depth + 1);
+      }
+    } else if (auto *builder =
+                   std::get_if<std::shared_ptr<StringBuilderValue>>(&value)) {
+      extHeader((*builder)->buffer.size(), kStringBuilder);
+      raw((*builder)->buffer);
+    } else if (auto *fileValue =
+                   std::get_if<std::shared_ptr<FileValue>>(&value)) {
+      extHeader((*fileValue)->path.size(), kFile);
+      out += (*fileValue)->path;
+    } else {
+      throw std::runtime_error("serialize() cannot encode a " +
+                               getTypeOfValue(value));
+    }
+  }
+
+private:
+  std::string out;
+  FileWriterValue *file;
+
+  void byte(unsigned value) { out += static_cast<char>(value); }
+
+  // MessagePack numbers are big-endian
+  template <typename T> void big(T value) {
+    if constexpr (kLittleEndian) {
+      value = byteSwap(value);
+    }
+    out.append(reinterpret_cast<const char *>(&value), sizeof value);
+  }
+
+  // Large payloads skip the staging buffer when writing to a file
+  void raw(std::string_view bytes) {
+    if (file && bytes.size() >= kSpillSize) {
+      finish();
+      file->write(bytes);
+    } else {
+      out.append(bytes);
+    }
+  }
+
+  // The smallest form that holds an Int
+  void integer(int value) {
+    if (value >= -32 && value <= 127) {
+      byte(static_cast<unsigned>(value) & 0xff);
+    } else if (value >= -128 && value <= 127) {
+      byte(0xd0);
+      big(static_cast<int8_t>(value));
+    } else if (value >= -32768 && value <= 32767) {
+      byte(0xd1);
+      big(static_cast<int16_t>(value));
+    } else {
+      byte(0xd2);
+      big(static_cast<int32_t>(value));
+    }
+  }
+
+  // Header of a map (fix 0x80, 16-bit 0xde) or array (0x90, 0xdc); the
+  // 32-bit form follows the 16-bit one
+  void count(size_t n, unsigned fix, unsigned wide) {
+    if (n < 16) {
+      byte(fix | static_cast<unsigned>(n));
+    } else if (n <= 0xffff) {
+      byte(wide);
+      big(static_cast<uint16_t>(n));
+    } else {
+      byte(wide + 1);
+      big(checked32(n));
+    }
+  }
+
+  void string(std::string_view text) {
+    size_t n = text.size();
+    if (n < 32) {
+      byte(0xa0 | static_cast<unsigned>(n));
+    } else if (n <= 0xff) {
+      byte(0xd9);
+      big(static_cast<uint8_t>(n));
+    } else if (n <= 0xffff) {
+      byte(0xda);
+      big(static_cast<uint16_t>(n));
+    } else {
+      byte(0xdb);
+      big(checked32(n));
+    }
+    raw(text);
+  }
+
+  void extHeader(size_t n, uint8_t type) {
+    switch (n) {
+    case 1:
+      byte(0xd4);
+      break;
+    case 2:
+      byte(0xd5);
+      break;
+    case 4:
+      byte(0xd6);
+      break;
+    case 8:
+      byte(0xd7);
+      break;
+    case 16:
+      byte(0xd8);
+      break;
+    default:
+      if (n <= 0xff) {
+        byte(0xc7);
+        big(static_cast<uint8_t>(n));
+      } else if (n <= 0xffff) {
+        byte(0xc8);
+        big(static_cast<uint16_t>(n));
+      } else {
+        byte(0xc9);
+        big(checked32(n));
+      }
+    }
+    byte(type);
+  }
+
+  static uint32_t checked32(size_t n) {
+    if (n > std::numeric_limits<uint32_t>::max()) {
+      throw std::runtime_error("serialize(): a value is larger than 4 GiB");
+    }
+    return static_cast<uint32_t>(n);
+  }
+
+  template <typename T>
+  void rawElements(std::span<const T> elements, uint8_t type) {
+    extHeader(elements.size() * sizeof(T), type);
+    if constexpr (kLittleEndian) {
+      raw(std::string_view(reinterpret_cast<const char *>(elements.data()),
+                           elements.size() * sizeof(T)));
+    } else {
+      for (T element : elements) {
+        T swapped = byteSwap(element);
+        out.append(reinterpret_cast<const char *>(&swapped), sizeof swapped);
+      }
+    }
+  }
+
+  void encodeArray(const ArrayValue &array, unsigned depth) {
+    if (auto ints = array.elements<int>()) {
+      rawElements(*ints, kIntArray);
+    } else if (auto doubles = array.elements<double>()) {
+      rawElements(*doubles, kDoubleArray);
+    } else if (auto longs = array.elements<int64_t>()) {
+      rawElements(*longs, kLongArray);
+    } else if (auto *bools = array.bools()) {
+      extHeader(bools->size(), kBoolArray);
+      for (bool element : *bools) {
+        byte(element ? 1 : 0);
+      }
+    } else {
+      const std::vector<Value> &values = *array.values();
+      count(values.size(), 0x90, 0xdc);
+      for (const Value &element : values) {
+        encode(element, depth + 1);
+      }
+    }
+  }
+};
+
+class Decoder {
+public:
+  Decoder(std::string_view bytes, const ClassLookup &lookup)
+      : in(bytes), lookupClass(lookup) {}
+
+  Value decodeAll() {
+    Value value = decode(0);
+    if (pos != in.size()) {
+      fail("unexpected bytes after the value");
+    }
+    return value;
+  }
+
+private:
+  std::string_view in;
+  const ClassLookup &lookupClass;
+  size_t pos = 0;
+  std::unordered_map<std::string, std::shared_ptr<ClassDefinition>> classes;
+
+  [[noreturn]] void fail(const std::string &what) const {
+    throw std::runtime_error("deserialize(): " + what + " at byte " +
+                             std::to_string(pos));
+  }
+
+  std::string_view take(size_t n) {
+    if (n > in.size() - pos) {
+      fail("truncated input");
+    }
+    std::string_view bytes = in.substr(pos, n);
+    pos += n;
+    return bytes;
+  }
+
+  template <typename T> T big() {
+    T value;
+    std::memcpy(&value, take(sizeof(T)).data(), sizeof(T));
+    if constexpr (kLittleEndian) {
+      value = byteSwap(value);
+    }
+    return value;
+  }
+
+  uint8_t byte() { return big<uint8_t>(); }
+
+  Value decode(unsigned depth) {
+    if (depth >= kMaxDepth) {
+      fail("values nested too deeply");
+    }
+    uint8_t tag = byte();
+    if (tag <= 0x7f) {
+      return Value(static_cast<int>(tag));
+    }
+    if (tag >= 0xe0) {
+      return Value(static_cast<int>(static_cast<int8_t>(tag)));
+    }
+    if (tag <= 0x8f) {
+      return decodeMap(tag & 0x0fu, depth);
+    }
+    if (tag <= 0x9f) {
+      return decodeArray(tag & 0x0fu, depth);
+    }
+    if (tag <= 0xbf) {
+      return Value(std::string(take(tag & 0x1fu)));
+    }
+    switch (tag) {
+    case 0xc0:
+      return Value(std::string("null"));
+    case 0xc2:
+      return Value(false);
+    case 0xc3:
+      return Value(true);
+    case 0xc4: // bin 8, 16, 32 read as strings
+    case 0xd9:
+      return Value(std::string(take(big<uint8_t>())));
+    case 0xc5:
+    case 0xda:
+      return Value(std::string(take(big<uint16_t>())));
+    case 0xc6:
+    case 0xdb:
+      return Value(std::string(take(big<uint32_t>())));
+    case 0xc7:
+      return decodeExt(big<uint8_t>(), depth);
+    case 0xc8:
+      return decodeExt(big<uint16_t>(), depth);
+    case 0xc9:
+      return decodeExt(big<uint32_t>(), depth);
+    case 0xca:
+      return Value(static_cast<double>(std::bit_cast<float>(big<uint32_t>())));
+    case 0xcb:
+      return Value(std::bit_cast<double>(big<uint64_t>()));
+    case 0xcc:
+      return Value(static_cast<int>(big<uint8_t>()));
+    case 0xcd:
+      return Value(static_cast<int>(big<uint16_t>()));
+    case 0xce: {
+      uint32_t value = big<uint32_t>();
+      if (value <= static_cast<uint32_t>(std::numeric_limits<int>::max())) {
+        return Value(static_cast<int>(value));
+      }
+      return Value(static_cast<int64_t>(value));
+    }
+    case 0xcf: {
+      uint64_t value = big<uint64_t>();
+      if (value > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        fail("integer too large for a Long");
+      }
+      return Value(static_cast<int64_t>(value));
+    }
+    case 0xd0:
+      return Value(static_cast<int>(big<int8_t>()));
+    case 0xd1:
+      return Value(static_cast<int>(big<int16_t>()));
+    case 0xd2:
+      return Value(static_cast<int>(big<int32_t>()));
+    case 0xd3:
+      return Value(big<int64_t>());
+    case 0xd4:
+      return decodeExt(1, depth);
+    case 0xd5:
+      return decodeExt(2, depth);
+    case 0xd6:
+      return decodeExt(4, depth);
+    case 0xd7:
+      return decodeExt(8, depth);
+    case 0xd8:
+      return decodeExt(16, depth);
+    case 0xdc:
+      return decodeArray(big<uint16_t>(), depth);
+    case 0xdd:
+      return decodeArray(big<uint32_t>(), depth);
+    case 0xde:
+      return decodeMap(big<uint16_t>(), depth);
+    case 0xdf:
+      return decodeMap(big<uint32_t>(), depth);
+    default:
+      --pos;
+      fail("invalid type byte");
+    }
+  }
+
+  // Every element takes at least one byte, which bounds a corrupt count
+  void checkCount(size_t n) {
+    if (n > in.size() - pos) {
+      fail("truncated input");
+    }
+  }
+
+  Value decodeArray(size_t n, unsigned depth) {
+    checkCount(n);
+    std::vector<Value> elements;
+    elements.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+      elements.push_back(decode(depth + 1));
+    }
+    return Value(ArrayValue(std::move(elements)));
+  }
+
+  Value decodeMap(size_t n, unsigned depth) {
+    checkCount(n);
+    auto map = std::make_shared<MapValue>();
+    map->table.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+      size_t entry = map->table.insert(decode(depth + 1)).first;
+      map->table.valueAt(entry) = decode(depth + 1);
+    }
+    return Value(map);
+  }
+
+  template <typename T> std::vector<T> rawElements(std::string_view payload) {
+    if (payload.size() % sizeof(T) != 0) {
+      fail("array payload is not a whole number of elements");
+    }
+    std::vector<T> elements(payload.size() / sizeof(T));
+    std::memcpy(elements.data(), payload.data(), payload.size());
+    if constexpr (!kLittleEndian) {
+      for (T &element : elements) {
+        element = byteSwap(element);
+      }
+    }
+    return elements;
+  }
+
+  // The map a mutable-map or instance prefix applies to
+  std::shared_ptr<MapValue> nextMap(unsigned depth, const char *expected) {
+    Value value = decode(depth + 1);
+    if (auto *map = std::get_if<std::shared_ptr<MapValue>>(&value)) {
+      return *map;
+    }
+    fail(std::string("expected ") + expected);
+  }
+
+  Value decodeExt(size_t n, unsigned depth) {
+    uint8_t type = byte();
+    std::string_view payload = take(n);
+    switch (type) {
+    case kIntArray:
+      return Value(ArrayValue(rawElements<int>(payload)));
+    case kDoubleArray:
+      return Value(ArrayValue(rawElements<double>(payload)));
+    case kLongArray:
+      return Value(ArrayValue(rawElements<int64_t>(payload)));
+    case kBoolArray: {
+      std::vector<bool> elements(payload.size());
+      for (size_t i = 0; i < payload.size(); ++i) {
+        elements[i] = payload[i] != 0;
+      }
+      return Value(ArrayValue(std::move(elements)));
+    }
+    case kSet: {
+      Value elements = decode(depth + 1);
+      auto *array = std::get_if<ArrayValue>(&elements);
+      if (payload.size() != 1 || !array) {
+        fail("expected the elements of a set");
+      }
+      auto set = std::make_shared<SetValue>();
+      set->isMutable = payload[0] != 0;
+      set->table.reserve(array->size());
+      for (size_t i = 0; i < array->size(); ++i) {
+        set->table.insert(array->at(i));
+      }
+      return Value(set);
+    }
+    case kMutableMap: {
+      auto map = nextMap(depth, "a map");
+      map->isMutable = true;
+      return Value(map);
+    }
+    case kInstance: {
+      std::string name(payload);
+      auto instance = std::make_shared<ClassInstance>(name, findClass(name));
+      auto fields = nextMap(depth, "the fields of an instance");
+      const ValueTable &table = fields->table;
+      for (size_t i = 0; i < table.entryCount(); ++i) {
+        auto *field = std::get_if<std::string>(&table.keyAt(i));
+        if (!field) {
+          fail("expected a field name");
+        }
+        instance->fields[*field] = table.valueAt(i);
+      }
+      return Value(instance);
+    }
+    case kStringBuilder: {
+      auto builder = std::make_shared<StringBuilderValue>();
+      builder->buffer.assign(payload);
+      return Value(builder);
+    }
+    case kFile:
+      return Value(std::make_shared<FileValue>(FileValue{std::string(payload)}));
+    default:
+      fail("unknown extension type " + std::to_string(type));
+    }
+  }
+
+  std::shared_ptr<ClassDefinition> findClass(const std::string &name) {
+    auto cached = classes.find(name);
+    if (cached != classes.end()) {
+      return cached->second;
+    }
+    auto definition = lookupClass(name);
+    if (!definition) {
+      fail("no class named " + name + " is in scope");
+    }
+    classes.emplace(name, definition);
+    return definition;
+  }
+};
+
+} // namespace
+
+std::string serializeValue(const Value &value) {
+  Encoder encoder;
+  encoder.encode(value, 0);
+  return std::move(encoder.bytes());
+}
+
+void serializeValueToFile(const Value &value, const std::string &path) {
+  FileWriterValue file(path, false);
+  Encoder encoder(&file);
+  encoder.encode(value, 0);
+  encoder.finish();
+  file.close();
+}
+
+Value deserializeValue(std::string_view bytes, const ClassLookup &findClass) {
+  return Decoder(bytes, findClass).decodeAll();
+}
+
+Value deserializeFile(const std::string &path, const ClassLookup &findClass) {
+  ReadDescriptor file(path);
+  MappedFile mapping(file.get());
+  if (mapping.mapped()) {
+    return deserializeValue(mapping.view(), findClass);
+  }
+  return deserializeValue(readFileContents(path), findClass);
+}
+
+} // namespace dotlin
@@ -0,0 +1,58 @@
+#include "dotlin/string_builder.h"
+#include <stdexcept>
+
+namespace dotlin {
+
+Value callStringBuilderMethod(
+    const std::shared_ptr<StringBuilderValue> &builder,
+    const std::string &method, const std::vector<Value> &args) {
+  std::string &buffer = builder->buffer;
+
+  if (method == "append") {
+    if (args.size() != 1) {
+      throw std::runtime_error("append expects 1 argument");
+    }
+    appendValueString(buffer, args[0]);
+    return Value(builder);
+  }
+  if (method == "appendLine") {
+    if (args.size() > 1) {
+      throw std::runtime_error("appendLine expects at most 1 argument");
+    }
+    if (!args.empty()) {
+      appendValueString(buffer, args[0]);
+    }
+    buffer += '\n';
+    return Value(builder);
+  }
+  if (method == "setLength") {
+    auto *length = args.size() == 1 ? std::get_if<int>(&args[0]) : nullptr;
+    if (!length) {
+      throw std::runtime_error("setLength expects an Int length");
+    }
+    if (*length < 0) {
+      throw std::runtime_error("Negative length: " + std::to_string(*length));
+    }
+    // Like Kotlin, growing pads with '\0'
+    buffer.resize(static_cast<size_t>(*length), '\0');
+    return Value();
+  }
+  if (method == "toString" && args.empty()) {
+    return Value(buffer);
+  }
+  if (method == "length" && args.empty()) {
+    return Value(static_cast<int>(buffer.size()));
+  }
+  if (method == "isEmpty" && args.empty()) {
+    return Value(buffer.empty());
+  }
+  if (method == "clear" && args.empty()) {
+    buffer.clear();
+    return Value(builder);
+  }
+
+  throw std::runtime_error("Cannot call method '" + method +
+                           "' on a StringBuilder");
+}
+
+} // namespace dotlin
@@ -0,0 +1,64 @@
+#include "dotlin/string_functions.h"
+#include "dotlin/string_kernels.h"
+
+namespace dotlin {
+
+std::string_view trimView(std::string_view text) {
+  size_t start = firstNonWhitespace(text);
+  if (start == std::string_view::npos) {
+    return text.substr(text.size());
+  }
+  size_t end = lastNonWhitespace(text);
+  return text.substr(start, end - start + 1);
+}
+
+std::vector<std::string_view> splitView(std::string_view text,
+                                        std::string_view delimiter) {
+  std::vector<std::string_view> pieces;
+  if (delimiter.empty()) {
+    pieces.reserve(text.size() + 2);
+    pieces.push_back(text.substr(0, 0));
+    for (size_t i = 0; i < text.size(); ++i) {
+      pieces.push_back(text.substr(i, 1));
+    }
+    pieces.push_back(text.substr(text.size()));
+    return pieces;
+  }
+  // One sweep finds every delimiter, so no byte is scanned twice
+  std::vector<size_t> positions;
+  findAllSubstrings(text, delimiter, positions);
+  pieces.reserve(positions.size() + 1);
+  size_t start = 0;
+  for (size_t pos : positions) {
+    pieces.push_back(text.substr(start, pos - start));
+    start = pos + delimiter.size();
+  }
+  pieces.push_back(text.substr(start));
+  return pieces;
+}
+
+std::vector<std::string_view> linesView(std::string_view text) {
+  std::vector<std::string_view> lines;
+  size_t start = 0;
+  for (size_t pos = text.find_first_of("\r\n"); pos != std::string_view::npos;
+       pos = text.find_first_of("\r\n", start)) {
+    lines.push_back(text.substr(start, pos - start));
+    start = pos + 1;
+    if (text[pos] == '\r' && start < text.size() && text[start] == '\n') {
+      ++start;
+    }
+  }
+  lines.push_back(text.substr(start));
+  return lines;
+}
+
+ArrayValue toStringArray(const std::vector<std::string_view> &pieces) {
+  std::vector<Value> values;
+  values.reserve(pieces.size());
+  for (std::string_view piece : pieces) {
+    values.emplace_back(std::string(piece));
+  }
+  return ArrayValue(std::move(values));
+}
+
+} // namespace dotlin
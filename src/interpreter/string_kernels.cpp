@@ -0,0 +1,468 @@
+#include "dotlin/string_kernels.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DOTLIN_HAVE_SSE2 1
+#endif
+
+// The AVX2 kernels are compiled with a per-function target attribute and
+// only called after a runtime CPU check, so the build needs no -mavx2
+#if defined(DOTLIN_HAVE_SSE2) && defined(__x86_64__) &&                     \
+    (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define DOTLIN_HAVE_AVX2 1
+#define DOTLIN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace dotlin {
+
+namespace {
+
+constexpr size_t npos = std::string_view::npos;
+
+bool isSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+// ---- Scalar ----
+// Also used for the tails the vector loops leave over
+
+// Flips bit 5 of the bytes in [Lo, Hi], which maps a-z to A-Z and back
+template <char Lo, char Hi>
+void flipCaseScalar(const char *in, char *out, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    char c = in[i];
+    out[i] = (c >= Lo && c <= Hi) ? static_cast<char>(c ^ 0x20) : c;
+  }
+}
+
+size_t firstNonWhitespaceScalar(std::string_view text, size_t from = 0) {
+  for (size_t i = from; i < text.size(); ++i) {
+    if (!isSpace(text[i])) {
+      return i;
+    }
+  }
+  return npos;
+}
+
+size_t lastNonWhitespaceScalar(std::string_view text) {
+  for (size_t i = text.size(); i > 0; --i) {
+    if (!isSpace(text[i - 1])) {
+      return i - 1;
+    }
+  }
+  return npos;
+}
+
+size_t findScalar(std::string_view haystack, std::string_view needle,
+                  size_t from) {
+  return haystack.find(needle, from);
+}
+
+// Appends the matches at or after `from` that do not overlap
+void findAllScalar(std::string_view haystack, std::string_view needle,
+                   std::vector<size_t> &positions, size_t from = 0) {
+  for (size_t pos = haystack.find(needle, from); pos != npos;
+       pos = haystack.find(needle, pos + needle.size())) {
+    positions.push_back(pos);
+  }
+}
+
+void byteMasksScalar(const char *data, size_t blocks, std::string_view chars,
+                     uint64_t *masks) {
+  // slot[byte] is one past the index of the byte in chars, or 0
+  uint8_t slot[256] = {};
+  for (size_t k = chars.size(); k-- > 0;) {
+    slot[static_cast<unsigned char>(chars[k])] = static_cast<uint8_t>(k + 1);
+  }
+  for (size_t b = 0; b < blocks; ++b, data += 64, masks += chars.size()) {
+    uint64_t local[kMaxMaskChars + 1] = {};
+    for (unsigned i = 0; i < 64; ++i) {
+      local[slot[static_cast<unsigned char>(data[i])]] |= uint64_t{1} << i;
+    }
+    std::copy(local + 1, local + 1 + chars.size(), masks);
+  }
+}
+
+#ifdef DOTLIN_HAVE_SSE2
+// ---- SSE2: 16 bytes per step ----
+
+__m128i load16(const char *p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+template <char Lo, char Hi>
+void flipCaseSse2(const char *in, char *out, size_t n) {
+  // Signed compares leave bytes >= 0x80 (negative) untouched
+  const __m128i lo = _mm_set1_epi8(Lo - 1);
+  const __m128i hi = _mm_set1_epi8(Hi + 1);
+  const __m128i bit = _mm_set1_epi8(0x20);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = load16(in + i);
+    __m128i letter =
+        _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                     _mm_xor_si128(v, _mm_and_si128(letter, bit)));
+  }
+  flipCaseScalar<Lo, Hi>(in + i, out + i, n - i);
+}
+
+// Bit i is set when byte i is whitespace
+uint32_t spaceMaskSse2(__m128i v) {
+  __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+  __m128i control = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('\t' - 1)),
+                                  _mm_cmplt_epi8(v, _mm_set1_epi8('\r' + 1)));
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(space, control)));
+}
+
+size_t firstNonWhitespaceSse2(std::string_view text) {
+  size_t i = 0;
+  for (; i + 16 <= text.size(); i += 16) {
+    uint32_t other = ~spaceMaskSse2(load16(text.data() + i)) & 0xffff;
+    if (other != 0) {
+      return i + static_cast<size_t>(std::countr_zero(other));
+    }
+  }
+  return firstNonWhitespaceScalar(text, i);
+}
+
+size_t lastNonWhitespaceSse2(std::string_view text) {
+  size_t end = text.size();
+  for (; end >= 16; end -= 16) {
+    uint32_t other = ~spaceMaskSse2(load16(text.data() + end - 16)) & 0xffff;
+    if (other != 0) {
+      return end - 17 + static_cast<size_t>(std::bit_width(other));
+    }
+  }
+  return lastNonWhitespaceScalar(text.substr(0, end));
+}
+
+// Candidates are positions where both the first and the last byte of the
+// needle match; only those are compared in full
+size_t findSse2(std::string_view haystack, std::string_view needle,
+                size_t from) {
+  size_t k = needle.size();
+  const __m128i first = _mm_set1_epi8(needle.front());
+  const __m128i last = _mm_set1_epi8(needle.back());
+  size_t i = from;
+  for (; i + k - 1 + 16 <= haystack.size(); i += 16) {
+    __m128i head = _mm_cmpeq_epi8(load16(haystack.data() + i), first);
+    __m128i tail = _mm_cmpeq_epi8(load16(haystack.data() + i + k - 1), last);
+    auto mask =
+        static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(head, tail)));
+    for (; mask != 0; mask &= mask - 1) {
+      size_t pos = i + static_cast<size_t>(std::countr_zero(mask));
+      if (std::memcmp(haystack.data() + pos + 1, needle.data() + 1, k - 2) ==
+          0) {
+        return pos;
+      }
+    }
+  }
+  return haystack.find(needle, i);
+}
+
+// Like findSse2, but keeps going after a match instead of restarting, which
+// matters when delimiters are only a few bytes apart
+void findAllSse2(std::string_view haystack, std::string_view needle,
+                 std::vector<size_t> &positions) {
+  size_t k = needle.size();
+  const __m128i first = _mm_set1_epi8(needle.front());
+  const __m128i last = _mm_set1_epi8(needle.back());
+  size_t next = 0; // no match may start before this
+  size_t i = 0;
+  for (; i + k - 1 + 16 <= haystack.size(); i += 16) {
+    __m128i head = _mm_cmpeq_epi8(load16(haystack.data() + i), first);
+    __m128i tail = _mm_cmpeq_epi8(load16(haystack.data() + i + k - 1), last);
+    auto mask =
+        static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(head, tail)));
+    for (; mask != 0; mask &= mask - 1) {
+      size_t pos = i + static_cast<size_t>(std::countr_zero(mask));
+      if (pos >= next &&
+          (k < 3 || std::memcmp(haystack.data() + pos + 1, needle.data() + 1,
+                                k - 2) == 0)) {
+        positions.push_back(pos);
+        next = pos + k;
+      }
+    }
+  }
+  findAllScalar(haystack, needle, positions, std::max(i, next));
+}
+
+uint64_t equalMask16(__m128i v, __m128i c) {
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, c)));
+}
+
+void byteMasksSse2(const char *data, size_t blocks, std::string_view chars,
+                   uint64_t *masks) {
+  for (size_t b = 0; b < blocks; ++b, data += 64, masks += chars.size()) {
+    const __m128i v0 = load16(data);
+    const __m128i v1 = load16(data + 16);
+    const __m128i v2 = load16(data + 32);
+    const __m128i v3 = load16(data + 48);
+    for (size_t k = 0; k < chars.size(); ++k) {
+      const __m128i c = _mm_set1_epi8(chars[k]);
+      masks[k] = equalMask16(v3, c) << 48 | equalMask16(v2, c) << 32 |
+                 equalMask16(v1, c) << 16 | equalMask16(v0, c);
+    }
+  }
+}
+#endif
+
+#ifdef DOTLIN_HAVE_AVX2
+// ---- AVX2: 32 bytes per step, same algorithms ----
+
+DOTLIN_TARGET_AVX2 __m256i load32(const char *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+template <char Lo, char Hi>
+DOTLIN_TARGET_AVX2 void flipCaseAvx2(const char *in, char *out, size_t n) {
+  const __m256i lo = _mm256_set1_epi8(Lo - 1);
+  const __m256i hi = _mm256_set1_epi8(Hi + 1);
+  const __m256i bit = _mm256_set1_epi8(0x20);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = load32(in + i);
+    __m256i letter =
+        _mm256_and_si256(_mm256_cmpgt_epi8(v, lo), _mm256_cmpgt_epi8(hi, v));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                        _mm256_xor_si256(v, _mm256_and_si256(letter, bit)));
+  }
+  flipCaseScalar<Lo, Hi>(in + i, out + i, n - i);
+}
+
+DOTLIN_TARGET_AVX2 uint32_t spaceMaskAvx2(__m256i v) {
+  __m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+  __m256i control =
+      _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('\t' - 1)),
+                       _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), v));
+  return static_cast<uint32_t>(
+      _mm256_movemask_epi8(_mm256_or_si256(space, control)));
+}
+
+DOTLIN_TARGET_AVX2 size_t firstNonWhitespaceAvx2(std::string_view text) {
+  size_t i = 0;
+  for (; i + 32 <= text.size(); i += 32) {
+    uint32_t other = ~spaceMaskAvx2(load32(text.data() + i));
+    if (other != 0) {
+      return i + static_cast<size_t>(std::countr_zero(other));
+    }
+  }
+  return firstNonWhitespaceScalar(text, i);
+}
+
+DOTLIN_TARGET_AVX2 size_t lastNonWhitespaceAvx2(std::string_view text) {
+  size_t end = text.size();
+  for (; end >= 32; end -= 32) {
+    uint32_t other = ~spaceMaskAvx2(load32(text.data() + end - 32));
+    if (other != 0) {
+      return end - 33 + static_cast<size_t>(std::bit_width(other));
+    }
+  }
+  return lastNonWhitespaceScalar(text.substr(0, end));
+}
+
+DOTLIN_TARGET_AVX2 size_t findAvx2(std::string_view haystack,
+                                   std::string_view needle, size_t from) {
+  size_t k = needle.size();
+  const __m256i first = _mm256_set1_epi8(needle.front());
+  const __m256i last = _mm256_set1_epi8(needle.back());
+  size_t i = from;
+  for (; i + k - 1 + 32 <= haystack.size(); i += 32) {
+    __m256i head = _mm256_cmpeq_epi8(load32(haystack.data() + i), first);
+    __m256i tail =
+        _mm256_cmpeq_epi8(load32(haystack.data() + i + k - 1), last);
+    auto mask = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_and_si256(head, tail)));
+    for (; mask != 0; mask &= mask - 1) {
+      size_t pos = i + static_cast<size_t>(std::countr_zero(mask));
+      if (std::memcmp(haystack.data() + pos + 1, needle.data() + 1, k - 2) ==
+          0) {
+        return pos;
+      }
+    }
+  }
+  return haystack.find(needle, i);
+}
+
+DOTLIN_TARGET_AVX2 void findAllAvx2(std::string_view haystack,
+                                    std::string_view needle,
+                                    std::vector<size_t> &positions) {
+  size_t k = needle.size();
+  const __m256i first = _mm256_set1_epi8(needle.front());
+  const __m256i last = _mm256_set1_epi8(needle.back());
+  size_t next = 0;
+  size_t i = 0;
+  for (; i + k - 1 + 32 <= haystack.size(); i += 32) {
+    __m256i head = _mm256_cmpeq_epi8(load32(haystack.data() + i), first);
+    __m256i tail =
+        _mm256_cmpeq_epi8(load32(haystack.data() + i + k - 1), last);
+    auto mask = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_and_si256(head, tail)));
+    for (; mask != 0; mask &= mask - 1) {
+      size_t pos = i + static_cast<size_t>(std::countr_zero(mask));
+      if (pos >= next &&
+          (k < 3 || std::memcmp(haystack.data() + pos + 1, needle.data() + 1,
+                                k - 2) == 0)) {
+        positions.push_back(pos);
+        next = pos + k;
+      }
+    }
+  }
+  findAllScalar(haystack, needle, positions, std::max(i, next));
+}
+#endif
+
+#ifdef DOTLIN_HAVE_AVX2
+DOTLIN_TARGET_AVX2 void byteMasksAvx2(const char *data, size_t blocks,
+                                      std::string_view chars,
+                                      uint64_t *masks) {
+  for (size_t b = 0; b < blocks; ++b, data += 64, masks += chars.size()) {
+    const __m256i lo = load32(data);
+    const __m256i hi = load32(data + 32);
+    for (size_t k = 0; k < chars.size(); ++k) {
+      const __m256i c = _mm256_set1_epi8(chars[k]);
+      auto low = static_cast<uint32_t>(
+          _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, c)));
+      auto high = static_cast<uint32_t>(
+          _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, c)));
+      masks[k] = static_cast<uint64_t>(high) << 32 | low;
+    }
+  }
+}
+#endif
+
+// ---- Dispatch ----
+
+struct KernelTable {
+  void (*toUpper)(const char *, char *, size_t);
+  void (*toLower)(const char *, char *, size_t);
+  size_t (*firstNonWhitespace)(std::string_view);
+  size_t (*lastNonWhitespace)(std::string_view);
+  size_t (*find)(std::string_view, std::string_view, size_t);
+  void (*findAll)(std::string_view, std::string_view, std::vector<size_t> &);
+  void (*byteMasks)(const char *, size_t, std::string_view, uint64_t *);
+};
+
+const KernelTable kScalarKernels{
+    flipCaseScalar<'a', 'z'>, flipCaseScalar<'A', 'Z'>,
+    [](std::string_view text) { return firstNonWhitespaceScalar(text); },
+    lastNonWhitespaceScalar, findScalar,
+    [](std::string_view haystack, std::string_view needle,
+       std::vector<size_t> &positions) {
+      findAllScalar(haystack, needle, positions);
+    },
+    byteMasksScalar};
+#ifdef DOTLIN_HAVE_SSE2
+const KernelTable kSse2Kernels{flipCaseSse2<'a', 'z'>, flipCaseSse2<'A', 'Z'>,
+                               firstNonWhitespaceSse2, lastNonWhitespaceSse2,
+                               findSse2, findAllSse2, byteMasksSse2};
+#endif
+#ifdef DOTLIN_HAVE_AVX2
+const KernelTable kAvx2Kernels{flipCaseAvx2<'a', 'z'>, flipCaseAvx2<'A', 'Z'>,
+                               firstNonWhitespaceAvx2, lastNonWhitespaceAvx2,
+                               findAvx2, findAllAvx2, byteMasksAvx2};
+#endif
+
+std::atomic<StringKernelLevel> &currentLevel() {
+  static std::atomic<StringKernelLevel> level{bestStringKernelLevel()};
+  return level;
+}
+
+const KernelTable &kernels() {
+  switch (currentLevel().load(std::memory_order_relaxed)) {
+#ifdef DOTLIN_HAVE_AVX2
+  case StringKernelLevel::AVX2:
+    return kAvx2Kernels;
+#endif
+#ifdef DOTLIN_HAVE_SSE2
+  case StringKernelLevel::SSE2:
+    return kSse2Kernels;
+#endif
+  default:
+    return kScalarKernels;
+  }
+}
+
+} // namespace
+
+StringKernelLevel bestStringKernelLevel() {
+#ifdef DOTLIN_HAVE_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    return StringKernelLevel::AVX2;
+  }
+#endif
+#ifdef DOTLIN_HAVE_SSE2
+  return StringKernelLevel::SSE2;
+#else
+  return StringKernelLevel::Scalar;
+#endif
+}
+
+StringKernelLevel stringKernelLevel() {
+  return currentLevel().load(std::memory_order_relaxed);
+}
+
+void setStringKernelLevel(StringKernelLevel level) {
+  StringKernelLevel best = bestStringKernelLevel();
+  currentLevel().store(level < best ? level : best,
+                       std::memory_order_relaxed);
+}
+
+const char *stringKernelLevelName(StringKernelLevel level) {
+  switch (level) {
+  case StringKernelLevel::AVX2:
+    return "avx2";
+  case StringKernelLevel::SSE2:
+    return "sse2";
+  default:
+    return "scalar";
+  }
+}
+
+void asciiToUpper(const char *in, char *out, size_t n) {
+  kernels().toUpper(in, out, n);
+}
+
+void asciiToLower(const char *in, char *out, size_t n) {
+  kernels().toLower(in, out, n);
+}
+
+size_t firstNonWhitespace(std::string_view text) {
+  return kernels().firstNonWhitespace(text);
+}
+
+size_t lastNonWhitespace(std::string_view text) {
+  return kernels().lastNonWhitespace(text);
+}
+
+size_t findSubstring(std::string_view haystack, std::string_view needle,
+                     size_t from) {
+  if (from > haystack.size() || needle.size() > haystack.size() - from) {
+    return npos;
+  }
+  // Empty and single-byte needles go straight to the library, whose memchr
+  // is already vectorised
+  if (needle.size() < 2) {
+    return haystack.find(needle, from);
+  }
+  return kernels().find(haystack, needle, from);
+}
+
+void findAllSubstrings(std::string_view haystack, std::string_view needle,
+                       std::vector<size_t> &positions) {
+  if (!needle.empty()) {
+    kernels().findAll(haystack, needle, positions);
+  }
+}
+
+void byteMasks64(const char *data, size_t blocks, std::string_view chars,
+                 uint64_t *masks) {
+  kernels().byteMasks(data, blocks, chars, masks);
+}
+
+} // namespace dotlin
@@ -0,0 +1,130 @@
+#include "dotlin/thread_pool.h"
+#include <exception>
+
+namespace dotlin {
+
+ThreadPool::ThreadPool(size_t threads) {
+  if (threads == 0) {
+    threads = 1;
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    queues.push_back(std::make_unique<Queue>());
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    workers.emplace_back([this, i] { workerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+ThreadPool &ThreadPool::instance() {
+  static ThreadPool pool(std::thread::hardware_concurrency());
+  return pool;
+}
+
+bool ThreadPool::runOne(size_t self) {
+  std::function<void()> task;
+  size_t n = queues.size();
+  for (size_t k = 0; k < n && !task; ++k) {
+    size_t victim = (self + k) % n;
+    Queue &queue = *queues[victim];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      continue;
+    }
+    if (k == 0) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+  }
+  if (!task) {
+    return false;
+  }
+  queued.fetch_sub(1);
+  task();
+  return true;
+}
+
+void ThreadPool::workerLoop(size_t self) {
+  while (true) {
+    if (runOne(self)) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+    if (stopping) {
+      return;
+    }
+  }
+}
+
+void ThreadPool::parallelFor(size_t count,
+                             const std::function<void(size_t)> &task) {
+  if (count == 0) {
+    return;
+  }
+
+  struct Batch {
+    std::atomic<size_t> remaining;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+  };
+  auto batch = std::make_shared<Batch>();
+  batch->remaining = count;
+
+  for (size_t i = 0; i < count; ++i) {
+    Queue &queue = *queues[i % queues.size()];
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.push_back([batch, &task, i] {
+        try {
+          task(i);
+        } catch (...) {
+          std::lock_guard<std::mutex> errorLock(batch->mutex);
+          if (!batch->error) {
+            batch->error = std::current_exception();
+          }
+        }
+        if (batch->remaining.fetch_sub(1) == 1) {
+          std::lock_guard<std::mutex> doneLock(batch->mutex);
+          batch->done.notify_all();
+        }
+      });
+    }
+    queued.fetch_add(1);
+  }
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+  }
+  wake.notify_all();
+
+  // Help out instead of blocking; sleep only once nothing is left to steal
+  while (batch->remaining.load() > 0) {
+    if (runOne(0)) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->done.wait(lock, [&] {
+      return batch->remaining.load() == 0 || queued.load() > 0;
+    });
+  }
+
+  if (batch->error) {
+    std::rethrow_exception(batch->error);
+  }
+}
+
+} // namespace dotlin
@@ -0,0 +1,74 @@
+#include "dotlin/trace.h"
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+
+namespace dotlin {
+
+std::array<TraceLevel, kTraceCategoryCount> traceLevels{};
+
+namespace {
+
+const char *const categoryNames[kTraceCategoryCount] = {
+    "lexer", "parser", "typecheck", "optimize", "resolve", "exec"};
+
+TraceLevel parseLevel(const std::string &name) {
+  if (name == "off") {
+    return TraceLevel::Off;
+  } else if (name == "warn") {
+    return TraceLevel::Warn;
+  } else if (name == "info") {
+    return TraceLevel::Info;
+  } else if (name == "debug") {
+    return TraceLevel::Debug;
+  }
+  throw std::runtime_error("Unknown log level: " + name +
+                           " (expected off, warn, info or debug)");
+}
+
+void applyEntry(const std::string &entry) {
+  size_t colon = entry.find(':');
+  std::string category = entry.substr(0, colon);
+  TraceLevel level = colon == std::string::npos
+                         ? TraceLevel::Debug
+                         : parseLevel(entry.substr(colon + 1));
+  if (category == "all") {
+    traceLevels.fill(level);
+    return;
+  }
+  for (size_t i = 0; i < kTraceCategoryCount; ++i) {
+    if (category == categoryNames[i]) {
+      traceLevels[i] = level;
+      return;
+    }
+  }
+  throw std::runtime_error("Unknown log category: " + category +
+                           " (expected all, lexer, parser, typecheck, "
+                           "optimize, resolve or exec)");
+}
+
+} // namespace
+
+void configureTracing(const std::string &spec) {
+  size_t start = 0;
+  while (start <= spec.size()) {
+    size_t comma = spec.find(',', start);
+    if (comma == std::string::npos) {
+      comma = spec.size();
+    }
+    if (comma > start) {
+      applyEntry(spec.substr(start, comma - start));
+    }
+    start = comma + 1;
+  }
+}
+
+void traceWrite(TraceCategory category, const std::string &message) {
+  // One lock so lines from worker threads never interleave
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::fprintf(stderr, "[%s] %s\n",
+               categoryNames[static_cast<size_t>(category)], message.c_str());
+}
+
+} // namespace dotlin
@@ -1,5 +1,6 @@
 #include "dotlin/interpreter.h"
 #include "dotlin/parser.h"
+#include "dotlin/trace.h"
 #include "dotlin/visitors.h"
 // #include <stdexcept>
 
@@ -253,6 +254,9 @@ void StmtTypeCheckVisitor::visit(VariableDeclStmt &node) {
     varType = std::make_shared<dotlin::Type>(dotlin::TypeKind::UNKNOWN);
   }
 
+  DOTLIN_TRACE(Typecheck, Debug, "variable '", node.name, "' at ", node.line,
+               ":", node.column, " has type ", typeToString(varType));
+
   // Store the variable type in the environment
   if (checker->typeEnvironment) {
     checker->typeEnvironment->define(node.name, varType);
@@ -268,6 +272,8 @@ void StmtTypeCheckVisitor::visit(FunctionDeclStmt &node) {
     returnType = std::make_shared<dotlin::Type>(TypeKind::VOID);
   }
 
+  DOTLIN_TRACE(Typecheck, Debug, "function '", node.name, "' at ", node.line,
+               ":", node.column, " returns ", typeToString(returnType));
   if (checker->typeEnvironment) {
     checker->typeEnvironment->define(node.name, returnType);
   }
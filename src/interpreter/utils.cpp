@@ -1,4 +1,8 @@
+#include "dotlin/collections.h"
+#include "dotlin/file_io.h"
 #include "dotlin/interpreter.h"
+#include "dotlin/number_format.h"
+#include "dotlin/string_builder.h"
 #include <string>
 #include <variant>
 
@@ -26,6 +30,19 @@ std::string getTypeOfValue(const Value &value) {
           return "Object";
         else if constexpr (std::is_same_v<T, std::shared_ptr<ClassDefinition>>)
           return "Class";
+        else if constexpr (std::is_same_v<T, std::shared_ptr<SequenceValue>>)
+          return "Sequence";
+        else if constexpr (std::is_same_v<T, std::shared_ptr<MapValue>>)
+          return "Map";
+        else if constexpr (std::is_same_v<T, std::shared_ptr<SetValue>>)
+          return "Set";
+        else if constexpr (std::is_same_v<T,
+                                          std::shared_ptr<StringBuilderValue>>)
+          return "StringBuilder";
+        else if constexpr (std::is_same_v<T, std::shared_ptr<FileValue>>)
+          return "File";
+        else if constexpr (std::is_same_v<T, std::shared_ptr<FileWriterValue>>)
+          return "FileWriter";
         else
           return "unknown";
       },
@@ -36,20 +53,21 @@ std::string valueToString(const Value &value) {
   return std::visit(
       [](auto &&arg) -> std::string {
         using T = std::decay_t<decltype(arg)>;
-        if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>)
-          return std::to_string(arg);
-        else if constexpr (std::is_floating_point_v<T>)
-          return std::to_string(arg);
-        else if constexpr (std::is_same_v<T, bool>)
+        if constexpr (std::is_same_v<T, int> || std::is_same_v<T, int64_t> ||
+                      std::is_same_v<T, double>) {
+          std::string out;
+          appendNumber(out, arg);
+          return out;
+        } else if constexpr (std::is_same_v<T, bool>)
           return arg ? "true" : "false";
         else if constexpr (std::is_same_v<T, std::string>)
           return arg;
         else if constexpr (std::is_same_v<T, ArrayValue>) {
           std::string result = "[";
-          for (size_t i = 0; i < arg.elements->size(); ++i) {
+          for (size_t i = 0; i < arg.size(); ++i) {
             if (i > 0)
               result += ", ";
-            result += valueToString((*arg.elements)[i]);
+            result += valueToString(arg.at(i));
           }
           result += "]";
           return result;
@@ -59,12 +77,39 @@ std::string valueToString(const Value &value) {
           return arg->className + " instance";
         else if constexpr (std::is_same_v<T, std::shared_ptr<ClassDefinition>>)
           return arg->name + " class";
+        else if constexpr (std::is_same_v<T, std::shared_ptr<SequenceValue>>)
+          return "<sequence>";
+        else if constexpr (std::is_same_v<T, std::shared_ptr<MapValue>>)
+          return mapToString(*arg);
+        else if constexpr (std::is_same_v<T, std::shared_ptr<SetValue>>)
+          return setToString(*arg);
+        else if constexpr (std::is_same_v<T,
+                                          std::shared_ptr<StringBuilderValue>>)
+          return arg->buffer;
+        else if constexpr (std::is_same_v<T, std::shared_ptr<FileValue>>)
+          return arg->path;
+        else if constexpr (std::is_same_v<T, std::shared_ptr<FileWriterValue>>)
+          return "FileWriter(" + arg->path() + ")";
         else
           return "null";
       },
       value);
 }
 
+void appendValueString(std::string &out, const Value &value) {
+  if (auto *str = std::get_if<std::string>(&value)) {
+    out += *str;
+  } else if (auto *i = std::get_if<int>(&value)) {
+    appendNumber(out, *i);
+  } else if (auto *l = std::get_if<int64_t>(&value)) {
+    appendNumber(out, *l);
+  } else if (auto *d = std::get_if<double>(&value)) {
+    appendNumber(out, *d);
+  } else {
+    out += valueToString(value);
+  }
+}
+
 std::string typeToString(const std::shared_ptr<Type> &type) {
   if (!type)
     return "unknown";
@@ -134,13 +179,23 @@ bool valuesEqual(const Value &v1, const Value &v2) {
         const T &arg2 = std::get<T>(v2);
 
         if constexpr (std::is_same_v<T, ArrayValue>) {
-          if (arg1.elements->size() != arg2.elements->size())
+          if (arg1.size() != arg2.size())
             return false;
-          for (size_t i = 0; i < arg1.elements->size(); ++i) {
-            if (!valuesEqual((*arg1.elements)[i], (*arg2.elements)[i]))
+          // Unboxed stores of the same kind compare without boxing
+          if ((arg1.ints() && arg2.ints()) ||
+              (arg1.doubles() && arg2.doubles()) ||
+              (arg1.bools() && arg2.bools()) ||
+              (arg1.longs() && arg2.longs()))
+            return Value(arg1) == Value(arg2);
+          for (size_t i = 0; i < arg1.size(); ++i) {
+            if (!valuesEqual(arg1.at(i), arg2.at(i)))
               return false;
           }
           return true;
+        } else if constexpr (std::is_same_v<T, std::shared_ptr<MapValue>>) {
+          return arg1 == arg2 || mapsEqual(*arg1, *arg2);
+        } else if constexpr (std::is_same_v<T, std::shared_ptr<SetValue>>) {
+          return arg1 == arg2 || setsEqual(*arg1, *arg2);
         } else {
           return arg1 == arg2;
         }
@@ -1,5 +1,6 @@
 // src/lexer.cpp
 #include "dotlin/lexer.h"
+#include "dotlin/trace.h"
 #include <cctype>
 // #include <sstream>
 
@@ -482,6 +483,15 @@ std::vector<Token> tokenize(const std::string &src) {
     filtered_tokens.push_back(token);
   }
 
+  DOTLIN_TRACE(Lexer, Info, filtered_tokens.size(), " tokens from ",
+               src.size(), " bytes");
+  if (DOTLIN_TRACE_ENABLED(Lexer, Debug)) {
+    for (const auto &token : filtered_tokens) {
+      traceMessage(TraceCategory::Lexer, token.line, ":", token.column,
+                   " type ", static_cast<int>(token.type), " '", token.text,
+                   "'");
+    }
+  }
   return filtered_tokens;
 }
 
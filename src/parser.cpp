@@ -1,8 +1,9 @@
 // src/parser.cpp
 #include "dotlin/parser.h"
+#include "dotlin/trace.h"
 #include <cstring>
 // #include <iostream>
-// #include <stdexcept>
+#include <stdexcept>
 
 namespace dotlin {
 
@@ -66,10 +67,14 @@ Program parse(const std::vector<Token> &tokens) {
     } else if (pos == oldPos) {
       // If we couldn't parse a statement AND didn't advance, advance to avoid
       // infinite loop
+      DOTLIN_TRACE(Parser, Warn, "skipped token '", tokens[pos].text, "' at ",
+                   tokens[pos].line, ":", tokens[pos].column);
       pos++;
     }
   }
 
+  DOTLIN_TRACE(Parser, Info, program.statements.size(),
+               " top-level statements");
   return program;
 }
 
@@ -79,9 +84,8 @@ std::unique_ptr<Statement> parseStatement(const std::vector<Token> &tokens,
     return nullptr;
 
   if (tokens[pos].type != TokenType::SEMICOLON) {
-    // std::cout << "[PARSER DEBUG] Statement at line " << tokens[pos].line << "
-    // starts with token: " << tokens[pos].text << " (type " <<
-    // (int)tokens[pos].type << ")" << std::endl;
+    DOTLIN_TRACE(Parser, Debug, "statement at ", tokens[pos].line, ":",
+                 tokens[pos].column, " starts with '", tokens[pos].text, "'");
   }
 
   switch (tokens[pos].type) {
@@ -216,10 +220,94 @@ std::unique_ptr<Expression> parseExpression(const std::vector<Token> &tokens,
   return parseAssignmentExpression(tokens, pos);
 }
 
+// Copy of an assignment target for desugaring compound assignment. Only the
+// side-effect-free shapes a target can take are supported; null otherwise.
+static std::unique_ptr<Expression> cloneTarget(const Expression *expr) {
+  if (auto *ident = dynamic_cast<const IdentifierExpr *>(expr)) {
+    return std::make_unique<IdentifierExpr>(ident->name, ident->line,
+                                            ident->column);
+  }
+  if (auto *literal = dynamic_cast<const LiteralExpr *>(expr)) {
+    return std::make_unique<LiteralExpr>(literal->value, literal->line,
+                                         literal->column);
+  }
+  if (auto *member = dynamic_cast<const MemberAccessExpr *>(expr)) {
+    auto object = cloneTarget(member->object.get());
+    if (!object) {
+      return nullptr;
+    }
+    return std::make_unique<MemberAccessExpr>(
+        std::move(object), member->property, member->line, member->column);
+  }
+  if (auto *access = dynamic_cast<const ArrayAccessExpr *>(expr)) {
+    auto array = cloneTarget(access->array.get());
+    auto index = cloneTarget(access->index.get());
+    if (!array || !index) {
+      return nullptr;
+    }
+    return std::make_unique<ArrayAccessExpr>(std::move(array), std::move(index),
+                                             access->line, access->column);
+  }
+  if (auto *binary = dynamic_cast<const BinaryExpr *>(expr)) {
+    auto lhs = cloneTarget(binary->left.get());
+    auto rhs = cloneTarget(binary->right.get());
+    if (!lhs || !rhs || binary->op == TokenType::ASSIGN) {
+      return nullptr;
+    }
+    return std::make_unique<BinaryExpr>(std::move(lhs), binary->op,
+                                        std::move(rhs), binary->line,
+                                        binary->column);
+  }
+  return nullptr;
+}
+
 std::unique_ptr<Expression>
 parseAssignmentExpression(const std::vector<Token> &tokens, size_t &pos) {
   auto left = parseLogicalOrExpression(tokens, pos);
 
+  // Compound assignment: `a op= b` is parsed as `a = a op b`
+  if (pos < tokens.size() && left &&
+      (tokens[pos].type == TokenType::PLUS_ASSIGN ||
+       tokens[pos].type == TokenType::MINUS_ASSIGN ||
+       tokens[pos].type == TokenType::MULTIPLY_ASSIGN ||
+       tokens[pos].type == TokenType::DIVIDE_ASSIGN ||
+       tokens[pos].type == TokenType::MODULO_ASSIGN)) {
+    const Token &opToken = tokens[pos];
+    TokenType op = TokenType::MODULO;
+    switch (opToken.type) {
+    case TokenType::PLUS_ASSIGN:
+      op = TokenType::PLUS;
+      break;
+    case TokenType::MINUS_ASSIGN:
+      op = TokenType::MINUS;
+      break;
+    case TokenType::MULTIPLY_ASSIGN:
+      op = TokenType::MULTIPLY;
+      break;
+    case TokenType::DIVIDE_ASSIGN:
+      op = TokenType::DIVIDE;
+      break;
+    default:
+      break;
+    }
+    auto current = cloneTarget(left.get());
+    if (!current) {
+      throw std::runtime_error("Unsupported target for '" + opToken.text +
+                               "' at line " + std::to_string(opToken.line));
+    }
+    pos++; // consume operator
+    auto right = parseAssignmentExpression(tokens, pos);
+    if (right) {
+      auto value = std::make_unique<BinaryExpr>(std::move(current), op,
+                                                std::move(right), opToken.line,
+                                                opToken.column);
+      left = std::make_unique<BinaryExpr>(std::move(left), TokenType::ASSIGN,
+                                          std::move(value), opToken.line,
+                                          opToken.column);
+    }
+    return left;
+  }
+
   // Check for assignment operator
   if (pos < tokens.size() && tokens[pos].type == TokenType::ASSIGN) {
     TokenType op = tokens[pos].type;
@@ -273,7 +361,7 @@ parseLogicalAndExpression(const std::vector<Token> &tokens, size_t &pos) {
 
 std::unique_ptr<Expression>
 parseComparisonExpression(const std::vector<Token> &tokens, size_t &pos) {
-  auto left = parseAdditiveExpression(tokens, pos);
+  auto left = parseInfixCallExpression(tokens, pos);
 
   while (pos < tokens.size() &&
          (tokens[pos].type == TokenType::EQUAL ||
@@ -284,7 +372,7 @@ parseComparisonExpression(const std::vector<Token> &tokens, size_t &pos) {
           tokens[pos].type == TokenType::GREATER_EQUAL)) {
     TokenType op = tokens[pos].type;
     pos++; // consume operator
-    auto right = parseAdditiveExpression(tokens, pos);
+    auto right = parseInfixCallExpression(tokens, pos);
     if (right) {
       left = std::make_unique<BinaryExpr>(std::move(left), op, std::move(right),
                                           tokens[pos - 2].line,
@@ -295,6 +383,31 @@ parseComparisonExpression(const std::vector<Token> &tokens, size_t &pos) {
   return left;
 }
 
+std::unique_ptr<Expression>
+parseInfixCallExpression(const std::vector<Token> &tokens, size_t &pos) {
+  auto left = parseAdditiveExpression(tokens, pos);
+
+  // Infix function call: `key to value` becomes to(key, value). Only `to`
+  // is recognised, and only on the same line as its left operand.
+  while (pos < tokens.size() && tokens[pos].type == TokenType::IDENTIFIER &&
+         tokens[pos].text == "to" && tokens[pos].line == tokens[pos - 1].line) {
+    size_t line = tokens[pos].line;
+    size_t col = tokens[pos].column;
+    pos++; // consume 'to'
+    auto right = parseAdditiveExpression(tokens, pos);
+    if (right) {
+      std::vector<Expression::Ptr> arguments;
+      arguments.push_back(std::move(left));
+      arguments.push_back(std::move(right));
+      left = std::make_unique<CallExpr>(
+          std::make_unique<IdentifierExpr>("to", line, col),
+          std::move(arguments), line, col);
+    }
+  }
+
+  return left;
+}
+
 std::unique_ptr<Expression>
 parseAdditiveExpression(const std::vector<Token> &tokens, size_t &pos) {
   auto left = parseMultiplicativeExpression(tokens, pos);
@@ -386,6 +499,22 @@ parsePostfixExpression(const std::vector<Token> &tokens, size_t &pos) {
         expr = std::make_unique<MemberAccessExpr>(std::move(expr), property,
                                                   line, col);
       }
+    } else if (tokens[pos].type == TokenType::LBRACE && pos > 0 &&
+               tokens[pos].line == tokens[pos - 1].line &&
+               (dynamic_cast<CallExpr *>(expr.get()) ||
+                dynamic_cast<MemberAccessExpr *>(expr.get()))) {
+      // Trailing lambda: f(x) { ... } or obj.method { ... }
+      auto lambda = parseLambdaExpression(tokens, pos);
+      if (auto *call = dynamic_cast<CallExpr *>(expr.get())) {
+        call->arguments.push_back(std::move(lambda));
+      } else {
+        size_t line = lambda->line;
+        size_t col = lambda->column;
+        std::vector<Expression::Ptr> arguments;
+        arguments.push_back(std::move(lambda));
+        expr = std::make_unique<CallExpr>(std::move(expr), std::move(arguments),
+                                          line, col);
+      }
     } else if (tokens[pos].type == TokenType::LBRACKET) {
       // Array access
       pos++; // consume '['